@@ -29,6 +29,7 @@
 #include <mutex>
 #include <numeric>
 #include <thread>
+#include <tuple>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -48,6 +49,11 @@
 #include "opthelpers.h"
 
 
+/* This is a user config option for letting effect slots with the same effect,
+ * gain, and target share one effect state.
+ */
+bool EffectSlotInstancing = false;
+
 namespace {
 
 inline ALeffectslot *LookupEffectSlot(ALCcontext *context, ALuint id) noexcept
@@ -77,6 +83,69 @@ inline ALeffect *LookupEffect(ALCdevice *device, ALuint id) noexcept
 }
 
 
+/* Checks if two sets of properties for the given effect type are the same,
+ * letting slots with them share one effect state. Slots sharing a state have
+ * their inputs summed before it's processed, so this is only done for linear
+ * effects; nonlinear ones (e.g. distortion, compressor, autowah, pitch
+ * shifter) never match. This compares the type's fields by value, since the
+ * union can hold stale bytes from other effect types, along with padding.
+ */
+bool SameEffectProps(ALenum type, const EffectProps &a, const EffectProps &b) noexcept
+{
+    switch(type)
+    {
+    case AL_EFFECT_EAXREVERB:
+    case AL_EFFECT_REVERB:
+    {
+        auto fields = [](const EffectProps &props) noexcept
+        {
+            const auto &r = props.Reverb;
+            return std::tie(r.Density, r.Diffusion, r.Gain, r.GainHF, r.DecayTime,
+                r.DecayHFRatio, r.ReflectionsGain, r.ReflectionsDelay, r.LateReverbGain,
+                r.LateReverbDelay, r.AirAbsorptionGainHF, r.RoomRolloffFactor, r.DecayHFLimit,
+                r.GainLF, r.DecayLFRatio, r.EchoTime, r.EchoDepth, r.ModulationTime,
+                r.ModulationDepth, r.HFReference, r.LFReference);
+        };
+        return fields(a) == fields(b)
+            && std::equal(std::begin(a.Reverb.ReflectionsPan), std::end(a.Reverb.ReflectionsPan),
+                std::begin(b.Reverb.ReflectionsPan))
+            && std::equal(std::begin(a.Reverb.LateReverbPan), std::end(a.Reverb.LateReverbPan),
+                std::begin(b.Reverb.LateReverbPan));
+    }
+    case AL_EFFECT_CHORUS:
+    case AL_EFFECT_FLANGER:
+    {
+        auto fields = [](const EffectProps &props) noexcept
+        {
+            const auto &p = props.Chorus;
+            return std::tie(p.Waveform, p.Phase, p.Rate, p.Depth, p.Feedback, p.Delay);
+        };
+        return fields(a) == fields(b);
+    }
+    case AL_EFFECT_ECHO:
+    {
+        auto fields = [](const EffectProps &props) noexcept
+        {
+            const auto &p = props.Echo;
+            return std::tie(p.Delay, p.LRDelay, p.Damping, p.Feedback, p.Spread);
+        };
+        return fields(a) == fields(b);
+    }
+    case AL_EFFECT_EQUALIZER:
+    {
+        auto fields = [](const EffectProps &props) noexcept
+        {
+            const auto &p = props.Equalizer;
+            return std::tie(p.LowCutoff, p.LowGain, p.Mid1Center, p.Mid1Gain, p.Mid1Width,
+                p.Mid2Center, p.Mid2Gain, p.Mid2Width, p.HighCutoff, p.HighGain);
+        };
+        return fields(a) == fields(b);
+    }
+    }
+    return false;
+}
+
+
 void AddActiveEffectSlots(const ALuint *slotids, size_t count, ALCcontext *context)
 {
     if(count < 1) return;
@@ -229,9 +298,25 @@ void FreeEffectSlot(ALCcontext *context, ALeffectslot *slot)
 }
 
 
+void ClearFreePropStates(ALCcontext *context)
+{
+    ALeffectslotProps *props{context->mFreeEffectslotProps.load()};
+    while(props)
+    {
+        if(props->State)
+            props->State->release();
+        props->State = nullptr;
+        props = props->next.load(std::memory_order_relaxed);
+    }
+}
+
+
 #define DO_UPDATEPROPS() do {                                                 \
     if(!context->mDeferUpdates.load(std::memory_order_acquire))               \
+    {                                                                         \
+        slot->updateInstance(context.get());                                  \
         slot->updateProps(context.get());                                     \
+    }                                                                         \
     else                                                                      \
         slot->PropsClean.clear(std::memory_order_release);                    \
 } while(0)
@@ -420,6 +505,7 @@ START_API_FUNC
             if(target) IncrementRef(target->ref);
             DecrementRef(oldtarget->ref);
             slot->Target = target;
+            slot->updateInstance(context.get());
             slot->updateProps(context.get());
             return;
         }
@@ -704,16 +790,97 @@ ALenum ALeffectslot::initEffect(ALeffect *effect, ALCcontext *context)
         Effect.Props = effect->Props;
 
     /* Remove state references from old effect slot property updates. */
-    ALeffectslotProps *props{context->mFreeEffectslotProps.load()};
-    while(props)
+    ClearFreePropStates(context);
+
+    return AL_NO_ERROR;
+}
+
+void ALeffectslot::updateInstance(ALCcontext *context)
+{
+    if(!EffectSlotInstancing)
+        return;
+
+    al::vector<ALeffectslot*> others;
+    for(auto &sublist : context->mEffectSlotList)
     {
-        if(props->State)
-            props->State->release();
-        props->State = nullptr;
-        props = props->next.load(std::memory_order_relaxed);
+        uint64_t usemask{~sublist.FreeMask};
+        while(usemask)
+        {
+            ALsizei idx{CTZ64(usemask)};
+            ALeffectslot *slot{sublist.EffectSlots + idx};
+            usemask &= ~(1_u64 << idx);
+
+            if(slot != this)
+                others.emplace_back(slot);
+        }
     }
 
-    return AL_NO_ERROR;
+    auto is_instance = [this](const ALeffectslot *slot) noexcept -> bool
+    {
+        return slot->Effect.Type == Effect.Type && slot->Gain == Gain && slot->Target == Target
+            && SameEffectProps(Effect.Type, slot->Effect.Props, Effect.Props);
+    };
+    /* A state can only be used by this slot if all other slots using it are
+     * instances of this one.
+     */
+    auto can_use = [&others,is_instance](const EffectState *state) -> bool
+    {
+        return std::all_of(others.cbegin(), others.cend(),
+            [state,is_instance](const ALeffectslot *slot) -> bool
+            { return slot->Effect.State != state || is_instance(slot); });
+    };
+    auto uses_state = [](const EffectState *state) noexcept
+    { return [state](const ALeffectslot *slot) noexcept { return slot->Effect.State == state; }; };
+
+    const bool shared{std::any_of(others.cbegin(), others.cend(), uses_state(Effect.State))};
+    if(shared && can_use(Effect.State))
+        return;
+
+    /* Look for another slot with the same effect, gain, and target to share
+     * the effect state of.
+     */
+    if(Effect.Type != AL_EFFECT_NULL)
+    {
+        auto match = std::find_if(others.cbegin(), others.cend(),
+            [this,is_instance,can_use](const ALeffectslot *slot) -> bool
+            {
+                return slot->Effect.State != Effect.State && is_instance(slot)
+                    && can_use(slot->Effect.State);
+            });
+        if(match != others.cend())
+        {
+            EffectState *state{(*match)->Effect.State};
+            state->add_ref();
+            Effect.State->release();
+            Effect.State = state;
+            ClearFreePropStates(context);
+            return;
+        }
+    }
+    if(!shared)
+        return;
+
+    /* Otherwise, this slot's properties no longer match those it's sharing
+     * the effect state with, so give it its own again.
+     */
+    EffectStateFactory *factory{getFactoryByType(Effect.Type)};
+    EffectState *State{factory ? factory->create() : nullptr};
+    if(!State)
+    {
+        ERR("Failed to create effect state for slot %u\n", id);
+        return;
+    }
+
+    ALCdevice *Device{context->mDevice.get()};
+    std::unique_lock<std::mutex> statelock{Device->StateLock};
+    State->mOutTarget = Device->Dry.Buffer;
+    {
+        FPUCtl mixer_mode{};
+        State->deviceUpdate(Device);
+    }
+
+    Effect.State->release();
+    Effect.State = State;
 }
 
 void ALeffectslot::updateProps(ALCcontext *context)
@@ -769,7 +936,10 @@ void UpdateAllEffectSlotProps(ALCcontext *context)
     for(ALeffectslot *slot : *auxslots)
     {
         if(!slot->PropsClean.test_and_set(std::memory_order_acq_rel))
+        {
+            slot->updateInstance(context);
             slot->updateProps(context);
+        }
     }
 }
 
@@ -20,6 +20,8 @@ struct ALeffectslot;
 
 using ALeffectslotArray = al::FlexArray<ALeffectslot*>;
 
+extern bool EffectSlotInstancing;
+
 
 struct ALeffectslotProps {
     float Gain;
@@ -64,6 +66,11 @@ struct ALeffectslot {
         EffectProps mEffectProps{};
         EffectState *mEffectState{nullptr};
 
+        /* The prior slot this one shares its effect state with, if any. Set by
+         * the mixer when sorting the slots.
+         */
+        ALeffectslot *InstanceOf{nullptr};
+
         float RoomRolloff{0.0f}; /* Added to the source's room rolloff, not multiplied. */
         float DecayTime{0.0f};
         float DecayLFRatio{0.0f};
@@ -92,6 +99,7 @@ struct ALeffectslot {
 
     ALenum init();
     ALenum initEffect(ALeffect *effect, ALCcontext *context);
+    void updateInstance(ALCcontext *context);
     void updateProps(ALCcontext *context);
 
     static ALeffectslotArray *CreatePtrArray(size_t count) noexcept;
@@ -35,6 +35,7 @@
 #include <mutex>
 #include <new>
 #include <numeric>
+#include <string>
 #include <utility>
 
 #include "AL/al.h"
@@ -43,14 +44,18 @@
 
 #include "albyte.h"
 #include "alcmain.h"
+#include "alconfig.h"
 #include "alcontext.h"
 #include "alexcpt.h"
 #include "almalloc.h"
 #include "alnumeric.h"
 #include "aloptional.h"
 #include "atomic.h"
+#include "event.h"
 #include "inprogext.h"
+#include "logging.h"
 #include "opthelpers.h"
+#include "threadpool.h"
 
 
 namespace {
@@ -403,10 +408,122 @@ const ALchar *NameFromUserFmtType(UserFmtType type)
     return "<internal type error>";
 }
 
+/** Converts the source samples to the storage format, into dst. */
+void ConvertData(al::byte *dst, const al::byte *SrcData, UserFmtType SrcType,
+    ALuint NumChannels, ALuint FrameSize, ALuint frames, ALuint align)
+{
+    if(SrcType == UserFmtIMA4)
+        Convert_int16_ima4(reinterpret_cast<int16_t*>(dst), SrcData, NumChannels, frames, align);
+    else if(SrcType == UserFmtMSADPCM)
+        Convert_int16_msadpcm(reinterpret_cast<int16_t*>(dst), SrcData, NumChannels, frames,
+            align);
+    else
+        std::copy_n(SrcData, frames*FrameSize, dst);
+}
+
+
+/* Holds the parameters of a pending asynchronous load, which runs on the
+ * loader thread pool.
+ */
+struct AsyncLoad {
+    ContextRef mContext;
+    ALbuffer *mBuffer;
+    const al::byte *mSrcData;
+
+    ALsizei mFreq;
+    ALuint mSize;
+    FmtChannels mDstChannels;
+    FmtType mDstType;
+    UserFmtType mSrcType;
+    ALuint mAlign;
+    ALuint mAmbiOrder;
+    ALuint mNumChannels;
+    ALuint mFrameSize;
+    ALuint mFrames;
+    size_t mNewSize;
+};
+
+std::once_flag LoadPoolOnce{};
+std::unique_ptr<al::ThreadPool> LoadPool;
+
+void StoreFormat(ALbuffer *ALBuf, ALsizei freq, ALuint size, FmtChannels DstChannels,
+    FmtType DstType, UserFmtType SrcType, ALuint align, ALuint ambiorder, ALuint frames,
+    ALbitfieldSOFT access)
+{
+    ALBuf->OriginalAlign = (SrcType == UserFmtIMA4 || SrcType == UserFmtMSADPCM) ? align : 1;
+    ALBuf->OriginalSize = size;
+    ALBuf->OriginalType = SrcType;
+
+    ALBuf->Frequency = static_cast<ALuint>(freq);
+    ALBuf->mFmtChannels = DstChannels;
+    ALBuf->mFmtType = DstType;
+    ALBuf->Access = access;
+    ALBuf->AmbiOrder = ambiorder;
+
+    ALBuf->Callback = nullptr;
+    ALBuf->UserData = nullptr;
+
+    ALBuf->SampleLen = frames;
+    ALBuf->LoopStart = 0;
+    ALBuf->LoopEnd = ALBuf->SampleLen;
+}
+
+void RunAsyncLoad(AsyncLoad &load)
+{
+    ALCcontext *context{load.mContext.get()};
+    ALCdevice *device{context->mDevice.get()};
+    ALbuffer *ALBuf{load.mBuffer};
+
+    /* Allocate and convert without holding the buffer lock, so other buffer
+     * calls aren't held up by it.
+     */
+    al::vector<al::byte,16> newdata;
+    ALenum result{AL_NO_ERROR};
+    try {
+        newdata.resize(load.mNewSize);
+    }
+    catch(std::exception&) {
+        result = AL_OUT_OF_MEMORY;
+    }
+    if(result == AL_NO_ERROR && load.mSrcData != nullptr && !newdata.empty())
+        ConvertData(newdata.data(), load.mSrcData, load.mSrcType, load.mNumChannels,
+            load.mFrameSize, load.mFrames, load.mAlign);
+
+    const ALuint bufid{ALBuf->id};
+    {
+        std::lock_guard<std::mutex> _{device->BufferLock};
+        if(result == AL_NO_ERROR)
+        {
+            newdata.swap(ALBuf->mData);
+            StoreFormat(ALBuf, load.mFreq, load.mSize, load.mDstChannels, load.mDstType,
+                load.mSrcType, load.mAlign, load.mAmbiOrder, load.mFrames, 0);
+        }
+        ALBuf->Loading = false;
+        DecrementRef(ALBuf->ref);
+    }
+
+    if((context->mEnabledEvts.load(std::memory_order_relaxed)&EventType_BufferLoaded))
+    {
+        std::string msg;
+        if(context->mEventMessages.load(std::memory_order_relaxed))
+        {
+            msg = "Buffer ID " + std::to_string(bufid);
+            msg += (result == AL_NO_ERROR) ? " loaded" : " failed to load: out of memory";
+        }
+
+        std::lock_guard<std::mutex> _{context->mEventCbLock};
+        ALbitfieldSOFT enabledevts{context->mEnabledEvts.load(std::memory_order_relaxed)};
+        if((enabledevts&EventType_BufferLoaded) && context->mEventCb)
+            (*context->mEventCb)(AL_EVENT_TYPE_BUFFER_LOADED_SOFT, bufid,
+                static_cast<ALuint>(result), static_cast<ALsizei>(msg.length()), msg.c_str(),
+                context->mEventParam);
+    }
+}
+
 /** Loads the specified data into the buffer, using the specified format. */
 void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
     UserFmtChannels SrcChannels, UserFmtType SrcType, const al::byte *SrcData,
-    ALbitfieldSOFT access)
+    ALbitfieldSOFT access, bool async=false)
 {
     if UNLIKELY(ReadRef(ALBuf->ref) != 0 || ALBuf->MappedAccess != 0)
         SETERR_RETURN(context, AL_INVALID_OPERATION,, "Modifying storage for in-use buffer %u",
@@ -508,6 +625,32 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
      * use AL_SIZE to try to get the buffer's play length.
      */
     newsize = RoundUp(newsize, 16);
+
+    if(async)
+    {
+        /* Hold a reference while loading, so the buffer can't be deleted or
+         * have its storage changed in the mean time.
+         */
+        IncrementRef(ALBuf->ref);
+        ALBuf->Loading = true;
+
+        std::call_once(LoadPoolOnce, []() -> void
+        {
+            ALuint numthreads{2};
+            if(auto thrdopt = ConfigValueUInt(nullptr, nullptr, "load-threads"))
+                numthreads = maxu(*thrdopt, 1u);
+            TRACE("Starting %u buffer load thread%s\n", numthreads, (numthreads==1)?"":"s");
+            LoadPool = std::make_unique<al::ThreadPool>(numthreads, "alsoft-loader");
+        });
+
+        context->add_ref();
+        auto load = std::make_shared<AsyncLoad>(AsyncLoad{ContextRef{context}, ALBuf, SrcData,
+            freq, size, DstChannels, DstType, SrcType, align, ambiorder, NumChannels, FrameSize,
+            frames, newsize});
+        LoadPool->push([load]() -> void { RunAsyncLoad(*load); });
+        return;
+    }
+
     if(newsize != ALBuf->mData.size())
     {
         auto newdata = al::vector<al::byte,16>(newsize, al::byte{});
@@ -519,44 +662,10 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
         newdata.swap(ALBuf->mData);
     }
 
-    if(SrcType == UserFmtIMA4)
-    {
-        assert(DstType == FmtShort);
-        if(SrcData != nullptr && !ALBuf->mData.empty())
-            Convert_int16_ima4(reinterpret_cast<int16_t*>(ALBuf->mData.data()), SrcData,
-                NumChannels, frames, align);
-        ALBuf->OriginalAlign = align;
-    }
-    else if(SrcType == UserFmtMSADPCM)
-    {
-        assert(DstType == FmtShort);
-        if(SrcData != nullptr && !ALBuf->mData.empty())
-            Convert_int16_msadpcm(reinterpret_cast<int16_t*>(ALBuf->mData.data()), SrcData,
-                NumChannels, frames, align);
-        ALBuf->OriginalAlign = align;
-    }
-    else
-    {
-        assert(static_cast<long>(SrcType) == static_cast<long>(DstType));
-        if(SrcData != nullptr && !ALBuf->mData.empty())
-            std::copy_n(SrcData, frames*FrameSize, ALBuf->mData.begin());
-        ALBuf->OriginalAlign = 1;
-    }
-    ALBuf->OriginalSize = size;
-    ALBuf->OriginalType = SrcType;
-
-    ALBuf->Frequency = static_cast<ALuint>(freq);
-    ALBuf->mFmtChannels = DstChannels;
-    ALBuf->mFmtType = DstType;
-    ALBuf->Access = access;
-    ALBuf->AmbiOrder = ambiorder;
-
-    ALBuf->Callback = nullptr;
-    ALBuf->UserData = nullptr;
-
-    ALBuf->SampleLen = frames;
-    ALBuf->LoopStart = 0;
-    ALBuf->LoopEnd = ALBuf->SampleLen;
+    if(SrcData != nullptr && !ALBuf->mData.empty())
+        ConvertData(ALBuf->mData.data(), SrcData, SrcType, NumChannels, FrameSize, frames, align);
+    StoreFormat(ALBuf, freq, size, DstChannels, DstType, SrcType, align, ambiorder, frames,
+        access);
 }
 
 /** Prepares the buffer to use the specified callback, using the specified format. */
@@ -842,6 +951,34 @@ START_API_FUNC
 }
 END_API_FUNC
 
+AL_API void AL_APIENTRY alBufferDataAsyncSOFT(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    ALCdevice *device{context->mDevice.get()};
+    std::lock_guard<std::mutex> _{device->BufferLock};
+
+    ALbuffer *albuf = LookupBuffer(device, buffer);
+    if UNLIKELY(!albuf)
+        context->setError(AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
+    else if UNLIKELY(size < 0)
+        context->setError(AL_INVALID_VALUE, "Negative storage size %d", size);
+    else if UNLIKELY(freq < 1)
+        context->setError(AL_INVALID_VALUE, "Invalid sample rate %d", freq);
+    else
+    {
+        auto usrfmt = DecomposeUserFormat(format);
+        if UNLIKELY(!usrfmt)
+            context->setError(AL_INVALID_ENUM, "Invalid format 0x%04x", format);
+        else
+            LoadData(context.get(), albuf, freq, static_cast<ALuint>(size), usrfmt->channels,
+                usrfmt->type, static_cast<const al::byte*>(data), 0, true);
+    }
+}
+END_API_FUNC
+
 AL_API void* AL_APIENTRY alMapBufferSOFT(ALuint buffer, ALsizei offset, ALsizei length, ALbitfieldSOFT access)
 START_API_FUNC
 {
@@ -867,6 +1004,8 @@ START_API_FUNC
                 "Mapping in-use buffer %u without persistent mapping", buffer);
         else if UNLIKELY(albuf->MappedAccess != 0)
             context->setError(AL_INVALID_OPERATION, "Mapping already-mapped buffer %u", buffer);
+        else if UNLIKELY(albuf->Loading)
+            context->setError(AL_INVALID_OPERATION, "Mapping loading buffer %u", buffer);
         else if UNLIKELY((unavailable&AL_MAP_READ_BIT_SOFT))
             context->setError(AL_INVALID_VALUE,
                 "Mapping buffer %u for reading without read access", buffer);
@@ -989,6 +1128,8 @@ START_API_FUNC
         context->setError(AL_INVALID_VALUE, "Unpacking data with mismatched ambisonic order");
     else if UNLIKELY(albuf->MappedAccess != 0)
         context->setError(AL_INVALID_OPERATION, "Unpacking data into mapped buffer %u", buffer);
+    else if UNLIKELY(albuf->Loading)
+        context->setError(AL_INVALID_OPERATION, "Unpacking data into loading buffer %u", buffer);
     else
     {
         ALuint num_chans{albuf->channelsFromFmt()};
@@ -1398,6 +1539,10 @@ START_API_FUNC
         *value = static_cast<int>(albuf->UnpackAmbiOrder);
         break;
 
+    case AL_BUFFER_LOADING_SOFT:
+        *value = albuf->Loading ? AL_TRUE : AL_FALSE;
+        break;
+
     default:
         context->setError(AL_INVALID_ENUM, "Invalid buffer integer property 0x%04x", param);
     }
@@ -1441,6 +1586,7 @@ START_API_FUNC
     case AL_AMBISONIC_LAYOUT_SOFT:
     case AL_AMBISONIC_SCALING_SOFT:
     case AL_UNPACK_AMBISONIC_ORDER_SOFT:
+    case AL_BUFFER_LOADING_SOFT:
         alGetBufferi(buffer, param, values);
         return;
     }
@@ -96,6 +96,12 @@ struct ALbuffer {
     ALsizei MappedOffset{0};
     ALsizei MappedSize{0};
 
+    /* Set while an asynchronous load is converting data for this buffer. The
+     * load also holds a reference to keep the buffer from being modified or
+     * deleted.
+     */
+    bool Loading{false};
+
     /* Number of times buffer was attached to a source (deletion can only occur when 0) */
     RefCount ref{0u};
 
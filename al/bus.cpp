@@ -0,0 +1,515 @@
+
+#include "config.h"
+
+#include "bus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+
+#include "alcmain.h"
+#include "alcontext.h"
+#include "alexcpt.h"
+#include "almalloc.h"
+#include "alnumeric.h"
+#include "inprogext.h"
+#include "logging.h"
+#include "opthelpers.h"
+
+
+namespace {
+
+inline ALbus *LookupBus(ALCcontext *context, ALuint id) noexcept
+{
+    const size_t lidx{(id-1) >> 6};
+    const ALuint slidx{(id-1) & 0x3f};
+
+    if UNLIKELY(lidx >= context->mBusList.size())
+        return nullptr;
+    BusSubList &sublist{context->mBusList[lidx]};
+    if UNLIKELY(sublist.FreeMask & (1_u64 << slidx))
+        return nullptr;
+    return sublist.Buses + slidx;
+}
+
+inline ALfilter *LookupFilter(ALCdevice *device, ALuint id) noexcept
+{
+    const size_t lidx{(id-1) >> 6};
+    const ALuint slidx{(id-1) & 0x3f};
+
+    if UNLIKELY(lidx >= device->FilterList.size())
+        return nullptr;
+    FilterSubList &sublist = device->FilterList[lidx];
+    if UNLIKELY(sublist.FreeMask & (1_u64 << slidx))
+        return nullptr;
+    return sublist.Filters + slidx;
+}
+
+
+void AddActiveBuses(const ALuint *busids, size_t count, ALCcontext *context)
+{
+    if(count < 1) return;
+    ALbusArray *curarray{context->mActiveBuses.load(std::memory_order_acquire)};
+    const size_t newcount{curarray->size() + count};
+
+    /* Append the new buses to the existing ones. */
+    ALbusArray *newarray{ALbus::CreatePtrArray(newcount)};
+    auto busiter = std::copy(curarray->begin(), curarray->end(), newarray->begin());
+    std::transform(busids, busids+count, busiter,
+        [context](ALuint id) noexcept -> ALbus* { return LookupBus(context, id); });
+    std::uninitialized_fill_n(newarray->end(), newcount, nullptr);
+
+    curarray = context->mActiveBuses.exchange(newarray, std::memory_order_acq_rel);
+    context->mDevice->waitForMix();
+
+    al::destroy_n(curarray->end(), curarray->size());
+    delete curarray;
+}
+
+void RemoveActiveBuses(const ALuint *busids, size_t count, ALCcontext *context)
+{
+    if(count < 1) return;
+    ALbusArray *curarray{context->mActiveBuses.load(std::memory_order_acquire)};
+
+    /* Copy each element in curarray to the new array whose ID is not in busids.
+     * IDs aren't repeated (they were validated before), so the new size is
+     * known.
+     */
+    const ALuint *busids_end{busids + count};
+    const auto newcount = static_cast<size_t>(std::count_if(curarray->begin(), curarray->end(),
+        [busids,busids_end](const ALbus *bus) -> bool
+        { return std::find(busids, busids_end, bus->id) == busids_end; }));
+
+    ALbusArray *newarray{ALbus::CreatePtrArray(newcount)};
+    std::copy_if(curarray->begin(), curarray->end(), newarray->begin(),
+        [busids,busids_end](const ALbus *bus) -> bool
+        { return std::find(busids, busids_end, bus->id) == busids_end; });
+    std::uninitialized_fill_n(newarray->end(), newcount, nullptr);
+
+    curarray = context->mActiveBuses.exchange(newarray, std::memory_order_acq_rel);
+    context->mDevice->waitForMix();
+
+    al::destroy_n(curarray->end(), curarray->size());
+    delete curarray;
+}
+
+
+bool EnsureBuses(ALCcontext *context, size_t needed)
+{
+    size_t count{std::accumulate(context->mBusList.cbegin(), context->mBusList.cend(), size_t{0},
+        [](size_t cur, const BusSubList &sublist) noexcept -> size_t
+        { return cur + static_cast<ALuint>(POPCNT64(sublist.FreeMask)); }
+    )};
+
+    while(needed > count)
+    {
+        if UNLIKELY(context->mBusList.size() >= 1<<25)
+            return false;
+
+        context->mBusList.emplace_back();
+        auto sublist = context->mBusList.end() - 1;
+        sublist->FreeMask = ~0_u64;
+        sublist->Buses = static_cast<ALbus*>(al_calloc(alignof(ALbus), sizeof(ALbus)*64));
+        if UNLIKELY(!sublist->Buses)
+        {
+            context->mBusList.pop_back();
+            return false;
+        }
+        count += 64;
+    }
+    return true;
+}
+
+ALbus *AllocBus(ALCcontext *context)
+{
+    auto sublist = std::find_if(context->mBusList.begin(), context->mBusList.end(),
+        [](const BusSubList &entry) noexcept -> bool
+        { return entry.FreeMask != 0; }
+    );
+    auto lidx = static_cast<ALuint>(std::distance(context->mBusList.begin(), sublist));
+    auto slidx = static_cast<ALuint>(CTZ64(sublist->FreeMask));
+
+    ALbus *bus{::new (sublist->Buses + slidx) ALbus{}};
+    bus->initMix(context->mDevice.get());
+
+    /* Add 1 to avoid bus ID 0. */
+    bus->id = ((lidx<<6) | slidx) + 1;
+
+    context->mNumBuses += 1;
+    sublist->FreeMask &= ~(1_u64 << slidx);
+
+    return bus;
+}
+
+void FreeBus(ALCcontext *context, ALbus *bus)
+{
+    const ALuint id{bus->id - 1};
+    const size_t lidx{id >> 6};
+    const ALuint slidx{id & 0x3f};
+
+    if(bus->Target)
+        DecrementRef(bus->Target->ref);
+    al::destroy_at(bus);
+
+    context->mBusList[lidx].FreeMask |= 1_u64 << slidx;
+    context->mNumBuses--;
+}
+
+
+#define DO_UPDATEPROPS() do {                                                 \
+    if(!context->mDeferUpdates.load(std::memory_order_acquire))               \
+        bus->updateProps(context.get());                                      \
+    else                                                                      \
+        bus->PropsClean.clear(std::memory_order_release);                     \
+} while(0)
+
+} // namespace
+
+ALbusArray *ALbus::CreatePtrArray(size_t count) noexcept
+{
+    /* Allocate space for twice as many pointers, so the mixer has scratch
+     * space to store a sorted list during mixing.
+     */
+    void *ptr{al_calloc(alignof(ALbusArray), ALbusArray::Sizeof(count*2))};
+    return new (ptr) ALbusArray{count};
+}
+
+
+AL_API void AL_APIENTRY alGenBusesSOFT(ALsizei n, ALuint *buses)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    if UNLIKELY(n < 0)
+        context->setError(AL_INVALID_VALUE, "Generating %d buses", n);
+    if UNLIKELY(n <= 0) return;
+
+    std::unique_lock<std::mutex> buslock{context->mBusLock};
+    if(!EnsureBuses(context.get(), static_cast<ALuint>(n)))
+    {
+        context->setError(AL_OUT_OF_MEMORY, "Failed to allocate %d bus%s", n,
+            (n==1) ? "" : "es");
+        return;
+    }
+
+    if(n == 1)
+    {
+        ALbus *bus{AllocBus(context.get())};
+        buses[0] = bus->id;
+    }
+    else
+    {
+        al::vector<ALuint> ids;
+        ALsizei count{n};
+        ids.reserve(static_cast<ALuint>(count));
+        do {
+            ALbus *bus{AllocBus(context.get())};
+            ids.emplace_back(bus->id);
+        } while(--count);
+        std::copy(ids.cbegin(), ids.cend(), buses);
+    }
+
+    AddActiveBuses(buses, static_cast<ALuint>(n), context.get());
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alDeleteBusesSOFT(ALsizei n, const ALuint *buses)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    if UNLIKELY(n < 0)
+        context->setError(AL_INVALID_VALUE, "Deleting %d buses", n);
+    if UNLIKELY(n <= 0) return;
+
+    std::lock_guard<std::mutex> _{context->mBusLock};
+    const ALuint *buses_end{buses + n};
+    for(auto iter = buses;iter != buses_end;++iter)
+    {
+        ALbus *bus{LookupBus(context.get(), *iter)};
+        if UNLIKELY(!bus)
+            SETERR_RETURN(context, AL_INVALID_NAME,, "Invalid bus ID %u", *iter);
+        if UNLIKELY(ReadRef(bus->ref) != 0)
+            SETERR_RETURN(context, AL_INVALID_OPERATION,, "Deleting in-use bus %u", *iter);
+        if UNLIKELY(std::find(buses, iter, *iter) != iter)
+            SETERR_RETURN(context, AL_INVALID_VALUE,, "Deleting duplicate bus %u", *iter);
+    }
+
+    // All buses are valid, remove and delete them
+    RemoveActiveBuses(buses, static_cast<ALuint>(n), context.get());
+    std::for_each(buses, buses_end,
+        [&context](const ALuint bid) -> void
+        { FreeBus(context.get(), LookupBus(context.get(), bid)); });
+}
+END_API_FUNC
+
+AL_API ALboolean AL_APIENTRY alIsBusSOFT(ALuint bus)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if LIKELY(context)
+    {
+        std::lock_guard<std::mutex> _{context->mBusLock};
+        if(LookupBus(context.get(), bus) != nullptr)
+            return AL_TRUE;
+    }
+    return AL_FALSE;
+}
+END_API_FUNC
+
+
+AL_API void AL_APIENTRY alBusiSOFT(ALuint busid, ALenum param, ALint value)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    std::lock_guard<std::mutex> _{context->mPropLock};
+    std::lock_guard<std::mutex> __{context->mBusLock};
+    ALbus *bus{LookupBus(context.get(), busid)};
+    if UNLIKELY(!bus)
+        SETERR_RETURN(context, AL_INVALID_NAME,, "Invalid bus ID %u", busid);
+
+    ALbus *target{};
+    ALCdevice *device{};
+    switch(param)
+    {
+    case AL_DIRECT_FILTER:
+        device = context->mDevice.get();
+        {
+            std::lock_guard<std::mutex> ___{device->FilterLock};
+            ALfilter *filter{value ? LookupFilter(device, static_cast<ALuint>(value)) : nullptr};
+            if(value && !filter)
+                SETERR_RETURN(context, AL_INVALID_VALUE,, "Invalid filter ID %u",
+                    static_cast<ALuint>(value));
+
+            if(!filter)
+            {
+                bus->Filter.Gain = 1.0f;
+                bus->Filter.GainHF = 1.0f;
+                bus->Filter.HFReference = LOWPASSFREQREF;
+                bus->Filter.GainLF = 1.0f;
+                bus->Filter.LFReference = HIGHPASSFREQREF;
+            }
+            else
+            {
+                bus->Filter.Gain = filter->Gain;
+                bus->Filter.GainHF = filter->GainHF;
+                bus->Filter.HFReference = filter->HFReference;
+                bus->Filter.GainLF = filter->GainLF;
+                bus->Filter.LFReference = filter->LFReference;
+            }
+        }
+        break;
+
+    case AL_BUS_TARGET_SOFT:
+        target = LookupBus(context.get(), static_cast<ALuint>(value));
+        if(value && !target)
+            SETERR_RETURN(context, AL_INVALID_VALUE,, "Invalid bus target ID");
+        if(target)
+        {
+            ALbus *checker{target};
+            while(checker && checker != bus)
+                checker = checker->Target;
+            if(checker)
+                SETERR_RETURN(context, AL_INVALID_OPERATION,,
+                    "Setting target of bus ID %u to %u creates circular chain", bus->id,
+                    target->id);
+        }
+
+        if(ALbus *oldtarget{bus->Target})
+        {
+            /* We must force an update if there was an existing bus target, in
+             * case it's about to be deleted.
+             */
+            if(target) IncrementRef(target->ref);
+            DecrementRef(oldtarget->ref);
+            bus->Target = target;
+            bus->updateProps(context.get());
+            return;
+        }
+
+        if(target) IncrementRef(target->ref);
+        bus->Target = target;
+        break;
+
+    default:
+        SETERR_RETURN(context, AL_INVALID_ENUM,, "Invalid bus integer property 0x%04x", param);
+    }
+    DO_UPDATEPROPS();
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alBusfSOFT(ALuint busid, ALenum param, ALfloat value)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    std::lock_guard<std::mutex> _{context->mPropLock};
+    std::lock_guard<std::mutex> __{context->mBusLock};
+    ALbus *bus{LookupBus(context.get(), busid)};
+    if UNLIKELY(!bus)
+        SETERR_RETURN(context, AL_INVALID_NAME,, "Invalid bus ID %u", busid);
+
+    switch(param)
+    {
+    case AL_GAIN:
+        if(!(value >= 0.0f && std::isfinite(value)))
+            SETERR_RETURN(context, AL_INVALID_VALUE,, "Bus gain out of range");
+        bus->Gain = value;
+        break;
+
+    default:
+        SETERR_RETURN(context, AL_INVALID_ENUM,, "Invalid bus float property 0x%04x", param);
+    }
+    DO_UPDATEPROPS();
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alGetBusiSOFT(ALuint busid, ALenum param, ALint *value)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    std::lock_guard<std::mutex> _{context->mBusLock};
+    ALbus *bus{LookupBus(context.get(), busid)};
+    if UNLIKELY(!bus)
+        SETERR_RETURN(context, AL_INVALID_NAME,, "Invalid bus ID %u", busid);
+
+    switch(param)
+    {
+    case AL_BUS_TARGET_SOFT:
+        if(ALbus *target{bus->Target})
+            *value = static_cast<ALint>(target->id);
+        else
+            *value = 0;
+        break;
+
+    default:
+        context->setError(AL_INVALID_ENUM, "Invalid bus integer property 0x%04x", param);
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alGetBusfSOFT(ALuint busid, ALenum param, ALfloat *value)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    std::lock_guard<std::mutex> _{context->mBusLock};
+    ALbus *bus{LookupBus(context.get(), busid)};
+    if UNLIKELY(!bus)
+        SETERR_RETURN(context, AL_INVALID_NAME,, "Invalid bus ID %u", busid);
+
+    switch(param)
+    {
+    case AL_GAIN:
+        *value = bus->Gain;
+        break;
+
+    default:
+        context->setError(AL_INVALID_ENUM, "Invalid bus float property 0x%04x", param);
+    }
+}
+END_API_FUNC
+
+
+ALbus::~ALbus()
+{
+    ALbusProps *props{Params.Update.load()};
+    if(props)
+    {
+        TRACE("Freed unapplied bus update %p\n", decltype(std::declval<void*>()){props});
+        delete props;
+    }
+}
+
+void ALbus::initMix(const ALCdevice *device)
+{
+    const size_t count{device->Dry.Buffer.size()};
+    if(count != MixBuffer.size())
+    {
+        MixBuffer.resize(count);
+        MixBuffer.shrink_to_fit();
+    }
+    std::fill(MixBuffer.begin(), MixBuffer.end(), FloatBufferLine{});
+    Buffer = {MixBuffer.data(), MixBuffer.size()};
+
+    /* Keep the current gain, so the output doesn't jump. */
+    const float gain{mChans.empty() ? Params.Gain : mChans[0].CurrentGain};
+    mChans.clear();
+    mChans.resize(count);
+    for(auto &chan : mChans)
+        chan.CurrentGain = gain;
+}
+
+void ALbus::updateProps(ALCcontext *context)
+{
+    /* Get an unused property container, or allocate a new one as needed. */
+    ALbusProps *props{context->mFreeBusProps.load(std::memory_order_relaxed)};
+    if(!props)
+        props = new ALbusProps{};
+    else
+    {
+        ALbusProps *next;
+        do {
+            next = props->next.load(std::memory_order_relaxed);
+        } while(context->mFreeBusProps.compare_exchange_weak(props, next,
+                std::memory_order_seq_cst, std::memory_order_acquire) == 0);
+    }
+
+    /* Copy in current property values. */
+    props->Gain = Gain * Filter.Gain;
+    props->GainHF = Filter.GainHF;
+    props->HFReference = Filter.HFReference;
+    props->GainLF = Filter.GainLF;
+    props->LFReference = Filter.LFReference;
+    props->Target = Target;
+
+    /* Set the new container for updating internal parameters. */
+    props = Params.Update.exchange(props, std::memory_order_acq_rel);
+    if(props)
+    {
+        /* If there was an unused update container, put it back in the
+         * freelist.
+         */
+        AtomicReplaceHead(context->mFreeBusProps, props);
+    }
+}
+
+void UpdateAllBusProps(ALCcontext *context)
+{
+    std::lock_guard<std::mutex> _{context->mBusLock};
+    ALbusArray *buses{context->mActiveBuses.load(std::memory_order_acquire)};
+    for(ALbus *bus : *buses)
+    {
+        if(!bus->PropsClean.test_and_set(std::memory_order_acq_rel))
+            bus->updateProps(context);
+    }
+}
+
+BusSubList::~BusSubList()
+{
+    uint64_t usemask{~FreeMask};
+    while(usemask)
+    {
+        ALsizei idx{CTZ64(usemask)};
+        al::destroy_at(Buses+idx);
+        usemask &= ~(1_u64 << idx);
+    }
+    FreeMask = ~usemask;
+    al_free(Buses);
+    Buses = nullptr;
+}
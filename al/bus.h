@@ -0,0 +1,103 @@
+#ifndef AL_BUS_H
+#define AL_BUS_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+
+#include "alcmain.h"
+#include "almalloc.h"
+#include "alspan.h"
+#include "atomic.h"
+#include "filter.h"
+#include "filters/biquad.h"
+#include "vector.h"
+
+struct ALbus;
+
+
+using ALbusArray = al::FlexArray<ALbus*>;
+
+
+struct ALbusProps {
+    float Gain;
+    float GainHF;
+    float HFReference;
+    float GainLF;
+    float LFReference;
+    ALbus *Target;
+
+    std::atomic<ALbusProps*> next;
+
+    DEF_NEWDEL(ALbusProps)
+};
+
+
+/**
+ * A submix bus. Sources can route their direct path into a bus instead of the
+ * main output, and the bus applies its gain and filter to the combined mix
+ * once, before passing it on to its target bus or the main output.
+ */
+struct ALbus {
+    float Gain{1.0f};
+    struct {
+        float Gain{1.0f};
+        float GainHF{1.0f};
+        float HFReference{LOWPASSFREQREF};
+        float GainLF{1.0f};
+        float LFReference{HIGHPASSFREQREF};
+    } Filter;
+    ALbus *Target{nullptr};
+
+    std::atomic_flag PropsClean;
+
+    /* The number of sources and buses using this bus. */
+    RefCount ref{0u};
+
+    struct ChannelData {
+        BiquadFilter LowPass;
+        BiquadFilter HighPass;
+        float CurrentGain{1.0f};
+    };
+
+    struct {
+        std::atomic<ALbusProps*> Update{nullptr};
+
+        float Gain{1.0f};
+        int FilterType{0}; /* AF_* flags */
+        ALbus *Target{nullptr};
+
+        /* How many buses this one's output goes through before the main
+         * output. Set by the mixer when sorting the buses.
+         */
+        ALuint Depth{0u};
+
+        /* Gain changes fade in after the bus is first mixed. */
+        bool IsFading{false};
+    } Params;
+
+    /* Self ID */
+    ALuint id{};
+
+    /* Mixing buffer, with the same channels as the device's dry mix. */
+    al::vector<FloatBufferLine, 16> MixBuffer;
+    al::vector<ChannelData> mChans;
+    al::span<FloatBufferLine> Buffer;
+
+    ALbus() { PropsClean.test_and_set(std::memory_order_relaxed); }
+    ALbus(const ALbus&) = delete;
+    ALbus& operator=(const ALbus&) = delete;
+    ~ALbus();
+
+    /** Sets up the mixing buffer for the device's current output. */
+    void initMix(const ALCdevice *device);
+    void updateProps(ALCcontext *context);
+
+    static ALbusArray *CreatePtrArray(size_t count) noexcept;
+};
+
+void UpdateAllBusProps(ALCcontext *context);
+
+#endif
@@ -28,6 +28,8 @@ enum {
 extern bool DisabledEffects[MAX_EFFECTS];
 
 extern float ReverbBoost;
+extern ALuint ReverbLateRate;
+extern bool FshifterIIRHilbert;
 
 struct EffectList {
     const char name[16];
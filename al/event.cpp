@@ -29,75 +29,149 @@
 #include "threads.h"
 
 
-static int EventThread(ALCcontext *context)
+namespace {
+
+const char *StateName(ALenum state) noexcept
+{
+    switch(state)
+    {
+    case AL_INITIAL: return "AL_INITIAL";
+    case AL_PLAYING: return "AL_PLAYING";
+    case AL_PAUSED: return "AL_PAUSED";
+    case AL_STOPPED: return "AL_STOPPED";
+    }
+    return "<unknown>";
+}
+
+/* Handles the queued events, either passing them to the event callback or,
+ * when events is non-null, storing up to count of them in the array. Stops at
+ * the kill event, which is only consumed (setting quitnow) when not storing.
+ * Must be called with the event callback lock held. Returns the number of
+ * events stored.
+ */
+size_t HandleEvents(ALCcontext *context, ALeventSOFT *events, size_t count, bool &quitnow)
 {
     RingBuffer *ring{context->mAsyncEvents.get()};
-    bool quitnow{false};
-    while LIKELY(!quitnow)
+    const bool polling{events != nullptr};
+    size_t numevts{0};
+
+    auto evt_data = ring->getReadVector().first;
+    while(evt_data.len != 0 && !(polling && numevts == count))
     {
-        auto evt_data = ring->getReadVector().first;
-        if(evt_data.len == 0)
+        auto *evt_ptr = reinterpret_cast<AsyncEvent*>(evt_data.buf);
+        if UNLIKELY(evt_ptr->EnumType == EventType_KillThread)
         {
-            context->mEventSem.wait();
+            if(!polling)
+            {
+                al::destroy_at(evt_ptr);
+                ring->readAdvance(1);
+                quitnow = true;
+            }
+            break;
+        }
+
+        AsyncEvent evt{*evt_ptr};
+        al::destroy_at(evt_ptr);
+        ring->readAdvance(1);
+
+        evt_data.buf += sizeof(AsyncEvent);
+        if(--evt_data.len == 0)
+            evt_data = ring->getReadVector().first;
+
+        if(evt.EnumType == EventType_ReleaseEffectState)
+        {
+            evt.u.mEffectState->release();
             continue;
         }
 
-        std::lock_guard<std::mutex> _{context->mEventCbLock};
-        do {
-            auto *evt_ptr = reinterpret_cast<AsyncEvent*>(evt_data.buf);
-            evt_data.buf += sizeof(AsyncEvent);
-            evt_data.len -= 1;
+        ALbitfieldSOFT enabledevts{context->mEnabledEvts.load(std::memory_order_acquire)};
+        if((enabledevts&evt.EnumType) != evt.EnumType)
+            continue;
 
-            AsyncEvent evt{*evt_ptr};
-            al::destroy_at(evt_ptr);
-            ring->readAdvance(1);
+        ALenum type{};
+        ALuint object{}, param{};
+        if(evt.EnumType == EventType_SourceStateChange)
+        {
+            type = AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT;
+            object = evt.u.srcstate.id;
+            param = static_cast<ALuint>(evt.u.srcstate.state);
+        }
+        else if(evt.EnumType == EventType_BufferCompleted)
+        {
+            type = AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT;
+            object = evt.u.bufcomp.id;
+            param = evt.u.bufcomp.count;
+        }
+        else
+        {
+            type = evt.u.user.type;
+            object = evt.u.user.id;
+            param = evt.u.user.param;
+        }
 
-            quitnow = evt.EnumType == EventType_KillThread;
-            if UNLIKELY(quitnow) break;
+        if(polling)
+        {
+            events[numevts++] = ALeventSOFT{type, object, param};
+            continue;
+        }
+        if(!context->mEventCb) continue;
 
-            if(evt.EnumType == EventType_ReleaseEffectState)
-            {
-                evt.u.mEffectState->release();
-                continue;
-            }
+        if(!context->mEventMessages.load(std::memory_order_relaxed))
+        {
+            context->mEventCb(type, object, param, 0, "", context->mEventParam);
+            continue;
+        }
+
+        if(evt.EnumType == EventType_SourceStateChange)
+        {
+            std::string msg{"Source ID " + std::to_string(object)};
+            msg += " state has changed to ";
+            msg += StateName(evt.u.srcstate.state);
+            context->mEventCb(type, object, param, static_cast<ALsizei>(msg.length()),
+                msg.c_str(), context->mEventParam);
+        }
+        else if(evt.EnumType == EventType_BufferCompleted)
+        {
+            std::string msg{std::to_string(param)};
+            if(param == 1) msg += " buffer completed";
+            else msg += " buffers completed";
+            context->mEventCb(type, object, param, static_cast<ALsizei>(msg.length()),
+                msg.c_str(), context->mEventParam);
+        }
+        else
+            context->mEventCb(type, object, param, static_cast<ALsizei>(strlen(evt.u.user.msg)),
+                evt.u.user.msg, context->mEventParam);
+    }
+    return numevts;
+}
 
-            ALbitfieldSOFT enabledevts{context->mEnabledEvts.load(std::memory_order_acquire)};
-            if(!context->mEventCb) continue;
+int EventThread(ALCcontext *context)
+{
+    RingBuffer *ring{context->mAsyncEvents.get()};
+    bool quitnow{false};
+    while LIKELY(!quitnow)
+    {
+        if(ring->readSpace() == 0)
+        {
+            context->mEventSem.wait();
+            continue;
+        }
 
-            if(evt.EnumType == EventType_SourceStateChange)
-            {
-                if(!(enabledevts&EventType_SourceStateChange))
-                    continue;
-                std::string msg{"Source ID " + std::to_string(evt.u.srcstate.id)};
-                msg += " state has changed to ";
-                msg += (evt.u.srcstate.state==AL_INITIAL) ? "AL_INITIAL" :
-                    (evt.u.srcstate.state==AL_PLAYING) ? "AL_PLAYING" :
-                    (evt.u.srcstate.state==AL_PAUSED) ? "AL_PAUSED" :
-                    (evt.u.srcstate.state==AL_STOPPED) ? "AL_STOPPED" : "<unknown>";
-                context->mEventCb(AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT, evt.u.srcstate.id,
-                    static_cast<ALuint>(evt.u.srcstate.state), static_cast<ALsizei>(msg.length()),
-                    msg.c_str(), context->mEventParam);
-            }
-            else if(evt.EnumType == EventType_BufferCompleted)
-            {
-                if(!(enabledevts&EventType_BufferCompleted))
-                    continue;
-                std::string msg{std::to_string(evt.u.bufcomp.count)};
-                if(evt.u.bufcomp.count == 1) msg += " buffer completed";
-                else msg += " buffers completed";
-                context->mEventCb(AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT, evt.u.bufcomp.id,
-                    evt.u.bufcomp.count, static_cast<ALsizei>(msg.length()), msg.c_str(),
-                    context->mEventParam);
-            }
-            else if((enabledevts&evt.EnumType) == evt.EnumType)
-                context->mEventCb(evt.u.user.type, evt.u.user.id, evt.u.user.param,
-                    static_cast<ALsizei>(strlen(evt.u.user.msg)), evt.u.user.msg,
-                    context->mEventParam);
-        } while(evt_data.len != 0);
+        std::unique_lock<std::mutex> cblock{context->mEventCbLock};
+        if(context->mEventPolling.load(std::memory_order_acquire))
+        {
+            /* The app is polling for events, so leave them in the queue. */
+            cblock.unlock();
+            context->mEventSem.wait();
+            continue;
+        }
+        HandleEvents(context, nullptr, 0, quitnow);
     }
     return 0;
 }
 
+} // namespace
+
 void StartEventThrd(ALCcontext *ctx)
 {
     try {
@@ -125,6 +199,11 @@ void StopEventThrd(ALCcontext *ctx)
     ::new(evt_data.buf) AsyncEvent{EventType_KillThread};
     ring->writeAdvance(1);
 
+    /* Make sure the event thread handles what's left, so it sees the kill
+     * event.
+     */
+    ctx->mEventPolling.store(false, std::memory_order_release);
+
     ctx->mEventSem.post();
     if(ctx->mEventThread.joinable())
         ctx->mEventThread.join();
@@ -157,6 +236,8 @@ START_API_FUNC
                 flags |= EventType_Deprecated;
             else if(type == AL_EVENT_TYPE_DISCONNECTED_SOFT)
                 flags |= EventType_Disconnected;
+            else if(type == AL_EVENT_TYPE_BUFFER_LOADED_SOFT)
+                flags |= EventType_BufferLoaded;
             else
                 return false;
             return true;
@@ -203,3 +284,24 @@ START_API_FUNC
     context->mEventParam = userParam;
 }
 END_API_FUNC
+
+AL_API ALsizei AL_APIENTRY alPollEventsSOFT(ALsizei count, ALeventSOFT *events)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return 0;
+
+    if UNLIKELY(count < 0)
+        SETERR_RETURN(context, AL_INVALID_VALUE, 0, "Polling %d events", count);
+    if UNLIKELY(count == 0) return 0;
+    if UNLIKELY(!events)
+        SETERR_RETURN(context, AL_INVALID_VALUE, 0, "NULL pointer");
+    if UNLIKELY(!context->mEventPolling.load(std::memory_order_acquire))
+        SETERR_RETURN(context, AL_INVALID_OPERATION, 0, "Event polling is not enabled");
+
+    std::lock_guard<std::mutex> _{context->mEventCbLock};
+    bool quitnow{false};
+    return static_cast<ALsizei>(HandleEvents(context.get(), events, static_cast<size_t>(count),
+        quitnow));
+}
+END_API_FUNC
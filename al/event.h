@@ -20,6 +20,7 @@ enum {
     EventType_Performance       = 1<<3,
     EventType_Deprecated        = 1<<4,
     EventType_Disconnected      = 1<<5,
+    EventType_BufferLoaded      = 1<<6,
 
     /* Internal events. */
     EventType_ReleaseEffectState = 65536,
@@ -41,7 +42,8 @@ struct AsyncEvent {
             ALenum type;
             ALuint id;
             ALuint param;
-            ALchar msg[232];
+            /* Must point to storage that outlives the event. */
+            const ALchar *msg;
         } user;
         EffectState *mEffectState;
     } u{};
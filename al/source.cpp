@@ -59,6 +59,7 @@
 #include "backends/base.h"
 #include "bformatdec.h"
 #include "buffer.h"
+#include "bus.h"
 #include "event.h"
 #include "filter.h"
 #include "filters/nfc.h"
@@ -127,6 +128,7 @@ void UpdateSourceProps(const ALsource *source, Voice *voice, ALCcontext *context
     props->mResampler = source->mResampler;
     props->DirectChannels = source->DirectChannels;
     props->mSpatializeMode = source->mSpatialize;
+    props->mHrtfMode = source->mHrtf;
 
     props->DryGainHFAuto = source->DryGainHFAuto;
     props->WetGainAuto = source->WetGainAuto;
@@ -146,6 +148,7 @@ void UpdateSourceProps(const ALsource *source, Voice *voice, ALCcontext *context
     props->Direct.HFReference = source->Direct.HFReference;
     props->Direct.GainLF = source->Direct.GainLF;
     props->Direct.LFReference = source->Direct.LFReference;
+    props->Direct.Bus = source->Direct.Bus;
 
     auto copy_send = [](const ALsource::SendData &srcsend) noexcept -> VoiceProps::SendData
     {
@@ -171,6 +174,17 @@ void UpdateSourceProps(const ALsource *source, Voice *voice, ALCcontext *context
     }
 }
 
+/* Updates the voice's properties after the source's send slots or direct bus
+ * changed. The mixer applies this update before mixing the voice again, even
+ * when the source update thread handles other updates after the mix, since the
+ * old slot or bus may be deleted once the mix finishes.
+ */
+void UpdateSourceTargets(const ALsource *source, Voice *voice, ALCcontext *context)
+{
+    UpdateSourceProps(source, voice, context);
+    voice->mTargetsChanged.store(true, std::memory_order_release);
+}
+
 /* GetSourceSampleOffset
  *
  * Gets the current read offset for the given Source, in 32.32 fixed-point
@@ -457,6 +471,10 @@ void InitVoice(Voice *voice, ALsource *source, ALbufferlistitem *BufferList, ALC
      * until the update gets applied.
      */
     voice->mStep = 0;
+    /* It also has no resampler to crossfade from. */
+    voice->mResampler = nullptr;
+    voice->mResamplerLod = 0;
+    voice->mPrevResampler = nullptr;
 
     if(voice->mChans.capacity() > 2 && num_channels < voice->mChans.capacity())
         al::vector<Voice::ChannelData>{}.swap(voice->mChans);
@@ -497,13 +515,7 @@ void InitVoice(Voice *voice, ALsource *source, ALbufferlistitem *BufferList, ALC
         }
     }
 
-    if(device->AvgSpeakerDist > 0.0f)
-    {
-        const float w1{SPEEDOFSOUNDMETRESPERSEC /
-            (device->AvgSpeakerDist * static_cast<float>(device->Frequency))};
-        for(auto &chandata : voice->mChans)
-            chandata.mDryParams.NFCtrlFilter.init(w1);
-    }
+    voice->initDirectFilters(device);
 
     source->PropsClean.test_and_set(std::memory_order_acq_rel);
     UpdateSourceProps(source, voice, context);
@@ -804,6 +816,19 @@ inline ALeffectslot *LookupEffectSlot(ALCcontext *context, ALuint id) noexcept
     return sublist.EffectSlots + slidx;
 }
 
+inline ALbus *LookupBus(ALCcontext *context, ALuint id) noexcept
+{
+    const size_t lidx{(id-1) >> 6};
+    const ALuint slidx{(id-1) & 0x3f};
+
+    if UNLIKELY(lidx >= context->mBusList.size())
+        return nullptr;
+    BusSubList &sublist{context->mBusList[lidx]};
+    if UNLIKELY(sublist.FreeMask & (1_u64 << slidx))
+        return nullptr;
+    return sublist.Buses + slidx;
+}
+
 
 enum SourceProp : ALenum {
     srcPitch = AL_PITCH,
@@ -868,6 +893,12 @@ enum SourceProp : ALenum {
     /* AL_SOFT_source_spatialize */
     srcSpatialize = AL_SOURCE_SPATIALIZE_SOFT,
 
+    /* AL_SOFT_hrtf_lod */
+    srcHrtf = AL_SOURCE_HRTF_SOFT,
+
+    /* AL_SOFT_submix_bus */
+    srcDirectBus = AL_DIRECT_BUS_SOFT,
+
     /* ALC_SOFT_device_clock */
     srcSampleOffsetClockSOFT = AL_SAMPLE_OFFSET_CLOCK_SOFT,
     srcSecOffsetClockSOFT = AL_SEC_OFFSET_CLOCK_SOFT,
@@ -911,6 +942,7 @@ ALuint FloatValsByProp(ALenum prop)
     case AL_SOURCE_RADIUS:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SOURCE_HRTF_SOFT:
         return 1;
 
     case AL_STEREO_ANGLES:
@@ -931,6 +963,7 @@ ALuint FloatValsByProp(ALenum prop)
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
     case AL_AUXILIARY_SEND_FILTER:
+    case AL_DIRECT_BUS_SOFT:
         break; /* i/i64 only */
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
@@ -973,6 +1006,7 @@ ALuint DoubleValsByProp(ALenum prop)
     case AL_SOURCE_RADIUS:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SOURCE_HRTF_SOFT:
         return 1;
 
     case AL_SEC_OFFSET_LATENCY_SOFT:
@@ -991,6 +1025,7 @@ ALuint DoubleValsByProp(ALenum prop)
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
     case AL_AUXILIARY_SEND_FILTER:
+    case AL_DIRECT_BUS_SOFT:
         break; /* i/i64 only */
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
@@ -1226,6 +1261,7 @@ bool SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_DIRECT_CHANNELS_SOFT:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SOURCE_HRTF_SOFT:
         CHECKSIZE(values, 1);
         ival = static_cast<int>(values[0]);
         return SetSourceiv(Source, Context, prop, {&ival, 1u});
@@ -1239,6 +1275,7 @@ bool SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
     case AL_AUXILIARY_SEND_FILTER:
+    case AL_DIRECT_BUS_SOFT:
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
         break;
@@ -1259,6 +1296,8 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     std::unique_lock<std::mutex> slotlock;
     std::unique_lock<std::mutex> filtlock;
     std::unique_lock<std::mutex> buflock;
+    std::unique_lock<std::mutex> buslock;
+    ALbus *bus{nullptr};
     float fvals[6];
 
     switch(prop)
@@ -1314,6 +1353,9 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         else if(buffer && buffer->Callback && ReadRef(buffer->ref) != 0)
             SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
                 "Setting already-set callback buffer %u", buffer->id);
+        else if(buffer && buffer->Loading)
+            SETERR_RETURN(Context, AL_INVALID_OPERATION, false, "Setting loading buffer %u",
+                buffer->id);
         else
         {
             const ALenum state{GetSourceState(Source, GetSourceVoice(Source, Context))};
@@ -1401,6 +1443,31 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         filtlock.unlock();
         return UpdateSourceProps(Source, Context);
 
+    case AL_DIRECT_BUS_SOFT:
+        CHECKSIZE(values, 1);
+        buslock = std::unique_lock<std::mutex>{Context->mBusLock};
+        if(values[0] && (bus=LookupBus(Context, static_cast<ALuint>(values[0]))) == nullptr)
+            SETERR_RETURN(Context, AL_INVALID_VALUE, false, "Invalid bus ID %u",
+                static_cast<ALuint>(values[0]));
+
+        if(bus) IncrementRef(bus->ref);
+        if(auto *oldbus = Source->Direct.Bus)
+            DecrementRef(oldbus->ref);
+        if(bus != Source->Direct.Bus && IsPlayingOrPaused(Source))
+        {
+            Source->Direct.Bus = bus;
+
+            /* As with auxiliary slots, force an update if the bus changed on
+             * an active source, in case the old bus is about to be deleted.
+             */
+            Voice *voice{GetSourceVoice(Source, Context)};
+            if(voice) UpdateSourceTargets(Source, voice, Context);
+            else Source->PropsClean.clear(std::memory_order_release);
+            return true;
+        }
+        Source->Direct.Bus = bus;
+        return UpdateSourceProps(Source, Context);
+
     case AL_DIRECT_FILTER_GAINHF_AUTO:
         CHECKSIZE(values, 1);
         CHECKVAL(values[0] == AL_FALSE || values[0] == AL_TRUE);
@@ -1456,6 +1523,13 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         Source->mSpatialize = static_cast<SpatializeMode>(values[0]);
         return UpdateSourceProps(Source, Context);
 
+    case AL_SOURCE_HRTF_SOFT:
+        CHECKSIZE(values, 1);
+        CHECKVAL(values[0] >= AL_FALSE && values[0] <= AL_AUTO_SOFT);
+
+        Source->mHrtf = static_cast<HrtfMode>(values[0]);
+        return UpdateSourceProps(Source, Context);
+
 
     case AL_AUXILIARY_SEND_FILTER:
         CHECKSIZE(values, 3);
@@ -1502,7 +1576,7 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
              * active source, in case the slot is about to be deleted.
              */
             Voice *voice{GetSourceVoice(Source, Context)};
-            if(voice) UpdateSourceProps(Source, voice, Context);
+            if(voice) UpdateSourceTargets(Source, voice, Context);
             else Source->PropsClean.clear(std::memory_order_release);
         }
         else
@@ -1600,6 +1674,7 @@ bool SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     case AL_DISTANCE_MODEL:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SOURCE_HRTF_SOFT:
         CHECKSIZE(values, 1);
         CHECKVAL(values[0] <= INT_MAX && values[0] >= INT_MIN);
 
@@ -1609,6 +1684,7 @@ bool SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     /* 1x uint */
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
+    case AL_DIRECT_BUS_SOFT:
         CHECKSIZE(values, 1);
         CHECKVAL(values[0] <= UINT_MAX && values[0] >= 0);
 
@@ -1857,6 +1933,7 @@ bool GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_DISTANCE_MODEL:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SOURCE_HRTF_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourceiv(Source, Context, prop, {ivals, 1u})) != false)
             values[0] = static_cast<double>(ivals[0]);
@@ -1865,6 +1942,7 @@ bool GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
     case AL_AUXILIARY_SEND_FILTER:
+    case AL_DIRECT_BUS_SOFT:
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
         break;
@@ -1993,6 +2071,16 @@ bool GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         values[0] = static_cast<int>(Source->mSpatialize);
         return true;
 
+    case AL_SOURCE_HRTF_SOFT:
+        CHECKSIZE(values, 1);
+        values[0] = static_cast<int>(Source->mHrtf);
+        return true;
+
+    case AL_DIRECT_BUS_SOFT:
+        CHECKSIZE(values, 1);
+        values[0] = static_cast<int>(Source->Direct.Bus ? Source->Direct.Bus->id : 0u);
+        return true;
+
     /* 1x float/double */
     case AL_CONE_INNER_ANGLE:
     case AL_CONE_OUTER_ANGLE:
@@ -2167,6 +2255,7 @@ bool GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     case AL_DISTANCE_MODEL:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SOURCE_HRTF_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourceiv(Source, Context, prop, {ivals, 1u})) != false)
             values[0] = ivals[0];
@@ -2175,6 +2264,7 @@ bool GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     /* 1x uint */
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
+    case AL_DIRECT_BUS_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourceiv(Source, Context, prop, {ivals, 1u})) != false)
             values[0] = static_cast<ALuint>(ivals[0]);
@@ -3214,6 +3304,11 @@ START_API_FUNC
             context->setError(AL_INVALID_OPERATION, "Queueing callback buffer %u", buffers[i]);
             goto buffer_error;
         }
+        if(buffer && buffer->Loading)
+        {
+            context->setError(AL_INVALID_OPERATION, "Queueing loading buffer %u", buffers[i]);
+            goto buffer_error;
+        }
 
         if(!BufferListStart)
         {
@@ -3360,6 +3455,7 @@ ALsource::ALsource()
     Direct.HFReference = LOWPASSFREQREF;
     Direct.GainLF = 1.0f;
     Direct.LFReference = HIGHPASSFREQREF;
+    Direct.Bus = nullptr;
     for(auto &send : Send)
     {
         send.Slot = nullptr;
@@ -3384,6 +3480,8 @@ ALsource::~ALsource()
     }
     queue = nullptr;
 
+    if(Direct.Bus) DecrementRef(Direct.Bus->ref);
+
     auto clear_send = [](ALsource::SendData &send) -> void
     { if(send.Slot) DecrementRef(send.Slot->ref); };
     std::for_each(Send.begin(), Send.end(), clear_send);
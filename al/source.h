@@ -18,6 +18,7 @@
 #include "vector.h"
 
 struct ALbuffer;
+struct ALbus;
 struct ALeffectslot;
 
 
@@ -57,6 +58,7 @@ struct ALsource {
     Resampler mResampler{ResamplerDefault};
     DirectMode DirectChannels{DirectMode::Off};
     SpatializeMode mSpatialize{SpatializeMode::Auto};
+    HrtfMode mHrtf{HrtfMode::Auto};
 
     bool DryGainHFAuto{true};
     bool WetGainAuto{true};
@@ -81,6 +83,7 @@ struct ALsource {
         float HFReference;
         float GainLF;
         float LFReference;
+        ALbus *Bus;
     } Direct;
     struct SendData {
         ALeffectslot *Slot;
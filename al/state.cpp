@@ -22,6 +22,7 @@
 
 #include "version.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cmath>
 #include <cstdlib>
@@ -130,6 +131,14 @@ START_API_FUNC
         DO_UPDATEPROPS();
         break;
 
+    case AL_EVENT_POLLING_SOFT:
+        context->mEventPolling.store(true, std::memory_order_release);
+        break;
+
+    case AL_EVENT_MESSAGES_SOFT:
+        context->mEventMessages.store(true, std::memory_order_relaxed);
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid enable property 0x%04x", capability);
     }
@@ -150,6 +159,16 @@ START_API_FUNC
         DO_UPDATEPROPS();
         break;
 
+    case AL_EVENT_POLLING_SOFT:
+        context->mEventPolling.store(false, std::memory_order_release);
+        /* Wake the event thread to deliver anything left unpolled. */
+        context->mEventSem.post();
+        break;
+
+    case AL_EVENT_MESSAGES_SOFT:
+        context->mEventMessages.store(false, std::memory_order_relaxed);
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid disable property 0x%04x", capability);
     }
@@ -170,6 +189,14 @@ START_API_FUNC
         value = context->mSourceDistanceModel ? AL_TRUE : AL_FALSE;
         break;
 
+    case AL_EVENT_POLLING_SOFT:
+        value = context->mEventPolling.load(std::memory_order_relaxed) ? AL_TRUE : AL_FALSE;
+        break;
+
+    case AL_EVENT_MESSAGES_SOFT:
+        value = context->mEventMessages.load(std::memory_order_relaxed) ? AL_TRUE : AL_FALSE;
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid is enabled property 0x%04x", capability);
     }
@@ -591,6 +618,12 @@ START_API_FUNC
         context->setError(AL_INVALID_VALUE, "NULL pointer");
     else switch(pname)
     {
+    case AL_RESAMPLER_VOICES_SOFT:
+        std::transform(context->mResamplerVoices.cbegin(), context->mResamplerVoices.cend(),
+            values, [](const std::atomic<ALuint> &count) -> ALint
+            { return static_cast<ALint>(count.load(std::memory_order_relaxed)); });
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid integer-vector property 0x%04x", pname);
     }
@@ -58,6 +58,7 @@
 #include "AL/efx.h"
 
 #include "al/auxeffectslot.h"
+#include "al/bus.h"
 #include "al/effect.h"
 #include "al/event.h"
 #include "al/filter.h"
@@ -95,6 +96,7 @@
 #include "pragmadefs.h"
 #include "ringbuffer.h"
 #include "strutils.h"
+#include "threadpool.h"
 #include "threads.h"
 #include "uhjfilter.h"
 #include "vecmat.h"
@@ -247,6 +249,9 @@ const struct {
     DECL(alcCaptureStart),
     DECL(alcCaptureStop),
     DECL(alcCaptureSamples),
+    DECL(alcCaptureReadVectorSOFT),
+    DECL(alcCaptureAdvanceSOFT),
+    DECL(alcCaptureCallbackSOFT),
 
     DECL(alcSetThreadContext),
     DECL(alcGetThreadContext),
@@ -255,6 +260,8 @@ const struct {
     DECL(alcIsRenderFormatSupportedSOFT),
     DECL(alcRenderSamplesSOFT),
 
+    DECL(alcRenderSamplesBatchSOFT),
+
     DECL(alcDevicePauseSOFT),
     DECL(alcDeviceResumeSOFT),
 
@@ -403,6 +410,18 @@ const struct {
     DECL(alGetBufferPtrSOFT),
     DECL(alGetBuffer3PtrSOFT),
     DECL(alGetBufferPtrvSOFT),
+
+    DECL(alBufferDataAsyncSOFT),
+
+    DECL(alPollEventsSOFT),
+
+    DECL(alGenBusesSOFT),
+    DECL(alDeleteBusesSOFT),
+    DECL(alIsBusSOFT),
+    DECL(alBusiSOFT),
+    DECL(alBusfSOFT),
+    DECL(alGetBusiSOFT),
+    DECL(alGetBusfSOFT),
 };
 #undef DECL
 
@@ -480,6 +499,8 @@ constexpr struct {
 
     DECL(ALC_OUTPUT_LIMITER_SOFT),
 
+    DECL(ALC_IDLE_SAMPLES_SOFT),
+
     DECL(ALC_NO_ERROR),
     DECL(ALC_INVALID_DEVICE),
     DECL(ALC_INVALID_CONTEXT),
@@ -806,7 +827,16 @@ constexpr struct {
     DECL(AL_BUFFER_CALLBACK_FUNCTION_SOFT),
     DECL(AL_BUFFER_CALLBACK_USER_PARAM_SOFT),
 
+    DECL(AL_EVENT_TYPE_BUFFER_LOADED_SOFT),
+    DECL(AL_BUFFER_LOADING_SOFT),
+
+    DECL(AL_EVENT_POLLING_SOFT),
+    DECL(AL_EVENT_MESSAGES_SOFT),
+
     DECL(AL_UNPACK_AMBISONIC_ORDER_SOFT),
+
+    DECL(AL_DIRECT_BUS_SOFT),
+    DECL(AL_BUS_TARGET_SOFT),
 };
 #undef DECL
 
@@ -850,6 +880,7 @@ constexpr ALchar alExtList[] =
     "AL_EXT_SOURCE_RADIUS "
     "AL_EXT_STEREO_ANGLES "
     "AL_LOKI_quadriphonic "
+    "AL_SOFTX_async_buffer_data "
     "AL_SOFT_bformat_ex "
     "AL_SOFTX_bformat_hoa "
     "AL_SOFT_block_alignment "
@@ -858,16 +889,20 @@ constexpr ALchar alExtList[] =
     "AL_SOFT_direct_channels "
     "AL_SOFT_direct_channels_remix "
     "AL_SOFTX_effect_target "
+    "AL_SOFTX_event_polling "
     "AL_SOFTX_events "
     "AL_SOFTX_filter_gain_ex "
     "AL_SOFT_gain_clamp_ex "
+    "AL_SOFTX_hrtf_lod "
     "AL_SOFT_loop_points "
     "AL_SOFTX_map_buffer "
     "AL_SOFT_MSADPCM "
+    "AL_SOFTX_resampler_lod "
     "AL_SOFT_source_latency "
     "AL_SOFT_source_length "
     "AL_SOFT_source_resampler "
-    "AL_SOFT_source_spatialize";
+    "AL_SOFT_source_spatialize "
+    "AL_SOFTX_submix_bus";
 
 std::atomic<ALCenum> LastNullDeviceError{ALC_NO_ERROR};
 
@@ -916,6 +951,10 @@ bool SuspendDefers{true};
 /* Initial seed for dithering. */
 constexpr ALuint DitherRNGSeed{22222u};
 
+/* Worker threads for rendering multiple loopback devices at once. */
+std::once_flag RenderPoolOnce{};
+std::unique_ptr<al::ThreadPool> RenderPool;
+
 
 /************************************************
  * ALC information
@@ -925,7 +964,9 @@ constexpr ALCchar alcNoDeviceExtList[] =
     "ALC_ENUMERATION_EXT "
     "ALC_EXT_CAPTURE "
     "ALC_EXT_thread_local_context "
-    "ALC_SOFT_loopback";
+    "ALC_SOFTX_capture_direct "
+    "ALC_SOFT_loopback "
+    "ALC_SOFTX_loopback_batch";
 constexpr ALCchar alcExtensionList[] =
     "ALC_ENUMERATE_ALL_EXT "
     "ALC_ENUMERATION_EXT "
@@ -934,9 +975,12 @@ constexpr ALCchar alcExtensionList[] =
     "ALC_EXT_disconnect "
     "ALC_EXT_EFX "
     "ALC_EXT_thread_local_context "
+    "ALC_SOFTX_capture_direct "
     "ALC_SOFT_device_clock "
+    "ALC_SOFTX_device_idle "
     "ALC_SOFT_HRTF "
     "ALC_SOFT_loopback "
+    "ALC_SOFTX_loopback_batch "
     "ALC_SOFT_output_limiter "
     "ALC_SOFT_pause_device";
 constexpr int alcMajorVersion{1};
@@ -1108,11 +1152,22 @@ void alc_initconfig(void)
             TrapALCError = !!GetConfigValueBool(nullptr, nullptr, "trap-alc-error", false);
     }
 
+    EffectSlotInstancing = !!GetConfigValueBool(nullptr, nullptr, "slot-instancing", false);
+
     if(auto boostopt = ConfigValueFloat(nullptr, "reverb", "boost"))
     {
         const float valf{std::isfinite(*boostopt) ? clampf(*boostopt, -24.0f, 24.0f) : 0.0f};
         ReverbBoost *= std::pow(10.0f, valf / 20.0f);
     }
+    if(auto lateopt = ConfigValueUInt(nullptr, "reverb", "late-rate"))
+        ReverbLateRate = *lateopt;
+    if(auto hilbertopt = ConfigValueStr(nullptr, "fshifter", "hilbert"))
+    {
+        if(al::strcasecmp(hilbertopt->c_str(), "iir") == 0)
+            FshifterIIRHilbert = true;
+        else if(al::strcasecmp(hilbertopt->c_str(), "fft") != 0)
+            ERR("Unexpected fshifter hilbert: %s\n", hilbertopt->c_str());
+    }
 
     auto BackendListEnd = std::end(BackendList);
     auto devopt = al::getenv("ALSOFT_DRIVERS");
@@ -1524,6 +1579,7 @@ void ALCcontext::processUpdates()
         if(!mListener.PropsClean.test_and_set(std::memory_order_acq_rel))
             UpdateListenerProps(this);
         UpdateAllEffectSlotProps(this);
+        UpdateAllBusProps(this);
         UpdateAllSourceProps(this);
 
         /* Now with all updates declared, let the mixer continue applying them
@@ -1642,6 +1698,23 @@ static inline void UpdateClockBase(ALCdevice *device)
     IncrementRef(device->MixCount);
 }
 
+/**
+ * Sets up the context's private mixing storage if the device mixes its
+ * contexts in parallel, or removes it if not. Must not be called while the
+ * context is being mixed.
+ */
+static void InitContextMixStorage(ALCdevice *device, ALCcontext *context)
+{
+    if(!device->mContextMixer)
+    {
+        context->mMixStorage = nullptr;
+        return;
+    }
+    if(!context->mMixStorage)
+        context->mMixStorage = std::make_unique<ContextMixStorage>();
+    context->mMixStorage->MixBuffer.resize(device->MixBuffer.size());
+}
+
 /**
  * Updates device parameters according to the attribute list (caller is
  * responsible for holding the list lock).
@@ -1982,10 +2055,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
 
     if(device->Uhj_Encoder)
     {
-        /* NOTE: Don't know why this has to be "copied" into a local constexpr
-         * variable to avoid a reference on Uhj2Encoder::sFilterSize...
-         */
-        constexpr size_t filter_len{Uhj2Encoder::sFilterSize};
+        const size_t filter_len{device->Uhj_Encoder->getDelay()};
         device->FixedLatency += nanoseconds{seconds{filter_len}} / device->Frequency;
     }
     if(device->mHrtfState)
@@ -2090,11 +2160,62 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
         TRACE("Output limiter enabled, %.4fdB limit\n", thrshld_dB);
     }
 
+    ALuint ctxthreads{ConfigValueUInt(device->DeviceName.c_str(), nullptr, "context-threads")
+        .value_or(1u)};
+    if(ctxthreads > 1)
+    {
+        /* The mixer thread mixes contexts too, so it counts as one. */
+        if(!device->mContextMixer || device->mContextMixer->size() != ctxthreads-1)
+        {
+            device->mContextMixer = std::make_unique<ContextMixer>(ctxthreads-1);
+        }
+        TRACE("Mixing contexts with %u threads\n", ctxthreads);
+    }
+    else
+        device->mContextMixer = nullptr;
+
+    if(GetConfigValueBool(device->DeviceName.c_str(), nullptr, "source-update-thread", false))
+    {
+        /* The update thread only handles one context at a time. */
+        if(device->mContextMixer)
+        {
+            WARN("Source update thread disabled with parallel context mixing\n");
+            device->mSourceUpdater = nullptr;
+        }
+        else
+        {
+            if(!device->mSourceUpdater)
+                device->mSourceUpdater = std::make_unique<SourceUpdateThread>();
+            TRACE("Source update thread enabled\n");
+        }
+    }
+    else
+        device->mSourceUpdater = nullptr;
+
+    device->mResamplerLodGain = 0.0f;
+    if(auto lodopt = ConfigValueFloat(device->DeviceName.c_str(), nullptr, "resampler-lod-gain"))
+    {
+        device->mResamplerLodGain = std::pow(10.0f, *lodopt / 20.0f);
+        TRACE("Resampler level of detail: gain limit %f\n", device->mResamplerLodGain);
+    }
+
+    device->mIdleTimeout = 0u;
+    if(auto idleopt = ConfigValueUInt(device->DeviceName.c_str(), nullptr, "idle-timeout"))
+    {
+        device->mIdleTimeout = static_cast<ALuint>(minu64(uint64_t{*idleopt} *
+            device->Frequency / 1000, std::numeric_limits<ALuint>::max()));
+        TRACE("Idle timeout: %ums\n", *idleopt);
+    }
+    device->mSilentSamples = 0u;
+    device->mIdle = false;
+
     TRACE("Fixed device latency: %" PRId64 "ns\n", int64_t{device->FixedLatency.count()});
 
     FPUCtl mixer_mode{};
     for(ALCcontext *context : *device->mContexts.load())
     {
+        InitContextMixStorage(device, context);
+
         if(ALeffectslot *slot{context->mDefaultSlot.get()})
         {
             aluInitEffectPanning(slot, device);
@@ -2128,6 +2249,14 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
         }
         slotlock.unlock();
 
+        std::unique_lock<std::mutex> buslock{context->mBusLock};
+        for(ALbus *bus : *context->mActiveBuses.load(std::memory_order_relaxed))
+        {
+            bus->initMix(device);
+            bus->updateProps(context);
+        }
+        buslock.unlock();
+
         const ALuint num_sends{device->NumAuxSends};
         std::unique_lock<std::mutex> srclock{context->mSourceLock};
         for(auto &sublist : context->mSourceList)
@@ -2229,14 +2358,12 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
                 voice->mFlags &= ~VOICE_IS_AMBISONIC;
             }
 
-            if(device->AvgSpeakerDist > 0.0f)
-            {
-                /* Reinitialize the NFC filters for new parameters. */
-                const float w1{SPEEDOFSOUNDMETRESPERSEC /
-                    (device->AvgSpeakerDist * static_cast<float>(device->Frequency))};
-                for(auto &chandata : voice->mChans)
-                    chandata.mDryParams.NFCtrlFilter.init(w1);
-            }
+            /* Reinitialize the HRTF and NFC filters for the new output. The
+             * voice starts over on its new path, so it has nothing to fade out.
+             */
+            voice->initDirectFilters(device);
+            voice->mFlags &= ~(VOICE_HAS_HRTF | VOICE_HAS_NFC | VOICE_HRTF_PANNED
+                | VOICE_HRTF_SWITCHED);
         }
         srclock.unlock();
 
@@ -2352,6 +2479,32 @@ ALCcontext::~ALCcontext()
     mSourceList.clear();
     mNumSources = 0;
 
+    count = 0;
+    ALbusProps *bprops{mFreeBusProps.exchange(nullptr, std::memory_order_acquire)};
+    while(bprops)
+    {
+        ALbusProps *next{bprops->next.load(std::memory_order_relaxed)};
+        delete bprops;
+        bprops = next;
+        ++count;
+    }
+    TRACE("Freed %zu bus property object%s\n", count, (count==1)?"":"s");
+
+    if(ALbusArray *curarray{mActiveBuses.exchange(nullptr, std::memory_order_relaxed)})
+    {
+        al::destroy_n(curarray->end(), curarray->size());
+        delete curarray;
+    }
+
+    count = std::accumulate(mBusList.cbegin(), mBusList.cend(), size_t{0u},
+        [](size_t cur, const BusSubList &sublist) noexcept -> size_t
+        { return cur + static_cast<ALuint>(POPCNT64(~sublist.FreeMask)); }
+    );
+    if(count > 0)
+        WARN("%zu Bus%s not deleted\n", count, (count==1)?"":"es");
+    mBusList.clear();
+    mNumBuses = 0;
+
     count = 0;
     ALeffectslotProps *eprops{mFreeEffectslotProps.exchange(nullptr, std::memory_order_acquire)};
     while(eprops)
@@ -2453,6 +2606,7 @@ void ALCcontext::init()
         (*auxslots)[0] = mDefaultSlot.get();
     }
     mActiveAuxSlots.store(auxslots, std::memory_order_relaxed);
+    mActiveBuses.store(ALbus::CreatePtrArray(0), std::memory_order_relaxed);
 
     allocVoiceChanges(1);
     {
@@ -2475,7 +2629,7 @@ void ALCcontext::init()
     mListener.Params.mDistanceModel = mDistanceModel;
 
 
-    mAsyncEvents = RingBuffer::Create(511, sizeof(AsyncEvent), false);
+    mAsyncEvents = RingBuffer::Create(2047, sizeof(AsyncEvent), false);
     StartEventThrd(this);
 
 
@@ -3027,6 +3181,11 @@ static size_t GetIntegerv(ALCdevice *device, ALCenum param, const al::span<int>
         values[0] = device->Limiter ? ALC_TRUE : ALC_FALSE;
         return 1;
 
+    case ALC_IDLE_SAMPLES_SOFT:
+        values[0] = static_cast<int>(minu64(device->mIdleSamples.load(std::memory_order_relaxed),
+            std::numeric_limits<int>::max()));
+        return 1;
+
     case ALC_MAX_AMBISONIC_ORDER_SOFT:
         values[0] = MAX_AMBI_ORDER;
         return 1;
@@ -3162,6 +3321,10 @@ START_API_FUNC
         }
         break;
 
+    case ALC_IDLE_SAMPLES_SOFT:
+        *values = static_cast<int64_t>(dev->mIdleSamples.load(std::memory_order_relaxed));
+        break;
+
     case ALC_DEVICE_CLOCK_LATENCY_SOFT:
         if(size < 2)
             alcSetError(dev.get(), ALC_INVALID_VALUE);
@@ -3283,6 +3446,7 @@ START_API_FUNC
 
     ContextRef context{new ALCcontext{dev}};
     context->init();
+    InitContextMixStorage(dev.get(), context.get());
 
     if(auto volopt = ConfigValueFloat(dev->DeviceName.c_str(), nullptr, "volume-adjust"))
     {
@@ -3886,6 +4050,101 @@ START_API_FUNC
 }
 END_API_FUNC
 
+/* The direct capture functions read straight from the backend's ring buffer.
+ * They don't take the device's state lock, so they may be called from the
+ * capture callback, but like the ring buffer they only allow a single reader.
+ */
+ALC_API ALCsizei ALC_APIENTRY alcCaptureReadVectorSOFT(ALCdevice *device, const ALCvoid **buffers, ALCsizei *samples)
+START_API_FUNC
+{
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type != Capture)
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return 0;
+    }
+    if(!buffers || !samples)
+    {
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+        return 0;
+    }
+    buffers[0] = buffers[1] = nullptr;
+    samples[0] = samples[1] = 0;
+
+    BackendBase *backend{dev->Backend.get()};
+    RingBuffer *ring{backend->getCaptureRing()};
+    if(!ring)
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return 0;
+    }
+
+    /* Some backends only move new samples into the ring when queried. */
+    backend->availableSamples();
+
+    auto vec = ring->getReadVector();
+    buffers[0] = vec.first.buf;
+    samples[0] = static_cast<ALCsizei>(vec.first.len);
+    if(vec.second.len > 0)
+    {
+        buffers[1] = vec.second.buf;
+        samples[1] = static_cast<ALCsizei>(vec.second.len);
+    }
+    return samples[0] + samples[1];
+}
+END_API_FUNC
+
+ALC_API void ALC_APIENTRY alcCaptureAdvanceSOFT(ALCdevice *device, ALCsizei samples)
+START_API_FUNC
+{
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type != Capture)
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return;
+    }
+
+    RingBuffer *ring{dev->Backend->getCaptureRing()};
+    if(!ring)
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+    else if(samples < 0 || static_cast<size_t>(samples) > ring->readSpace())
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+    else
+        ring->readAdvance(static_cast<size_t>(samples));
+}
+END_API_FUNC
+
+ALC_API void ALC_APIENTRY alcCaptureCallbackSOFT(ALCdevice *device, LPALCCAPTURECALLBACKTYPESOFT callback, ALCvoid *userptr, ALCsizei chunk)
+START_API_FUNC
+{
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type != Capture)
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return;
+    }
+    if(callback && chunk < 1)
+    {
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+        return;
+    }
+
+    std::lock_guard<std::mutex> _{dev->StateLock};
+    /* The callback needs the ring to read from, and a backend that signals
+     * when samples arrive.
+     */
+    if(dev->Flags.get<DeviceRunning>() || (callback && (!dev->Backend->getCaptureRing()
+        || !dev->Backend->callsCaptureReady())))
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return;
+    }
+    dev->mCaptureCallback = callback;
+    dev->mCaptureUserPtr = callback ? userptr : nullptr;
+    dev->mCaptureChunk = callback ? static_cast<ALCuint>(chunk) : 0u;
+}
+END_API_FUNC
+
 
 /************************************************
  * ALC loopback functions
@@ -3994,6 +4253,75 @@ START_API_FUNC
 END_API_FUNC
 
 
+/**
+ * Renders samples for multiple loopback devices, each into its own buffer,
+ * concurrently. Returns once all devices are rendered. If renderTimes is not
+ * null, it receives the time in nanoseconds spent rendering each device.
+ */
+FORCE_ALIGN ALC_API void ALC_APIENTRY alcRenderSamplesBatchSOFT(ALCsizei count, ALCdevice *const *devices, ALCvoid *const *buffers, ALCsizei samples, ALCint64SOFT *renderTimes)
+START_API_FUNC
+{
+    if(count < 0 || samples < 0 || (count > 0 && (!devices || !buffers)))
+    {
+        alcSetError(nullptr, ALC_INVALID_VALUE);
+        return;
+    }
+    if(count == 0) return;
+
+    al::vector<DeviceRef> devlist;
+    devlist.reserve(static_cast<ALuint>(count));
+    for(ALCsizei i{0};i < count;++i)
+    {
+        DeviceRef dev{VerifyDevice(devices[i])};
+        if(!dev || dev->Type != Loopback)
+        {
+            alcSetError(dev.get(), ALC_INVALID_DEVICE);
+            return;
+        }
+        if(samples > 0 && buffers[i] == nullptr)
+        {
+            alcSetError(dev.get(), ALC_INVALID_VALUE);
+            return;
+        }
+        /* A device can't be rendered by more than one thread at a time. */
+        auto is_dev = [&dev](const DeviceRef &other) noexcept -> bool
+        { return other.get() == dev.get(); };
+        if(std::find_if(devlist.cbegin(), devlist.cend(), is_dev) != devlist.cend())
+        {
+            alcSetError(dev.get(), ALC_INVALID_VALUE);
+            return;
+        }
+        devlist.emplace_back(std::move(dev));
+    }
+
+    std::call_once(RenderPoolOnce, []() -> void
+    {
+        ALuint numthreads{std::thread::hardware_concurrency()};
+        if(auto thrdopt = ConfigValueUInt(nullptr, nullptr, "render-threads"))
+            numthreads = *thrdopt;
+        /* The calling thread renders too, so it counts as one. */
+        numthreads = maxu(numthreads, 1u) - 1u;
+        TRACE("Creating %u loopback render thread%s\n", numthreads, (numthreads==1)?"":"s");
+        RenderPool = std::make_unique<al::ThreadPool>(numthreads, "alsoft-render");
+    });
+
+    auto render_device = [&devlist,buffers,samples,renderTimes](size_t idx) -> void
+    {
+        ALCdevice *device{devlist[idx].get()};
+        auto start = std::chrono::steady_clock::now();
+        aluMixData(device, buffers[idx], static_cast<ALuint>(samples), device->channelsFromFmt());
+        if(renderTimes)
+        {
+            auto end = std::chrono::steady_clock::now();
+            renderTimes[idx] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                end - start).count();
+        }
+    };
+    RenderPool->parallelFor(devlist.size(), render_device);
+}
+END_API_FUNC
+
+
 /************************************************
  * ALC DSP pause/resume functions
  ************************************************/
@@ -38,6 +38,8 @@ struct ALfilter;
 struct BackendBase;
 struct Compressor;
 struct EffectState;
+class ContextMixer;
+class SourceUpdateThread;
 struct Uhj2Encoder;
 struct bs2b;
 
@@ -196,6 +198,8 @@ enum {
 
 struct ALCdevice : public al::intrusive_ref<ALCdevice> {
     std::atomic<bool> Connected{true};
+    /* Set once, when the device becomes disconnected. */
+    char DisconnectMsg[256]{};
     const DeviceType Type{};
 
     ALuint Frequency{};
@@ -225,6 +229,13 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
 
     std::atomic<ALCenum> LastError{ALC_NO_ERROR};
 
+    /* Capture callback, called from the backend's thread once at least
+     * mCaptureChunk samples are available. Only set while capture is stopped.
+     */
+    LPALCCAPTURECALLBACKTYPESOFT mCaptureCallback{nullptr};
+    void *mCaptureUserPtr{nullptr};
+    ALCuint mCaptureChunk{0u};
+
     // Maximum number of sources that can be created
     ALuint SourcesMax{};
     // Maximum number of slots that can be created
@@ -286,6 +297,13 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
     std::unique_ptr<DirectHrtfState> mHrtfState;
     al::intrusive_ptr<HrtfStore> mHrtf;
 
+    /* With full HRTF rendering, sources quieter than this gain or farther
+     * than this distance (0 for no limit) are panned into the ambisonic mix
+     * instead of getting their own HRTF filter.
+     */
+    float mHrtfLodGain{0.0f};
+    float mHrtfLodDistance{0.0f};
+
     /* Ambisonic-to-UHJ encoder */
     std::unique_ptr<Uhj2Encoder> Uhj_Encoder;
 
@@ -300,6 +318,28 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
 
     std::unique_ptr<Compressor> Limiter;
 
+    /* Thread for calculating source parameters alongside the mix, if enabled. */
+    std::unique_ptr<SourceUpdateThread> mSourceUpdater;
+
+    /* Threads for mixing multiple contexts in parallel, if enabled. */
+    std::unique_ptr<ContextMixer> mContextMixer;
+
+    /* Voices with a loudest high-frequency gain below this (0 for no limit)
+     * use cheaper resamplers.
+     */
+    float mResamplerLodGain{0.0f};
+
+    /* After the output stays silent with no voices playing for this many
+     * samples (0 to never idle), the mixer stops and writes silence until a
+     * voice starts.
+     */
+    ALuint mIdleTimeout{0u};
+    ALuint mSilentSamples{0u};
+    bool mIdle{false};
+
+    /* Total number of samples output while idle. */
+    std::atomic<uint64_t> mIdleSamples{0u};
+
     /* Delay buffers used to compensate for speaker distances. */
     DistanceComp ChannelDelay;
 
@@ -360,6 +400,10 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
 
 #define RECORD_THREAD_NAME "alsoft-record"
 
+#define SOURCE_UPDATE_THREAD_NAME "alsoft-update"
+
+#define CONTEXT_MIXER_THREAD_NAME "alsoft-ctxmix"
+
 
 extern int RTPrioLevel;
 void SetRTPriority(void);
@@ -1,6 +1,7 @@
 #ifndef ALCONTEXT_H
 #define ALCONTEXT_H
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -23,6 +24,8 @@
 #include "vector.h"
 #include "voice.h"
 
+struct ALbus;
+struct ALbusProps;
 struct ALeffectslot;
 struct ALeffectslotProps;
 struct ALsource;
@@ -98,6 +101,21 @@ struct EffectSlotSubList {
     { std::swap(FreeMask, rhs.FreeMask); std::swap(EffectSlots, rhs.EffectSlots); return *this; }
 };
 
+struct BusSubList {
+    uint64_t FreeMask{~0_u64};
+    ALbus *Buses{nullptr}; /* 64 */
+
+    BusSubList() noexcept = default;
+    BusSubList(const BusSubList&) = delete;
+    BusSubList(BusSubList&& rhs) noexcept : FreeMask{rhs.FreeMask}, Buses{rhs.Buses}
+    { rhs.FreeMask = ~0_u64; rhs.Buses = nullptr; }
+    ~BusSubList();
+
+    BusSubList& operator=(const BusSubList&) = delete;
+    BusSubList& operator=(BusSubList&& rhs) noexcept
+    { std::swap(FreeMask, rhs.FreeMask); std::swap(Buses, rhs.Buses); return *this; }
+};
+
 struct ALCcontext : public al::intrusive_ref<ALCcontext> {
     al::vector<SourceSubList> mSourceList;
     ALuint mNumSources{0};
@@ -107,6 +125,10 @@ struct ALCcontext : public al::intrusive_ref<ALCcontext> {
     ALuint mNumEffectSlots{0u};
     std::mutex mEffectSlotLock;
 
+    al::vector<BusSubList> mBusList;
+    ALuint mNumBuses{0u};
+    std::mutex mBusLock;
+
     std::atomic<ALenum> mLastError{AL_NO_ERROR};
 
     DistanceModel mDistanceModel{DistanceModel::Default};
@@ -126,6 +148,16 @@ struct ALCcontext : public al::intrusive_ref<ALCcontext> {
      */
     RefCount mUpdateCount{0u};
     std::atomic<bool> mHoldUpdates{false};
+    /* Set when a listener, context, or effect slot update needs all sources
+     * updated, for the device's source update thread.
+     */
+    bool mForceSourceUpdates{false};
+
+    /* The number of voices using each resampler as of the last mix. */
+    std::array<std::atomic<ALuint>,static_cast<size_t>(Resampler::Max)+1> mResamplerVoices{};
+
+    /* Private mixing storage, when the device mixes its contexts in parallel. */
+    std::unique_ptr<ContextMixStorage> mMixStorage;
 
     float mGainBoost{1.0f};
 
@@ -138,6 +170,7 @@ struct ALCcontext : public al::intrusive_ref<ALCcontext> {
     std::atomic<ALlistenerProps*> mFreeListenerProps{nullptr};
     std::atomic<VoicePropsItem*> mFreeVoiceProps{nullptr};
     std::atomic<ALeffectslotProps*> mFreeEffectslotProps{nullptr};
+    std::atomic<ALbusProps*> mFreeBusProps{nullptr};
 
     /* Asynchronous voice change actions are processed as a linked list of
      * VoiceChange objects by the mixer, which is atomically appended to.
@@ -181,6 +214,9 @@ struct ALCcontext : public al::intrusive_ref<ALCcontext> {
     using ALeffectslotArray = al::FlexArray<ALeffectslot*>;
     std::atomic<ALeffectslotArray*> mActiveAuxSlots{nullptr};
 
+    using ALbusArray = al::FlexArray<ALbus*>;
+    std::atomic<ALbusArray*> mActiveBuses{nullptr};
+
     std::thread mEventThread;
     al::semaphore mEventSem;
     std::unique_ptr<RingBuffer> mAsyncEvents;
@@ -188,6 +224,11 @@ struct ALCcontext : public al::intrusive_ref<ALCcontext> {
     std::mutex mEventCbLock;
     ALEVENTPROCSOFT mEventCb{};
     void *mEventParam{nullptr};
+    /* When polling, events are left for alPollEventsSOFT instead of being
+     * delivered by the event thread.
+     */
+    std::atomic<bool> mEventPolling{false};
+    std::atomic<bool> mEventMessages{true};
 
     /* Default effect slot */
     std::unique_ptr<ALeffectslot> mDefaultSlot;
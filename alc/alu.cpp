@@ -22,6 +22,10 @@
 
 #include "alu.h"
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
 #include <array>
 #include <atomic>
@@ -38,6 +42,7 @@
 #include <memory>
 #include <new>
 #include <numeric>
+#include <type_traits>
 #include <utility>
 
 #include "AL/al.h"
@@ -46,6 +51,7 @@
 
 #include "al/auxeffectslot.h"
 #include "al/buffer.h"
+#include "al/bus.h"
 #include "al/effect.h"
 #include "al/event.h"
 #include "al/listener.h"
@@ -101,6 +107,8 @@ struct LerpTag;
 struct CubicTag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
+struct FastPolyBSincTag;
 
 
 static_assert(!(MAX_RESAMPLER_PADDING&1) && MAX_RESAMPLER_PADDING >= BSINC_POINTS_MAX,
@@ -195,6 +203,9 @@ inline void BsincPrepare(const ALuint increment, BsincState *state, const BSincT
     state->filter = table->Tab + table->filterOffset[si];
 }
 
+/* Mask for the fractional position bits between bsinc filter phases. */
+constexpr ALuint BSINC_PHASE_MASK{(1u<<(FRACTIONBITS-BSINC_PHASE_BITS)) - 1};
+
 inline ResamplerFunc SelectResampler(Resampler resampler, ALuint increment)
 {
     switch(resampler)
@@ -224,6 +235,24 @@ inline ResamplerFunc SelectResampler(Resampler resampler, ALuint increment)
             /* fall-through */
         case Resampler::FastBSinc12:
         case Resampler::FastBSinc24:
+            /* An increment that's a whole number of filter phases keeps the
+             * position on a phase (given it starts on one), so the phase
+             * interpolation can be skipped. This only covers ratios like 2:1
+             * or 3:4; the common 44.1kHz<->48kHz ratios step through every
+             * fractional position and still use the general resampler.
+             */
+            if(!(increment&BSINC_PHASE_MASK))
+            {
+#ifdef HAVE_NEON
+                if((CPUCapFlags&CPU_CAP_NEON))
+                    return Resample_<FastPolyBSincTag,NEONTag>;
+#endif
+#ifdef HAVE_SSE
+                if((CPUCapFlags&CPU_CAP_SSE))
+                    return Resample_<FastPolyBSincTag,SSETag>;
+#endif
+                return Resample_<FastPolyBSincTag,CTag>;
+            }
 #ifdef HAVE_NEON
             if((CPUCapFlags&CPU_CAP_NEON))
                 return Resample_<FastBSincTag,NEONTag>;
@@ -234,6 +263,18 @@ inline ResamplerFunc SelectResampler(Resampler resampler, ALuint increment)
 #endif
             return Resample_<FastBSincTag,CTag>;
         }
+        if(!(increment&BSINC_PHASE_MASK))
+        {
+#ifdef HAVE_NEON
+            if((CPUCapFlags&CPU_CAP_NEON))
+                return Resample_<PolyBSincTag,NEONTag>;
+#endif
+#ifdef HAVE_SSE
+            if((CPUCapFlags&CPU_CAP_SSE))
+                return Resample_<PolyBSincTag,SSETag>;
+#endif
+            return Resample_<PolyBSincTag,CTag>;
+        }
 #ifdef HAVE_NEON
         if((CPUCapFlags&CPU_CAP_NEON))
             return Resample_<BSincTag,NEONTag>;
@@ -442,6 +483,37 @@ bool CalcListenerParams(ALCcontext *Context)
     return true;
 }
 
+void CalcBusParams(ALbus *bus, ALCcontext *context)
+{
+    ALbusProps *props{bus->Params.Update.exchange(nullptr, std::memory_order_acq_rel)};
+    if(!props) return;
+
+    bus->Params.Gain = props->Gain;
+    bus->Params.Target = props->Target;
+
+    bus->Params.FilterType = AF_None;
+    if(props->GainHF != 1.0f) bus->Params.FilterType |= AF_LowPass;
+    if(props->GainLF != 1.0f) bus->Params.FilterType |= AF_HighPass;
+
+    if(!bus->mChans.empty())
+    {
+        const auto Frequency = static_cast<float>(context->mDevice->Frequency);
+        auto &lowpass = bus->mChans[0].LowPass;
+        auto &highpass = bus->mChans[0].HighPass;
+        lowpass.setParamsFromSlope(BiquadType::HighShelf, props->HFReference/Frequency,
+            props->GainHF, 1.0f);
+        highpass.setParamsFromSlope(BiquadType::LowShelf, props->LFReference/Frequency,
+            props->GainLF, 1.0f);
+        for(size_t c{1};c < bus->mChans.size();c++)
+        {
+            bus->mChans[c].LowPass.copyParamsFrom(lowpass);
+            bus->mChans[c].HighPass.copyParamsFrom(highpass);
+        }
+    }
+
+    AtomicReplaceHead(context->mFreeBusProps, props);
+}
+
 bool CalcEffectSlotParams(ALeffectslot *slot, ALeffectslot **sorted_slots, ALCcontext *context)
 {
     ALeffectslotProps *props{slot->Params.Update.exchange(nullptr, std::memory_order_acq_rel)};
@@ -480,6 +552,11 @@ bool CalcEffectSlotParams(ALeffectslot *slot, ALeffectslot **sorted_slots, ALCco
     props->State = nullptr;
     EffectState *oldstate{slot->Params.mEffectState};
     slot->Params.mEffectState = state;
+    /* A new state may also change which slots share one, so force a re-sort
+     * for that too.
+     */
+    if(state != oldstate)
+        *sorted_slots = nullptr;
 
     /* Only release the old state if it won't get deleted, since we can't be
      * deleting/freeing anything in the mixer.
@@ -700,6 +777,93 @@ void AmbiRotator(std::array<std::array<float,MAX_AMBI_CHANNELS>,MAX_AMBI_CHANNEL
 
 struct GainTriplet { float Base, HF, LF; };
 
+/* Decides if a voice gets its own HRTF filter with full HRTF rendering, or is
+ * panned into the dry mix to be filtered with everything else.
+ */
+bool UseVoiceHrtf(const VoiceProps *props, const bool had_hrtf, const float Distance,
+    const float Gain, const ALCdevice *Device)
+{
+    /* The voice's own HRTF filter mixes straight into the device's HRTF
+     * accumulation buffer, so it can't feed a bus.
+     */
+    if(props->Direct.Bus)
+        return false;
+    if(props->mHrtfMode != HrtfMode::Auto)
+        return props->mHrtfMode == HrtfMode::On;
+
+    /* Voices already using HRTF keep it until they're 3dB quieter, or 10%
+     * farther, than the limits. This avoids switching back and forth when
+     * near them.
+     */
+    float gain_limit{Device->mHrtfLodGain};
+    float dist_limit{Device->mHrtfLodDistance};
+    if(had_hrtf)
+    {
+        gain_limit *= 0.707945784f/*10^(-3/20)*/;
+        dist_limit *= 1.1f;
+    }
+    if(gain_limit > 0.0f && Gain < gain_limit)
+        return false;
+    if(dist_limit > 0.0f && Distance > dist_limit)
+        return false;
+    return true;
+}
+
+/* Sets the voice's resampler. With a resampler level-of-detail limit, voices
+ * step down from the requested resampler as their loudest high-frequency
+ * output drops below it: to a 12-point bsinc, then cubic at 12dB below, then
+ * linear at 24dB below.
+ */
+void PrepareVoiceResampler(Voice *voice, const VoiceProps *props, const GainTriplet &DryGain,
+    const al::span<const GainTriplet,MAX_SENDS> WetGain, ALeffectslot *(&SendSlots)[MAX_SENDS],
+    const ALCdevice *Device)
+{
+    Resampler resampler{props->mResampler};
+    if(const float limit{Device->mResamplerLodGain})
+    {
+        float level{DryGain.Base * DryGain.HF};
+        for(ALuint i{0};i < Device->NumAuxSends;++i)
+        {
+            if(SendSlots[i])
+                level = maxf(level, WetGain[i].Base * WetGain[i].HF);
+        }
+        auto get_lod = [limit](const float lvl) noexcept -> ALuint
+        {
+            if(lvl >= limit) return 0;
+            if(lvl >= limit*0.25f) return 1;
+            if(lvl >= limit*0.0625f) return 2;
+            return 3;
+        };
+        /* Stepping back up needs the level to be 3dB above the limit, to
+         * avoid switching back and forth when near it.
+         */
+        ALuint lod{get_lod(level)};
+        if(lod < voice->mResamplerLod)
+            lod = minu(voice->mResamplerLod, get_lod(level*0.707945784f/*10^(-3/20)*/));
+        voice->mResamplerLod = lod;
+
+        if(lod >= 1)
+        {
+            if(resampler == Resampler::BSinc24) resampler = Resampler::BSinc12;
+            else if(resampler == Resampler::FastBSinc24) resampler = Resampler::FastBSinc12;
+        }
+        if(lod >= 2 && resampler > Resampler::Cubic)
+            resampler = Resampler::Cubic;
+        if(lod >= 3 && resampler > Resampler::Linear)
+            resampler = Resampler::Linear;
+    }
+
+    /* Changing resamplers on a playing voice crossfades from the old one. */
+    if(voice->mResampler && resampler != voice->mResamplerType
+        && (voice->mFlags&VOICE_IS_FADING) && !voice->mPrevResampler)
+    {
+        voice->mPrevResampler = voice->mResampler;
+        voice->mPrevResampleState = voice->mResampleState;
+    }
+    voice->mResamplerType = resampler;
+    voice->mResampler = PrepareResampler(resampler, voice->mStep, &voice->mResampleState);
+}
+
 void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, const float zpos,
     const float Distance, const float Spread, const GainTriplet &DryGain,
     const al::span<const GainTriplet,MAX_SENDS> WetGain, ALeffectslot *(&SendSlots)[MAX_SENDS],
@@ -752,15 +916,17 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
     const size_t num_channels{voice->mChans.size()};
     ASSUME(num_channels > 0);
 
+    for(auto &hrtfparams : voice->mHrtfChans)
+        hrtfparams.Target = HrtfFilter{};
     for(auto &chandata : voice->mChans)
     {
-        chandata.mDryParams.Hrtf.Target = HrtfFilter{};
         chandata.mDryParams.Gains.Target.fill(0.0f);
         std::for_each(chandata.mWetParams.begin(), chandata.mWetParams.begin()+NumSends,
             [](SendParams &params) -> void { params.Gains.Target.fill(0.0f); });
     }
 
-    DirectMode DirectChannels{props->DirectChannels};
+    /* Voices feeding a bus are always panned into the bus's mix. */
+    DirectMode DirectChannels{props->Direct.Bus ? DirectMode::Off : props->DirectChannels};
     const ChanMap *chans{nullptr};
     float downmix_gain{1.0f};
     switch(voice->mFmtChannels)
@@ -819,7 +985,8 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         break;
     }
 
-    voice->mFlags &= ~(VOICE_HAS_HRTF | VOICE_HAS_NFC);
+    const ALuint prev_hrtf{voice->mFlags & (VOICE_HAS_HRTF | VOICE_HRTF_PANNED)};
+    voice->mFlags &= ~(VOICE_HAS_HRTF | VOICE_HAS_NFC | VOICE_HRTF_PANNED);
     if(voice->mFmtChannels == FmtBFormat2D || voice->mFmtChannels == FmtBFormat3D)
     {
         /* Special handling for B-Format sources. */
@@ -840,7 +1007,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                 const float w0{SPEEDOFSOUNDMETRESPERSEC / (mdist * Frequency)};
 
                 /* Only need to adjust the first channel of a B-Format source. */
-                voice->mChans[0].mDryParams.NFCtrlFilter.adjust(w0);
+                voice->mNfcChans[0].adjust(w0);
 
                 voice->mFlags |= VOICE_HAS_NFC;
             }
@@ -884,7 +1051,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                  * is what we want for FOA input. The first channel may have
                  * been previously re-adjusted if panned, so reset it.
                  */
-                voice->mChans[0].mDryParams.NFCtrlFilter.adjust(0.0f);
+                voice->mNfcChans[0].adjust(0.0f);
 
                 voice->mFlags |= VOICE_HAS_NFC;
             }
@@ -996,7 +1163,8 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
             }
         }
     }
-    else if(Device->mRenderMode == HrtfRender)
+    else if(Device->mRenderMode == HrtfRender
+        && UseVoiceHrtf(props, (prev_hrtf&VOICE_HAS_HRTF) != 0, Distance, DryGain.Base, Device))
     {
         /* Full HRTF rendering. Skip the virtual channels and render to the
          * real outputs.
@@ -1012,16 +1180,16 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
              * source direction.
              */
             GetHrtfCoeffs(Device->mHrtf.get(), ev, az, Distance, Spread,
-                voice->mChans[0].mDryParams.Hrtf.Target.Coeffs,
-                voice->mChans[0].mDryParams.Hrtf.Target.Delay);
-            voice->mChans[0].mDryParams.Hrtf.Target.Gain = DryGain.Base * downmix_gain;
+                voice->mHrtfChans[0].Target.Coeffs,
+                voice->mHrtfChans[0].Target.Delay);
+            voice->mHrtfChans[0].Target.Gain = DryGain.Base * downmix_gain;
 
             /* Remaining channels use the same results as the first. */
             for(size_t c{1};c < num_channels;c++)
             {
                 /* Skip LFE */
                 if(chans[c].channel == LFE) continue;
-                voice->mChans[c].mDryParams.Hrtf.Target = voice->mChans[0].mDryParams.Hrtf.Target;
+                voice->mHrtfChans[c].Target = voice->mHrtfChans[0].Target;
             }
 
             /* Calculate the directional coefficients once, which apply to all
@@ -1059,9 +1227,9 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                  */
                 GetHrtfCoeffs(Device->mHrtf.get(), chans[c].elevation, chans[c].angle,
                     std::numeric_limits<float>::infinity(), Spread,
-                    voice->mChans[c].mDryParams.Hrtf.Target.Coeffs,
-                    voice->mChans[c].mDryParams.Hrtf.Target.Delay);
-                voice->mChans[c].mDryParams.Hrtf.Target.Gain = DryGain.Base;
+                    voice->mHrtfChans[c].Target.Coeffs,
+                    voice->mHrtfChans[c].Target.Delay);
+                voice->mHrtfChans[c].Target.Gain = DryGain.Base;
 
                 /* Normal panning for auxiliary sends. */
                 const auto coeffs = CalcAngleCoeffs(chans[c].angle, chans[c].elevation, Spread);
@@ -1094,7 +1262,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
 
                 /* Adjust NFC filters. */
                 for(size_t c{0};c < num_channels;c++)
-                    voice->mChans[c].mDryParams.NFCtrlFilter.adjust(w0);
+                    voice->mNfcChans[c].adjust(w0);
 
                 voice->mFlags |= VOICE_HAS_NFC;
             }
@@ -1145,7 +1313,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                  */
                 constexpr float w0{0.0f};
                 for(size_t c{0};c < num_channels;c++)
-                    voice->mChans[c].mDryParams.NFCtrlFilter.adjust(w0);
+                    voice->mNfcChans[c].adjust(w0);
 
                 voice->mFlags |= VOICE_HAS_NFC;
             }
@@ -1178,6 +1346,32 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                 }
             }
         }
+
+        if(Device->mRenderMode == HrtfRender)
+            voice->mFlags |= VOICE_HRTF_PANNED;
+    }
+
+    /* When a voice switches between its own HRTF filter and panning, the new
+     * path fades in from silence while the mixer fades out the old one.
+     */
+    const ALuint cur_hrtf{voice->mFlags & (VOICE_HAS_HRTF | VOICE_HRTF_PANNED)};
+    if(prev_hrtf && cur_hrtf && prev_hrtf != cur_hrtf && (voice->mFlags&VOICE_IS_FADING))
+    {
+        voice->mFlags |= VOICE_HRTF_SWITCHED;
+        if((cur_hrtf&VOICE_HAS_HRTF))
+        {
+            for(auto &hrtfparams : voice->mHrtfChans)
+            {
+                hrtfparams.Old = hrtfparams.Target;
+                hrtfparams.Old.Gain = 0.0f;
+                hrtfparams.History.fill(0.0f);
+            }
+        }
+        else
+        {
+            for(auto &chandata : voice->mChans)
+                chandata.mDryParams.Gains.Current.fill(0.0f);
+        }
     }
 
     {
@@ -1224,7 +1418,7 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcon
     const ALCdevice *Device{ALContext->mDevice.get()};
     ALeffectslot *SendSlots[MAX_SENDS];
 
-    voice->mDirect.Buffer = Device->Dry.Buffer;
+    voice->mDirect.Buffer = props->Direct.Bus ? props->Direct.Bus->Buffer : Device->Dry.Buffer;
     for(ALuint i{0};i < Device->NumAuxSends;i++)
     {
         SendSlots[i] = props->Send[i].Slot;
@@ -1246,7 +1440,6 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcon
         voice->mStep = MAX_PITCH<<FRACTIONBITS;
     else
         voice->mStep = maxu(fastf2u(Pitch * FRACTIONONE), 1);
-    voice->mResampler = PrepareResampler(props->mResampler, voice->mStep, &voice->mResampleState);
 
     /* Calculate gains */
     const ALlistener &Listener = ALContext->mListener;
@@ -1264,18 +1457,226 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcon
         WetGain[i].LF = props->Send[i].GainLF;
     }
 
+    PrepareVoiceResampler(voice, props, DryGain, WetGain, SendSlots, Device);
     CalcPanningAndFilters(voice, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, DryGain, WetGain, SendSlots, props,
         Listener, Device);
 }
 
-void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontext *ALContext)
+/* Listener-space geometry of a source, relative to the listener. */
+struct SourceGeometry {
+    /* Normalized direction to the source, and its distance. */
+    alu::Vector ToSource;
+    float Distance;
+    /* Whether the source has a direction, and the cosine of the angle between
+     * it and the listener.
+     */
+    bool Directional;
+    float ConeCos;
+    /* Source and listener velocities along the direction to the source. */
+    float SourceVel;
+    float ListenerVel;
+};
+
+/* A batch of attenuated voices whose geometry is calculated together. The
+ * source vectors are stored as separate component arrays, so the transform
+ * and normalization can be done for four voices at a time.
+ */
+struct SourceGeometryBatch {
+    static constexpr size_t MaxVoices{64};
+
+    size_t Count{0u};
+    Voice *Voices[MaxVoices];
+
+    alignas(16) ALuint HeadRelative[MaxVoices];
+    alignas(16) float PosX[MaxVoices], PosY[MaxVoices], PosZ[MaxVoices];
+    alignas(16) float VelX[MaxVoices], VelY[MaxVoices], VelZ[MaxVoices];
+    alignas(16) float DirX[MaxVoices], DirY[MaxVoices], DirZ[MaxVoices];
+
+    /* Results. The position is replaced by the normalized direction to the
+     * source.
+     */
+    alignas(16) float Distance[MaxVoices];
+    alignas(16) float ConeCos[MaxVoices];
+    alignas(16) float SourceVel[MaxVoices];
+    alignas(16) float ListenerVel[MaxVoices];
+
+    bool full() const noexcept { return Count == MaxVoices; }
+
+    void add(Voice *voice, const ALlistener &Listener) noexcept
+    {
+        const VoiceProps &props = voice->mProps;
+        const size_t idx{Count++};
+
+        Voices[idx] = voice;
+        HeadRelative[idx] = props.HeadRelative ? ~0u : 0u;
+        PosX[idx] = props.Position[0];
+        PosY[idx] = props.Position[1];
+        PosZ[idx] = props.Position[2];
+        VelX[idx] = props.Velocity[0];
+        VelY[idx] = props.Velocity[1];
+        VelZ[idx] = props.Velocity[2];
+        DirX[idx] = props.Direction[0];
+        DirY[idx] = props.Direction[1];
+        DirZ[idx] = props.Direction[2];
+        if(props.HeadRelative)
+        {
+            /* Offset the source velocity to be relative of the listener
+             * velocity.
+             */
+            VelX[idx] += Listener.Params.Velocity[0];
+            VelY[idx] += Listener.Params.Velocity[1];
+            VelZ[idx] += Listener.Params.Velocity[2];
+        }
+    }
+
+    SourceGeometry get(const size_t idx) const noexcept
+    {
+        SourceGeometry ret;
+        ret.ToSource = alu::Vector{PosX[idx], PosY[idx], PosZ[idx], 0.0f};
+        ret.Distance = Distance[idx];
+        ret.Directional = DirX[idx] != 0.0f || DirY[idx] != 0.0f || DirZ[idx] != 0.0f;
+        ret.ConeCos = ConeCos[idx];
+        ret.SourceVel = SourceVel[idx];
+        ret.ListenerVel = ListenerVel[idx];
+        return ret;
+    }
+
+    void calcGeometry(const ALlistener &Listener) noexcept;
+};
+
+void SourceGeometryBatch::calcGeometry(const ALlistener &Listener) noexcept
+{
+    const alu::Matrix &mtx = Listener.Params.Matrix;
+    const alu::Vector &lvel = Listener.Params.Velocity;
+
+#ifdef HAVE_SSE_INTRINSICS
+    /* Pad the batch to a multiple of four, so the last group only sees
+     * defined values.
+     */
+    const size_t padded{(Count+3) & ~size_t{3u}};
+    for(size_t i{Count};i < padded;++i)
+    {
+        HeadRelative[i] = 0u;
+        PosX[i] = PosY[i] = PosZ[i] = 0.0f;
+        VelX[i] = VelY[i] = VelZ[i] = 0.0f;
+        DirX[i] = DirY[i] = DirZ[i] = 0.0f;
+    }
+
+    /* Transforms a vector with the given w component, in the same order of
+     * operations as the scalar matrix multiply.
+     */
+    auto transform = [&mtx](const __m128 x, const __m128 y, const __m128 z, const float w,
+        const size_t col) noexcept -> __m128
+    {
+        __m128 r{_mm_mul_ps(x, _mm_set1_ps(mtx[0][col]))};
+        r = _mm_add_ps(r, _mm_mul_ps(y, _mm_set1_ps(mtx[1][col])));
+        r = _mm_add_ps(r, _mm_mul_ps(z, _mm_set1_ps(mtx[2][col])));
+        return _mm_add_ps(r, _mm_set1_ps(w*mtx[3][col]));
+    };
+    /* Normalizes a vector, returning its length. Vectors too short to have a
+     * direction are set to zero.
+     */
+    auto normalize = [](__m128 &x, __m128 &y, __m128 &z) noexcept -> __m128
+    {
+        const __m128 len{_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+            _mm_mul_ps(z, z)))};
+        const __m128 valid{_mm_cmpgt_ps(len, _mm_set1_ps(std::numeric_limits<float>::epsilon()))};
+        const __m128 inv_len{_mm_div_ps(_mm_set1_ps(1.0f), len)};
+        x = _mm_and_ps(valid, _mm_mul_ps(x, inv_len));
+        y = _mm_and_ps(valid, _mm_mul_ps(y, inv_len));
+        z = _mm_and_ps(valid, _mm_mul_ps(z, inv_len));
+        return _mm_and_ps(valid, len);
+    };
+    auto dot = [](const __m128 x0, const __m128 y0, const __m128 z0, const __m128 x1,
+        const __m128 y1, const __m128 z1) noexcept -> __m128
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)),
+            _mm_mul_ps(z0, z1));
+    };
+    /* Selects a for head-relative lanes, b otherwise. */
+    auto select = [](const __m128 mask, const __m128 a, const __m128 b) noexcept -> __m128
+    { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+
+    const __m128 neg_zero{_mm_set1_ps(-0.0f)};
+    for(size_t i{0};i < padded;i += 4)
+    {
+        const __m128 hrel{_mm_castsi128_ps(_mm_load_si128(
+            reinterpret_cast<const __m128i*>(&HeadRelative[i])))};
+
+        __m128 px{_mm_load_ps(&PosX[i])}, py{_mm_load_ps(&PosY[i])}, pz{_mm_load_ps(&PosZ[i])};
+        __m128 vx{_mm_load_ps(&VelX[i])}, vy{_mm_load_ps(&VelY[i])}, vz{_mm_load_ps(&VelZ[i])};
+        __m128 dx{_mm_load_ps(&DirX[i])}, dy{_mm_load_ps(&DirY[i])}, dz{_mm_load_ps(&DirZ[i])};
+
+        /* Transform source vectors to listener space, unless head-relative. */
+        const __m128 tpx{transform(px, py, pz, 1.0f, 0)};
+        const __m128 tpy{transform(px, py, pz, 1.0f, 1)};
+        const __m128 tpz{transform(px, py, pz, 1.0f, 2)};
+        px = select(hrel, px, tpx); py = select(hrel, py, tpy); pz = select(hrel, pz, tpz);
+
+        const __m128 tvx{transform(vx, vy, vz, 0.0f, 0)};
+        const __m128 tvy{transform(vx, vy, vz, 0.0f, 1)};
+        const __m128 tvz{transform(vx, vy, vz, 0.0f, 2)};
+        vx = select(hrel, vx, tvx); vy = select(hrel, vy, tvy); vz = select(hrel, vz, tvz);
+
+        const __m128 tdx{transform(dx, dy, dz, 0.0f, 0)};
+        const __m128 tdy{transform(dx, dy, dz, 0.0f, 1)};
+        const __m128 tdz{transform(dx, dy, dz, 0.0f, 2)};
+        dx = select(hrel, dx, tdx); dy = select(hrel, dy, tdy); dz = select(hrel, dz, tdz);
+
+        normalize(dx, dy, dz);
+        const __m128 dist{normalize(px, py, pz)};
+
+        _mm_store_ps(&PosX[i], px);
+        _mm_store_ps(&PosY[i], py);
+        _mm_store_ps(&PosZ[i], pz);
+        _mm_store_ps(&DirX[i], dx);
+        _mm_store_ps(&DirY[i], dy);
+        _mm_store_ps(&DirZ[i], dz);
+        _mm_store_ps(&Distance[i], dist);
+        _mm_store_ps(&ConeCos[i], _mm_xor_ps(dot(dx, dy, dz, px, py, pz), neg_zero));
+        _mm_store_ps(&SourceVel[i], dot(vx, vy, vz, px, py, pz));
+        _mm_store_ps(&ListenerVel[i], dot(_mm_set1_ps(lvel[0]), _mm_set1_ps(lvel[1]),
+            _mm_set1_ps(lvel[2]), px, py, pz));
+    }
+#else
+    for(size_t i{0};i < Count;++i)
+    {
+        alu::Vector Position{PosX[i], PosY[i], PosZ[i], 1.0f};
+        alu::Vector Velocity{VelX[i], VelY[i], VelZ[i], 0.0f};
+        alu::Vector Direction{DirX[i], DirY[i], DirZ[i], 0.0f};
+        if(!HeadRelative[i])
+        {
+            Position = mtx * Position;
+            Velocity = mtx * Velocity;
+            Direction = mtx * Direction;
+        }
+
+        Direction.normalize();
+        alu::Vector ToSource{Position[0], Position[1], Position[2], 0.0f};
+        Distance[i] = ToSource.normalize();
+
+        PosX[i] = ToSource[0];
+        PosY[i] = ToSource[1];
+        PosZ[i] = ToSource[2];
+        DirX[i] = Direction[0];
+        DirY[i] = Direction[1];
+        DirZ[i] = Direction[2];
+        ConeCos[i] = -aluDotproduct(Direction, ToSource);
+        SourceVel[i] = aluDotproduct(Velocity, ToSource);
+        ListenerVel[i] = aluDotproduct(lvel, ToSource);
+    }
+#endif
+}
+
+void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontext *ALContext,
+    const SourceGeometry &geom)
 {
     const ALCdevice *Device{ALContext->mDevice.get()};
     const ALuint NumSends{Device->NumAuxSends};
     const ALlistener &Listener = ALContext->mListener;
 
     /* Set mixing buffers and get send parameters. */
-    voice->mDirect.Buffer = Device->Dry.Buffer;
+    voice->mDirect.Buffer = props->Direct.Bus ? props->Direct.Bus->Buffer : Device->Dry.Buffer;
     ALeffectslot *SendSlots[MAX_SENDS];
     float RoomRolloff[MAX_SENDS];
     GainTriplet DecayDistance[MAX_SENDS];
@@ -1333,26 +1734,8 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
             voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
     }
 
-    /* Transform source to listener space (convert to head relative) */
-    alu::Vector Position{props->Position[0], props->Position[1], props->Position[2], 1.0f};
-    alu::Vector Velocity{props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f};
-    alu::Vector Direction{props->Direction[0], props->Direction[1], props->Direction[2], 0.0f};
-    if(props->HeadRelative == AL_FALSE)
-    {
-        /* Transform source vectors */
-        Position = Listener.Params.Matrix * Position;
-        Velocity = Listener.Params.Matrix * Velocity;
-        Direction = Listener.Params.Matrix * Direction;
-    }
-    else
-    {
-        /* Offset the source velocity to be relative of the listener velocity */
-        Velocity += Listener.Params.Velocity;
-    }
-
-    const bool directional{Direction.normalize() > 0.0f};
-    alu::Vector ToSource{Position[0], Position[1], Position[2], 0.0f};
-    const float Distance{ToSource.normalize()};
+    const alu::Vector &ToSource = geom.ToSource;
+    const float Distance{geom.Distance};
 
     /* Initial source gain */
     GainTriplet DryGain{props->Gain, 1.0f, 1.0f};
@@ -1428,10 +1811,9 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
     }
 
     /* Calculate directional soundcones */
-    if(directional && props->InnerAngle < 360.0f)
+    if(geom.Directional && props->InnerAngle < 360.0f)
     {
-        const float Angle{Rad2Deg(std::acos(-aluDotproduct(Direction, ToSource)) *
-            ConeScale * 2.0f)};
+        const float Angle{Rad2Deg(std::acos(geom.ConeCos) * ConeScale * 2.0f)};
 
         float ConeGain, ConeHF;
         if(!(Angle > props->InnerAngle))
@@ -1523,9 +1905,8 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
     float DopplerFactor{props->DopplerFactor * Listener.Params.DopplerFactor};
     if(DopplerFactor > 0.0f)
     {
-        const alu::Vector &lvelocity = Listener.Params.Velocity;
-        float vss{aluDotproduct(Velocity, ToSource) * -DopplerFactor};
-        float vls{aluDotproduct(lvelocity, ToSource) * -DopplerFactor};
+        float vss{geom.SourceVel * -DopplerFactor};
+        float vls{geom.ListenerVel * -DopplerFactor};
 
         const float SpeedOfSound{Listener.Params.SpeedOfSound};
         if(!(vls < SpeedOfSound))
@@ -1559,7 +1940,7 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
         voice->mStep = MAX_PITCH<<FRACTIONBITS;
     else
         voice->mStep = maxu(fastf2u(Pitch * FRACTIONONE), 1);
-    voice->mResampler = PrepareResampler(props->mResampler, voice->mStep, &voice->mResampleState);
+    PrepareVoiceResampler(voice, props, DryGain, WetGain, SendSlots, Device);
 
     float spread{0.0f};
     if(props->Radius > Distance)
@@ -1572,7 +1953,21 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
         Listener, Device);
 }
 
-void CalcSourceParams(Voice *voice, ALCcontext *context, bool force)
+void CalcAttnSourceBatch(SourceGeometryBatch &batch, const ALCcontext *context)
+{
+    batch.calcGeometry(context->mListener);
+    for(size_t i{0};i < batch.Count;++i)
+    {
+        Voice *voice{batch.Voices[i]};
+        CalcAttnSourceParams(voice, &voice->mProps, context, batch.get(i));
+    }
+    batch.Count = 0;
+}
+
+/* Updates the voice's parameters, or adds it to the batch if it's attenuated
+ * (in which case they're calculated when the batch is flushed).
+ */
+void CalcSourceParams(Voice *voice, ALCcontext *context, SourceGeometryBatch &batch, bool force)
 {
     VoicePropsItem *props{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)};
     if(!props && !force) return;
@@ -1590,7 +1985,11 @@ void CalcSourceParams(Voice *voice, ALCcontext *context, bool force)
         || (voice->mProps.mSpatializeMode==SpatializeMode::Auto && voice->mFmtChannels != FmtMono))
         CalcNonAttnSourceParams(voice, &voice->mProps, context);
     else
-        CalcAttnSourceParams(voice, &voice->mProps, context);
+    {
+        batch.add(voice, context->mListener);
+        if(batch.full())
+            CalcAttnSourceBatch(batch, context);
+    }
 }
 
 
@@ -1699,8 +2098,21 @@ void ProcessVoiceChanges(ALCcontext *ctx)
     ctx->mCurrentVoiceChange.store(cur, std::memory_order_release);
 }
 
+void UpdateSources(ALCcontext *ctx, const al::span<Voice*> voices, const bool force)
+{
+    SourceGeometryBatch batch;
+    for(Voice *voice : voices)
+    {
+        /* Only update voices that have a source. */
+        if(voice->mSourceID.load(std::memory_order_relaxed) != 0)
+            CalcSourceParams(voice, ctx, batch, force);
+    }
+    if(batch.Count > 0)
+        CalcAttnSourceBatch(batch, ctx);
+}
+
 void ProcessParamUpdates(ALCcontext *ctx, const ALeffectslotArray &slots,
-    const al::span<Voice*> voices)
+    const ALbusArray &buses, const al::span<Voice*> voices)
 {
     ProcessVoiceChanges(ctx);
 
@@ -1712,101 +2124,289 @@ void ProcessParamUpdates(ALCcontext *ctx, const ALeffectslotArray &slots,
         auto sorted_slots = const_cast<ALeffectslot**>(slots.data() + slots.size());
         for(ALeffectslot *slot : slots)
             force |= CalcEffectSlotParams(slot, sorted_slots, ctx);
+        for(ALbus *bus : buses)
+            CalcBusParams(bus, ctx);
 
-        for(Voice *voice : voices)
+        if(!ctx->mDevice->mSourceUpdater)
+            UpdateSources(ctx, voices, force);
+        else
         {
-            /* Only update voices that have a source. */
-            if(voice->mSourceID.load(std::memory_order_relaxed) != 0)
-                CalcSourceParams(voice, ctx, force);
+            /* The update thread handles the sources after the voices are
+             * mixed. Newly started voices can't wait for that since they
+             * don't have any parameters yet (indicated by a 0 step), so
+             * update them now. Voices whose send slots or direct bus changed
+             * also need their update now, since the old slot or bus can be
+             * deleted as soon as this mix is done.
+             */
+            ctx->mForceSourceUpdates |= force;
+
+            SourceGeometryBatch batch;
+            for(Voice *voice : voices)
+            {
+                if(voice->mSourceID.load(std::memory_order_acquire) == 0)
+                    continue;
+                if(voice->mTargetsChanged.exchange(false, std::memory_order_acquire)
+                    || voice->mStep == 0)
+                    CalcSourceParams(voice, ctx, batch, true);
+            }
+            if(batch.Count > 0)
+                CalcAttnSourceBatch(batch, ctx);
         }
     }
     IncrementRef(ctx->mUpdateCount);
 }
 
-void ProcessContexts(ALCdevice *device, const ALuint SamplesToDo)
+/* Updates the sources for the next mix, from the source update thread. */
+void ProcessSourceUpdates(ALCcontext *ctx, const al::span<Voice*> voices)
+{
+    IncrementRef(ctx->mUpdateCount);
+    if LIKELY(!ctx->mHoldUpdates.load(std::memory_order_acquire))
+    {
+        const bool force{ctx->mForceSourceUpdates};
+        ctx->mForceSourceUpdates = false;
+        UpdateSources(ctx, voices, force);
+    }
+    IncrementRef(ctx->mUpdateCount);
+}
+
+/* Applies each bus's gain and filter to its mix, and adds it to the bus's
+ * target. Buses are processed before the buses they feed.
+ */
+void ProcessBuses(const ALbusArray &buses, const MixBuffers &buffers, const ALCdevice *device,
+    const ALuint SamplesToDo)
+{
+    for(ALbus *bus : buses)
+    {
+        ALuint depth{0u};
+        for(ALbus *target{bus->Params.Target};target;target = target->Params.Target)
+            ++depth;
+        bus->Params.Depth = depth;
+    }
+
+    /* Sort the buses into the extra storage, deepest first. */
+    auto sorted_buses = const_cast<ALbus**>(buses.data() + buses.size());
+    auto sorted_buses_end = std::copy(buses.begin(), buses.end(), sorted_buses);
+    std::sort(sorted_buses, sorted_buses_end,
+        [](const ALbus *lhs, const ALbus *rhs) noexcept -> bool
+        { return lhs->Params.Depth > rhs->Params.Depth; });
+
+    const al::span<FloatBufferLine> DryOut{buffers.getTarget(device->Dry.Buffer)};
+    auto process_bus = [&buffers,DryOut,SamplesToDo](ALbus *bus) -> void
+    {
+        const al::span<FloatBufferLine> target{bus->Params.Target ?
+            bus->Params.Target->Buffer : DryOut};
+        const float gain{bus->Params.Gain};
+        for(size_t c{0};c < bus->mChans.size();c++)
+        {
+            ALbus::ChannelData &chan = bus->mChans[c];
+            if(!(chan.CurrentGain > GAIN_SILENCE_THRESHOLD || gain > GAIN_SILENCE_THRESHOLD))
+            {
+                /* Skipping the filters leaves their history stale, so clear it
+                 * to start fresh when the gain comes back.
+                 */
+                chan.LowPass.clear();
+                chan.HighPass.clear();
+                chan.CurrentGain = gain;
+                continue;
+            }
+
+            const float *samples{DoFilters(chan.LowPass, chan.HighPass,
+                buffers.FilteredData, {bus->MixBuffer[c].data(), SamplesToDo},
+                bus->Params.FilterType)};
+            /* Fade gain changes over the update, like voices and effects. */
+            const size_t counter{bus->Params.IsFading ? SamplesToDo : 0u};
+            MixSamples({samples, SamplesToDo}, target.subspan(c, 1), &chan.CurrentGain, &gain,
+                counter, 0);
+        }
+        bus->Params.IsFading = true;
+    };
+    std::for_each(sorted_buses, sorted_buses_end, process_bus);
+}
+
+void ProcessContext(ALCcontext *ctx, const MixBuffers &buffers, const ALuint SamplesToDo)
 {
     ASSUME(SamplesToDo > 0);
 
-    for(ALCcontext *ctx : *device->mContexts.load(std::memory_order_acquire))
+    const ALeffectslotArray &auxslots = *ctx->mActiveAuxSlots.load(std::memory_order_acquire);
+    const ALbusArray &buses = *ctx->mActiveBuses.load(std::memory_order_acquire);
+    const al::span<Voice*> voices{ctx->getVoicesSpanAcquired()};
+
+    /* Process pending propery updates for objects on the context. */
+    ProcessParamUpdates(ctx, auxslots, buses, voices);
+
+    /* Clear auxiliary effect slot and bus mixing buffers. */
+    for(ALeffectslot *slot : auxslots)
+    {
+        for(auto &buffer : slot->MixBuffer)
+            buffer.fill(0.0f);
+    }
+    for(ALbus *bus : buses)
     {
-        const ALeffectslotArray &auxslots = *ctx->mActiveAuxSlots.load(std::memory_order_acquire);
-        const al::span<Voice*> voices{ctx->getVoicesSpanAcquired()};
+        for(auto &buffer : bus->MixBuffer)
+            std::fill_n(buffer.begin(), SamplesToDo, 0.0f);
+    }
 
-        /* Process pending propery updates for objects on the context. */
-        ProcessParamUpdates(ctx, auxslots, voices);
+    /* Process voices that have a playing source. */
+    std::array<ALuint,static_cast<size_t>(Resampler::Max)+1> resampler_voices{};
+    for(Voice *voice : voices)
+    {
+        const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
+        if(vstate != Voice::Stopped && vstate != Voice::Pending)
+        {
+            voice->mix(vstate, ctx, buffers, SamplesToDo);
+            ++resampler_voices[static_cast<size_t>(voice->mResamplerType)];
+        }
+    }
+    for(size_t i{0};i < resampler_voices.size();++i)
+        ctx->mResamplerVoices[i].store(resampler_voices[i], std::memory_order_relaxed);
 
-        /* Clear auxiliary effect slot mixing buffers. */
-        for(ALeffectslot *slot : auxslots)
+    /* Process buses, after the voices feeding them. */
+    if(!buses.empty())
+        ProcessBuses(buses, buffers, ctx->mDevice.get(), SamplesToDo);
+
+    /* With a source update thread, calculate the sources' parameters for
+     * the next mix while the effects are processed.
+     */
+    if(SourceUpdateThread *updater{ctx->mDevice->mSourceUpdater.get()})
+        updater->start(ctx, voices);
+
+    /* Process effects. */
+    if(const size_t num_slots{auxslots.size()})
+    {
+        auto slots = auxslots.data();
+        auto slots_end = slots + num_slots;
+
+        /* First sort the slots into extra storage, so that effects come
+         * before their effect target (or their targets' target).
+         */
+        auto sorted_slots = const_cast<ALeffectslot**>(slots_end);
+        auto sorted_slots_end = sorted_slots;
+        if(*sorted_slots)
         {
-            for(auto &buffer : slot->MixBuffer)
-                buffer.fill(0.0f);
+            /* Skip sorting if it has already been done. */
+            sorted_slots_end += num_slots;
+            goto skip_sorting;
         }
 
-        /* Process voices that have a playing source. */
-        for(Voice *voice : voices)
+        /* Slots that share an effect state with an earlier slot (with the
+         * same target) mix their input into that slot's instead of being
+         * processed, so they need to come before it.
+         */
+        for(auto iter = slots;iter != slots_end;++iter)
         {
-            const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
-            if(vstate != Voice::Stopped && vstate != Voice::Pending)
-                voice->mix(vstate, ctx, SamplesToDo);
+            ALeffectslot *slot{*iter};
+            auto is_instance = [slot](const ALeffectslot *other) noexcept -> bool
+            {
+                return other->Params.mEffectState == slot->Params.mEffectState
+                    && other->Params.Target == slot->Params.Target;
+            };
+            auto inst = std::find_if(slots, iter, is_instance);
+            slot->Params.InstanceOf = (inst != iter) ? *inst : nullptr;
         }
 
-        /* Process effects. */
-        if(const size_t num_slots{auxslots.size()})
+        *sorted_slots_end = *slots;
+        ++sorted_slots_end;
+        while(++slots != slots_end)
         {
-            auto slots = auxslots.data();
-            auto slots_end = slots + num_slots;
+            auto in_chain = [](const ALeffectslot *s1, const ALeffectslot *s2) noexcept -> bool
+            {
+                while((s1=(s1->Params.InstanceOf ? s1->Params.InstanceOf : s1->Params.Target)))
+                {
+                    if(s1 == s2) return true;
+                }
+                return false;
+            };
 
-            /* First sort the slots into extra storage, so that effects come
-             * before their effect target (or their targets' target).
+            /* If this effect slot targets an effect slot already in the
+             * list (i.e. slots outputs to something in sorted_slots),
+             * directly or indirectly, insert it prior to that element.
              */
-            auto sorted_slots = const_cast<ALeffectslot**>(slots_end);
-            auto sorted_slots_end = sorted_slots;
-            if(*sorted_slots)
-            {
-                /* Skip sorting if it has already been done. */
-                sorted_slots_end += num_slots;
-                goto skip_sorting;
-            }
+            auto checker = sorted_slots;
+            do {
+                if(in_chain(*slots, *checker)) break;
+            } while(++checker != sorted_slots_end);
 
-            *sorted_slots_end = *slots;
+            checker = std::move_backward(checker, sorted_slots_end, sorted_slots_end+1);
+            *--checker = *slots;
             ++sorted_slots_end;
-            while(++slots != slots_end)
+        }
+
+    skip_sorting:
+        auto process_effect = [&buffers,SamplesToDo](const ALeffectslot *slot) -> void
+        {
+            if(ALeffectslot *inst{slot->Params.InstanceOf})
             {
-                auto in_chain = [](const ALeffectslot *s1, const ALeffectslot *s2) noexcept -> bool
+                auto mix_input = [SamplesToDo](const FloatBufferLine &src,
+                    FloatBufferLine &dst) noexcept -> FloatBufferLine&
                 {
-                    while((s1=s1->Params.Target) != nullptr) {
-                        if(s1 == s2) return true;
-                    }
-                    return false;
+                    std::transform(src.cbegin(), src.cbegin()+SamplesToDo, dst.cbegin(),
+                        dst.begin(), std::plus<float>{});
+                    return dst;
                 };
-
-                /* If this effect slot targets an effect slot already in the
-                 * list (i.e. slots outputs to something in sorted_slots),
-                 * directly or indirectly, insert it prior to that element.
-                 */
-                auto checker = sorted_slots;
-                do {
-                    if(in_chain(*slots, *checker)) break;
-                } while(++checker != sorted_slots_end);
-
-                checker = std::move_backward(checker, sorted_slots_end, sorted_slots_end+1);
-                *--checker = *slots;
-                ++sorted_slots_end;
+                std::transform(slot->Wet.Buffer.cbegin(), slot->Wet.Buffer.cend(),
+                    inst->Wet.Buffer.begin(), inst->Wet.Buffer.begin(), mix_input);
+                return;
             }
 
-        skip_sorting:
-            auto process_effect = [SamplesToDo](const ALeffectslot *slot) -> void
+            EffectState *state{slot->Params.mEffectState};
+            state->process(SamplesToDo, slot->Wet.Buffer,
+                buffers.getTarget(state->mOutTarget));
+        };
+        std::for_each(sorted_slots, sorted_slots_end, process_effect);
+    }
+
+    /* Signal the event handler if there are any events to read. */
+    RingBuffer *ring{ctx->mAsyncEvents.get()};
+    if(ring->readSpace() > 0)
+        ctx->mEventSem.post();
+}
+
+void ProcessContexts(ALCdevice *device, const ALuint SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    const auto &contexts = *device->mContexts.load(std::memory_order_acquire);
+    ContextMixer *mixer{device->mContextMixer.get()};
+    if(!mixer || contexts.size() < 2)
+    {
+        const MixBuffers buffers{device};
+        for(ALCcontext *ctx : contexts)
+            ProcessContext(ctx, buffers, SamplesToDo);
+        return;
+    }
+
+    /* Mix each context into its own storage, spread over the mixer threads. */
+    mixer->mix(device, {contexts.data(), contexts.size()}, SamplesToDo);
+
+    /* Then add each context's output to the device's. */
+    for(ALCcontext *ctx : contexts)
+    {
+        ContextMixStorage *storage{ctx->mMixStorage.get()};
+        auto mix_line = [SamplesToDo](const FloatBufferLine &src, FloatBufferLine &dst) noexcept
+            -> FloatBufferLine&
+        {
+            std::transform(src.cbegin(), src.cbegin()+SamplesToDo, dst.cbegin(), dst.begin(),
+                std::plus<float>{});
+            return dst;
+        };
+        std::transform(storage->MixBuffer.cbegin(), storage->MixBuffer.cend(),
+            device->MixBuffer.begin(), device->MixBuffer.begin(), mix_line);
+
+        if(device->mHrtf)
+        {
+            /* Source HRTF filters leave a tail past the end of the mix, which
+             * the device's accumulation buffer carries into the next one.
+             */
+            const size_t todo{SamplesToDo + HRIR_LENGTH};
+            float2 *src{storage->HrtfAccumData + HRTF_DIRECT_DELAY};
+            float2 *dst{device->HrtfAccumData + HRTF_DIRECT_DELAY};
+            for(size_t i{0};i < todo;++i)
             {
-                EffectState *state{slot->Params.mEffectState};
-                state->process(SamplesToDo, slot->Wet.Buffer, state->mOutTarget);
-            };
-            std::for_each(sorted_slots, sorted_slots_end, process_effect);
+                dst[i][0] += src[i][0];
+                dst[i][1] += src[i][1];
+            }
+            std::fill_n(src, todo, float2{});
         }
-
-        /* Signal the event handler if there are any events to read. */
-        RingBuffer *ring{ctx->mAsyncEvents.get()};
-        if(ring->readSpace() > 0)
-            ctx->mEventSem.post();
     }
 }
 
@@ -1919,6 +2519,82 @@ void Write(const al::span<const FloatBufferLine> InBuffer, void *OutBuffer, cons
     }
 }
 
+template<DevFmtType T>
+void WriteSilence(const size_t NumChannels, void *OutBuffer, const size_t Offset,
+    const size_t SamplesToDo, const size_t FrameStep)
+{
+    using SampleType = typename DevFmtTypeTraits<T>::Type;
+
+    ASSUME(FrameStep > 0);
+    ASSUME(SamplesToDo > 0);
+
+    static constexpr SampleType silence{(std::is_signed<SampleType>::value ||
+        std::is_floating_point<SampleType>::value) ? SampleType{} :
+        static_cast<SampleType>(std::numeric_limits<SampleType>::max()/2 + 1)};
+    SampleType *out = static_cast<SampleType*>(OutBuffer) + Offset*FrameStep;
+    if(NumChannels == FrameStep)
+        std::fill_n(out, SamplesToDo*FrameStep, silence);
+    else for(size_t i{0};i < SamplesToDo;++i)
+    {
+        std::fill_n(out, NumChannels, silence);
+        out += FrameStep;
+    }
+}
+
+
+/* Checks if any of the device's contexts has a voice playing, or a pending
+ * voice change that may start one.
+ */
+bool HasActiveVoices(const ALCdevice *device)
+{
+    for(ALCcontext *ctx : *device->mContexts.load(std::memory_order_acquire))
+    {
+        const VoiceChange *cur{ctx->mCurrentVoiceChange.load(std::memory_order_acquire)};
+        if(cur->mNext.load(std::memory_order_acquire))
+            return true;
+        for(const Voice *voice : ctx->getVoicesSpanAcquired())
+        {
+            if(voice->mPlayState.load(std::memory_order_acquire) != Voice::Stopped)
+                return true;
+        }
+    }
+    return false;
+}
+
+/* Counts how long the output has been silent without voices playing, putting
+ * the device into idle once it reaches the idle timeout. The timeout needs to
+ * be long enough for effect tails, including echo and reverb delays, to come
+ * through.
+ */
+void UpdateIdleState(ALCdevice *device, const bool has_voices,
+    const al::span<const FloatBufferLine> Samples, const ALuint SamplesToDo)
+{
+    auto is_silent = [SamplesToDo](const FloatBufferLine &buffer) noexcept -> bool
+    {
+        return std::all_of(buffer.cbegin(), buffer.cbegin()+SamplesToDo,
+            [](const float s) noexcept -> bool { return std::fabs(s) <= GAIN_SILENCE_THRESHOLD; });
+    };
+    if(has_voices || !std::all_of(Samples.begin(), Samples.end(), is_silent))
+    {
+        device->mSilentSamples = 0;
+        return;
+    }
+    device->mSilentSamples += SamplesToDo;
+    if(device->mSilentSamples >= device->mIdleTimeout)
+        device->mIdle = true;
+}
+
+/* Increments the clock time. Every second's worth of samples is converted and
+ * added to clock base so that large sample counts don't overflow during
+ * conversion. This also guarantees a stable conversion.
+ */
+inline void AdvanceClock(ALCdevice *device, const ALuint SamplesToDo)
+{
+    device->SamplesDone += SamplesToDo;
+    device->ClockBase += std::chrono::seconds{device->SamplesDone / device->Frequency};
+    device->SamplesDone %= device->Frequency;
+}
+
 } // namespace
 
 void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
@@ -1929,6 +2605,43 @@ void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
     {
         const ALuint SamplesToDo{minu(NumSamples-SamplesDone, BUFFERSIZE)};
 
+        /* While idle, skip mixing and write silence until a voice starts. */
+        if(device->mIdle)
+        {
+            /* The voices are only safe to check while marked as mixing. */
+            IncrementRef(device->MixCount);
+            if(!HasActiveVoices(device))
+            {
+                AdvanceClock(device, SamplesToDo);
+                IncrementRef(device->MixCount);
+                device->mIdleSamples.fetch_add(SamplesToDo, std::memory_order_relaxed);
+
+                if LIKELY(OutBuffer)
+                {
+                    const size_t numchans{device->RealOut.Buffer.size()};
+                    switch(device->FmtType)
+                    {
+#define HANDLE_WRITE(T) case T:                                               \
+    WriteSilence<T>(numchans, OutBuffer, SamplesDone, SamplesToDo, FrameStep); break;
+                    HANDLE_WRITE(DevFmtByte)
+                    HANDLE_WRITE(DevFmtUByte)
+                    HANDLE_WRITE(DevFmtShort)
+                    HANDLE_WRITE(DevFmtUShort)
+                    HANDLE_WRITE(DevFmtInt)
+                    HANDLE_WRITE(DevFmtUInt)
+                    HANDLE_WRITE(DevFmtFloat)
+#undef HANDLE_WRITE
+                    }
+                }
+
+                SamplesDone += SamplesToDo;
+                continue;
+            }
+            IncrementRef(device->MixCount);
+            device->mIdle = false;
+            device->mSilentSamples = 0;
+        }
+
         /* Clear main mixing buffers. */
         std::for_each(device->MixBuffer.begin(), device->MixBuffer.end(),
             [](FloatBufferLine &buffer) -> void { buffer.fill(0.0f); });
@@ -1938,18 +2651,18 @@ void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
 
         /* Process and mix each context's sources and effects. */
         ProcessContexts(device, SamplesToDo);
+        const bool has_voices{device->mIdleTimeout > 0 && HasActiveVoices(device)};
 
-        /* Increment the clock time. Every second's worth of samples is
-         * converted and added to clock base so that large sample counts don't
-         * overflow during conversion. This also guarantees a stable
-         * conversion.
-         */
-        device->SamplesDone += SamplesToDo;
-        device->ClockBase += std::chrono::seconds{device->SamplesDone / device->Frequency};
-        device->SamplesDone %= device->Frequency;
+        /* Increment the clock time. */
+        AdvanceClock(device, SamplesToDo);
 
-        /* Increment the mix count at the end (lsb should now be 0). */
-        IncrementRef(device->MixCount);
+        /* Increment the mix count at the end (lsb should now be 0). A source
+         * update thread may still be using the voices, so in that case the mix
+         * ends after the output is done.
+         */
+        SourceUpdateThread *updater{device->mSourceUpdater.get()};
+        if(!updater)
+            IncrementRef(device->MixCount);
 
         /* Apply any needed post-process for finalizing the Dry mix to the
          * RealOut (Ambisonic decode, UHJ encode, etc).
@@ -1965,6 +2678,10 @@ void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
         /* Apply delays and attenuation for mismatched speaker distances. */
         ApplyDistanceComp(RealOut, SamplesToDo, device->ChannelDelay.as_span().cbegin());
 
+        /* Check if the device can idle, before dither noise is added. */
+        if(device->mIdleTimeout > 0)
+            UpdateIdleState(device, has_voices, RealOut, SamplesToDo);
+
         /* Apply dithering. The compressor should have left enough headroom for
          * the dither noise to not saturate.
          */
@@ -1991,28 +2708,158 @@ void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
             }
         }
 
+        if(updater)
+        {
+            updater->wait();
+            IncrementRef(device->MixCount);
+        }
+
         SamplesDone += SamplesToDo;
     }
 }
 
 
+SourceUpdateThread::SourceUpdateThread()
+{ mThread = std::thread{std::mem_fn(&SourceUpdateThread::threadProc), this}; }
+
+SourceUpdateThread::~SourceUpdateThread()
+{
+    wait();
+    mQuit.store(true, std::memory_order_release);
+    mStartSem.post();
+    mThread.join();
+}
+
+void SourceUpdateThread::threadProc()
+{
+    SetRTPriority();
+    althrd_setname(SOURCE_UPDATE_THREAD_NAME);
+
+    while(true)
+    {
+        mStartSem.wait();
+        if(mQuit.load(std::memory_order_acquire))
+            break;
+
+        FPUCtl mixer_mode{};
+        ProcessSourceUpdates(mContext, mVoices);
+        mDoneSem.post();
+    }
+}
+
+void SourceUpdateThread::start(ALCcontext *context, const al::span<Voice*> voices)
+{
+    wait();
+    mContext = context;
+    mVoices = voices;
+    mRunning = true;
+    mStartSem.post();
+}
+
+void SourceUpdateThread::wait() noexcept
+{
+    if(mRunning)
+    {
+        mDoneSem.wait();
+        mRunning = false;
+    }
+}
+
+
+ContextMixer::ContextMixer(size_t count)
+{
+    mThreads.reserve(count);
+    try {
+        for(size_t i{0};i < count;++i)
+            mThreads.emplace_back(std::mem_fn(&ContextMixer::threadProc), this);
+    }
+    catch(...) {
+        /* Keep whatever threads could be started. */
+    }
+}
+
+ContextMixer::~ContextMixer()
+{
+    mQuit.store(true, std::memory_order_release);
+    for(size_t i{0};i < mThreads.size();++i)
+        mStartSem.post();
+    for(auto &thrd : mThreads)
+        thrd.join();
+}
+
+void ContextMixer::threadProc()
+{
+    SetRTPriority();
+    althrd_setname(CONTEXT_MIXER_THREAD_NAME);
+
+    while(true)
+    {
+        mStartSem.wait();
+        if(mQuit.load(std::memory_order_acquire))
+            break;
+
+        FPUCtl mixer_mode{};
+        mixContexts();
+        mDoneSem.post();
+    }
+}
+
+void ContextMixer::mixContexts()
+{
+    const ALuint SamplesToDo{mSamplesToDo};
+    size_t idx;
+    while((idx=mNextContext.fetch_add(1, std::memory_order_relaxed)) < mContexts.size())
+    {
+        ALCcontext *ctx{mContexts[idx]};
+        ContextMixStorage *storage{ctx->mMixStorage.get()};
+        for(auto &buffer : storage->MixBuffer)
+            std::fill_n(buffer.begin(), SamplesToDo, 0.0f);
+        ProcessContext(ctx, MixBuffers{mDevice, storage}, SamplesToDo);
+    }
+}
+
+void ContextMixer::mix(ALCdevice *device, const al::span<ALCcontext*const> contexts,
+    const ALuint SamplesToDo)
+{
+    mDevice = device;
+    mContexts = contexts;
+    mSamplesToDo = SamplesToDo;
+    mNextContext.store(0, std::memory_order_relaxed);
+
+    /* The calling thread mixes contexts too, so only wake as many helpers as
+     * there are remaining contexts. A helper that finishes early may take
+     * another's wake-up, which is fine since each one is still answered.
+     */
+    const size_t helpers{std::min(contexts.size()-1, mThreads.size())};
+    for(size_t i{0};i < helpers;++i)
+        mStartSem.post();
+
+    mixContexts();
+
+    /* Wait for the helpers to finish, since they reference the mix state. */
+    for(size_t i{0};i < helpers;++i)
+        mDoneSem.wait();
+}
+
+
 void aluHandleDisconnect(ALCdevice *device, const char *msg, ...)
 {
     if(!device->Connected.exchange(false, std::memory_order_acq_rel))
         return;
 
-    AsyncEvent evt{EventType_Disconnected};
-    evt.u.user.type = AL_EVENT_TYPE_DISCONNECTED_SOFT;
-    evt.u.user.id = 0;
-    evt.u.user.param = 0;
-
     va_list args;
     va_start(args, msg);
-    int msglen{vsnprintf(evt.u.user.msg, sizeof(evt.u.user.msg), msg, args)};
+    int msglen{vsnprintf(device->DisconnectMsg, sizeof(device->DisconnectMsg), msg, args)};
     va_end(args);
 
-    if(msglen < 0 || static_cast<size_t>(msglen) >= sizeof(evt.u.user.msg))
-        evt.u.user.msg[sizeof(evt.u.user.msg)-1] = 0;
+    if(msglen < 0 || static_cast<size_t>(msglen) >= sizeof(device->DisconnectMsg))
+        device->DisconnectMsg[sizeof(device->DisconnectMsg)-1] = 0;
+
+    AsyncEvent evt{EventType_Disconnected};
+    evt.u.user.type = AL_EVENT_TYPE_DISCONNECTED_SOFT;
+    evt.u.user.id = 0;
+    evt.u.user.param = 0;
+    evt.u.user.msg = device->DisconnectMsg;
 
     IncrementRef(device->MixCount);
     for(ALCcontext *ctx : *device->mContexts.load())
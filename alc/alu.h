@@ -2,17 +2,23 @@
 #define ALU_H
 
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <thread>
 #include <type_traits>
 
 #include "AL/al.h"
 
 #include "alcmain.h"
 #include "alspan.h"
+#include "threads.h"
+#include "vector.h"
 
 struct ALbufferlistitem;
 struct ALeffectslot;
+struct Voice;
 
 
 #define MAX_PITCH  10
@@ -153,6 +159,138 @@ auto SetAmbiPanIdentity(T iter, I count, F func) -> std::enable_if_t<std::is_int
 }
 
 
+/**
+ * Temp storage and output buses for mixing a context on its own thread. The
+ * output buses mirror the device's MixBuffer, and get added to it once every
+ * context is mixed.
+ */
+struct ContextMixStorage {
+    alignas(16) float SourceData[BUFFERSIZE + MAX_RESAMPLER_PADDING];
+    alignas(16) float ResampledData[BUFFERSIZE];
+    alignas(16) float FilteredData[BUFFERSIZE];
+    union {
+        alignas(16) float HrtfSourceData[BUFFERSIZE + HRTF_HISTORY_LENGTH];
+        alignas(16) float NfcSampleData[BUFFERSIZE];
+    };
+    alignas(16) float2 HrtfAccumData[BUFFERSIZE + HRIR_LENGTH + HRTF_DIRECT_DELAY]{};
+
+    al::vector<FloatBufferLine, 16> MixBuffer;
+
+    DEF_NEWDEL(ContextMixStorage)
+};
+
+/**
+ * The buffers a context's voices and effects are mixed with. These are either
+ * the device's own, or a context's private storage.
+ */
+struct MixBuffers {
+    float *SourceData;
+    float *ResampledData;
+    float *FilteredData;
+    float *HrtfSourceData;
+    float *NfcSampleData;
+    float2 *HrtfAccumData;
+
+    /* Outputs to the device's mix buffer go to the same lines of this one. */
+    FloatBufferLine *DeviceMix;
+    FloatBufferLine *Mix;
+    size_t MixSize;
+
+    explicit MixBuffers(ALCdevice *device) noexcept
+      : SourceData{device->SourceData}, ResampledData{device->ResampledData}
+      , FilteredData{device->FilteredData}, HrtfSourceData{device->HrtfSourceData}
+      , NfcSampleData{device->NfcSampleData}, HrtfAccumData{device->HrtfAccumData}
+      , DeviceMix{device->MixBuffer.data()}, Mix{device->MixBuffer.data()}
+      , MixSize{device->MixBuffer.size()}
+    { }
+    MixBuffers(ALCdevice *device, ContextMixStorage *storage) noexcept
+      : SourceData{storage->SourceData}, ResampledData{storage->ResampledData}
+      , FilteredData{storage->FilteredData}, HrtfSourceData{storage->HrtfSourceData}
+      , NfcSampleData{storage->NfcSampleData}, HrtfAccumData{storage->HrtfAccumData}
+      , DeviceMix{device->MixBuffer.data()}, Mix{storage->MixBuffer.data()}
+      , MixSize{storage->MixBuffer.size()}
+    { }
+
+    /** Gets where output meant for the given target should be mixed. */
+    al::span<FloatBufferLine> getTarget(const al::span<FloatBufferLine> target) const noexcept
+    {
+        if(Mix == DeviceMix) return target;
+        const size_t offset{static_cast<size_t>(reinterpret_cast<uintptr_t>(target.data()) -
+            reinterpret_cast<uintptr_t>(DeviceMix)) / sizeof(FloatBufferLine)};
+        if(offset >= MixSize) return target;
+        return {Mix + offset, target.size()};
+    }
+};
+
+
+/**
+ * Calculates the sources' mixing parameters on a separate thread, while the
+ * mixer processes the effects and output of the current update. The new
+ * parameters then apply from the next update.
+ */
+class SourceUpdateThread {
+    std::thread mThread;
+    al::semaphore mStartSem;
+    al::semaphore mDoneSem;
+    std::atomic<bool> mQuit{false};
+
+    /* Only changed by the mixer while no update is running. */
+    ALCcontext *mContext{nullptr};
+    al::span<Voice*> mVoices;
+    bool mRunning{false};
+
+    void threadProc();
+
+public:
+    SourceUpdateThread();
+    SourceUpdateThread(const SourceUpdateThread&) = delete;
+    ~SourceUpdateThread();
+
+    SourceUpdateThread& operator=(const SourceUpdateThread&) = delete;
+
+    /** Starts updating the context's voices, once any previous update is done. */
+    void start(ALCcontext *context, const al::span<Voice*> voices);
+    /** Waits for the last started update to finish. */
+    void wait() noexcept;
+};
+
+/**
+ * Helper threads for mixing a device's contexts in parallel with the mixer
+ * thread. Each mix hands out the contexts through a shared index, so nothing
+ * is allocated or locked while mixing.
+ */
+class ContextMixer {
+    al::vector<std::thread> mThreads;
+    al::semaphore mStartSem;
+    al::semaphore mDoneSem;
+    std::atomic<bool> mQuit{false};
+
+    /* Only changed by the mixer while no mix is running. */
+    ALCdevice *mDevice{nullptr};
+    al::span<ALCcontext*const> mContexts;
+    ALuint mSamplesToDo{0};
+    std::atomic<size_t> mNextContext{0};
+
+    void threadProc();
+    void mixContexts();
+
+public:
+    ContextMixer(size_t count);
+    ContextMixer(const ContextMixer&) = delete;
+    ~ContextMixer();
+
+    ContextMixer& operator=(const ContextMixer&) = delete;
+
+    size_t size() const noexcept { return mThreads.size(); }
+
+    /**
+     * Mixes each context into its own storage, using the helper threads and
+     * the calling thread. Returns once all the contexts are mixed.
+     */
+    void mix(ALCdevice *device, const al::span<ALCcontext*const> contexts,
+        const ALuint SamplesToDo);
+};
+
 void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
     const size_t FrameStep);
 /* Caller must lock the device state, and the mixer must not be running. */
@@ -871,6 +871,7 @@ struct AlsaCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
     ClockLatency getClockLatency() override;
 
     snd_pcm_t *mPcmHandle{nullptr};
@@ -1161,6 +1162,9 @@ ALCuint AlsaCapture::availableSamples()
     return static_cast<ALCuint>(mRing->readSpace());
 }
 
+RingBuffer *AlsaCapture::getCaptureRing()
+{ return mRing.get(); }
+
 ClockLatency AlsaCapture::getClockLatency()
 {
     ClockLatency ret;
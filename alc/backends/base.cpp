@@ -31,6 +31,12 @@ ALCenum BackendBase::captureSamples(al::byte*, ALCuint)
 ALCuint BackendBase::availableSamples()
 { return 0; }
 
+RingBuffer *BackendBase::getCaptureRing()
+{ return nullptr; }
+
+bool BackendBase::callsCaptureReady()
+{ return false; }
+
 ClockLatency BackendBase::getClockLatency()
 {
     ClockLatency ret;
@@ -53,6 +59,13 @@ ClockLatency BackendBase::getClockLatency()
     return ret;
 }
 
+void BackendBase::captureReady(size_t available)
+{
+    LPALCCAPTURECALLBACKTYPESOFT callback{mDevice->mCaptureCallback};
+    if(callback && available >= mDevice->mCaptureChunk)
+        callback(mDevice, static_cast<ALCsizei>(available), mDevice->mCaptureUserPtr);
+}
+
 void BackendBase::setDefaultWFXChannelOrder()
 {
     mDevice->RealOut.ChannelIndex.fill(INVALID_CHANNEL_INDEX);
@@ -12,6 +12,7 @@
 #include "alcmain.h"
 #include "alexcpt.h"
 
+struct RingBuffer;
 
 struct ClockLatency {
     std::chrono::nanoseconds ClockTime;
@@ -27,6 +28,17 @@ struct BackendBase {
 
     virtual ALCenum captureSamples(al::byte *buffer, ALCuint samples);
     virtual ALCuint availableSamples();
+    /**
+     * Returns the ring buffer holding the captured samples in the device's
+     * format, for reading in place, or null if the backend doesn't keep them
+     * that way.
+     */
+    virtual RingBuffer *getCaptureRing();
+    /**
+     * Returns whether the backend calls captureReady as samples arrive, which
+     * the capture callback relies on.
+     */
+    virtual bool callsCaptureReady();
 
     virtual ClockLatency getClockLatency();
 
@@ -40,6 +52,12 @@ protected:
     void setDefaultChannelOrder();
     /** Sets the default channel order used by WaveFormatEx. */
     void setDefaultWFXChannelOrder();
+    /**
+     * Calls the device's capture callback, if any, when there's at least its
+     * chunk size of samples available. For backends with a capture thread, to
+     * call after adding samples to the capture ring.
+     */
+    void captureReady(size_t available);
 
 #ifdef _WIN32
     /** Sets the channel order given the WaveFormatEx mask. */
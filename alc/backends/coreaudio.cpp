@@ -304,6 +304,8 @@ struct CoreAudioCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
+    bool callsCaptureReady() override;
 
     AudioUnit mAudioUnit{0};
 
@@ -368,6 +370,8 @@ OSStatus CoreAudioCapture::RecordProc(AudioUnitRenderActionFlags*,
     }
 
     mRing->writeAdvance(inNumberFrames);
+    if(!mConverter)
+        captureReady(mRing->readSpace());
     return noErr;
 }
 
@@ -617,6 +621,12 @@ ALCuint CoreAudioCapture::availableSamples()
     return mConverter->availableOut(static_cast<ALCuint>(mRing->readSpace()));
 }
 
+RingBuffer *CoreAudioCapture::getCaptureRing()
+{ return mConverter ? nullptr : mRing.get(); }
+
+bool CoreAudioCapture::callsCaptureReady()
+{ return !mConverter; }
+
 } // namespace
 
 BackendFactory &CoreAudioBackendFactory::getFactory()
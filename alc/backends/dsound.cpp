@@ -559,6 +559,7 @@ struct DSoundCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
 
     IDirectSoundCapture *mDSC{nullptr};
     IDirectSoundCaptureBuffer *mDSCbuffer{nullptr};
@@ -764,6 +765,9 @@ ALCuint DSoundCapture::availableSamples()
     return static_cast<ALCuint>(mRing->readSpace());
 }
 
+RingBuffer *DSoundCapture::getCaptureRing()
+{ return mRing.get(); }
+
 } // namespace
 
 
@@ -466,6 +466,8 @@ struct OSScapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
+    bool callsCaptureReady() override;
 
     int mFd{-1};
 
@@ -524,6 +526,7 @@ int OSScapture::recordProc()
                 break;
             }
             mRing->writeAdvance(static_cast<ALuint>(amt)/frame_size);
+            captureReady(mRing->readSpace());
         }
     }
 
@@ -642,6 +645,12 @@ ALCenum OSScapture::captureSamples(al::byte *buffer, ALCuint samples)
 ALCuint OSScapture::availableSamples()
 { return static_cast<ALCuint>(mRing->readSpace()); }
 
+RingBuffer *OSScapture::getCaptureRing()
+{ return mRing.get(); }
+
+bool OSScapture::callsCaptureReady()
+{ return true; }
+
 } // namespace
 
 
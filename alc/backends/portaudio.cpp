@@ -244,6 +244,8 @@ struct PortCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
+    bool callsCaptureReady() override;
 
     PaStream *mStream{nullptr};
     PaStreamParameters mParams;
@@ -266,6 +268,7 @@ int PortCapture::readCallback(const void *inputBuffer, void*, unsigned long fram
     const PaStreamCallbackTimeInfo*, const PaStreamCallbackFlags) noexcept
 {
     mRing->write(inputBuffer, framesPerBuffer);
+    captureReady(mRing->readSpace());
     return 0;
 }
 
@@ -342,6 +345,12 @@ void PortCapture::stop()
 ALCuint PortCapture::availableSamples()
 { return static_cast<ALCuint>(mRing->readSpace()); }
 
+RingBuffer *PortCapture::getCaptureRing()
+{ return mRing.get(); }
+
+bool PortCapture::callsCaptureReady()
+{ return true; }
+
 ALCenum PortCapture::captureSamples(al::byte *buffer, ALCuint samples)
 {
     mRing->read(buffer, samples);
@@ -298,6 +298,8 @@ struct SndioCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
+    bool callsCaptureReady() override;
 
     sio_hdl *mSndHandle{nullptr};
 
@@ -357,6 +359,7 @@ int SndioCapture::recordProc()
             total += got;
         }
         mRing->writeAdvance(total / frameSize);
+        captureReady(mRing->readSpace());
     }
 
     return 0;
@@ -480,6 +483,12 @@ ALCenum SndioCapture::captureSamples(al::byte *buffer, ALCuint samples)
 ALCuint SndioCapture::availableSamples()
 { return static_cast<ALCuint>(mRing->readSpace()); }
 
+RingBuffer *SndioCapture::getCaptureRing()
+{ return mRing.get(); }
+
+bool SndioCapture::callsCaptureReady()
+{ return true; }
+
 } // namespace
 
 BackendFactory &SndIOBackendFactory::getFactory()
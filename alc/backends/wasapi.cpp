@@ -1196,6 +1196,8 @@ struct WasapiCapture final : public BackendBase, WasapiProxy {
 
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
+    bool callsCaptureReady() override;
 
     std::wstring mDevId;
 
@@ -1297,6 +1299,7 @@ FORCE_ALIGN int WasapiCapture::recordProc()
                 }
 
                 mRing->writeAdvance(dstframes);
+                captureReady(mRing->readSpace());
 
                 hr = mCapture->ReleaseBuffer(numsamples);
                 if(FAILED(hr)) ERR("Failed to release capture buffer: 0x%08lx\n", hr);
@@ -1715,6 +1718,12 @@ void WasapiCapture::stopProxy()
 ALCuint WasapiCapture::availableSamples()
 { return static_cast<ALCuint>(mRing->readSpace()); }
 
+RingBuffer *WasapiCapture::getCaptureRing()
+{ return mRing.get(); }
+
+bool WasapiCapture::callsCaptureReady()
+{ return true; }
+
 ALCenum WasapiCapture::captureSamples(al::byte *buffer, ALCuint samples)
 {
     mRing->read(buffer, samples);
@@ -23,6 +23,7 @@
 #include "backends/wave.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cerrno>
 #include <chrono>
@@ -90,12 +91,69 @@ void fwrite32le(ALuint val, FILE *f)
     fwrite(data, 1, 4, f);
 }
 
+void fwrite64le(uint64_t val, FILE *f)
+{
+    fwrite32le(static_cast<ALuint>(val&0xffffffff), f);
+    fwrite32le(static_cast<ALuint>(val>>32), f);
+}
+
+/* 64-bit file offsets, so RF64 files larger than 2/4GB can be finalized. */
+int64_t ftell64(FILE *f)
+{
+#ifdef _WIN32
+    return _ftelli64(f);
+#else
+    return ftello(f);
+#endif
+}
+
+int fseek64(FILE *f, int64_t offset, int whence)
+{
+#ifdef _WIN32
+    return _fseeki64(f, offset, whence);
+#else
+    return fseeko(f, static_cast<off_t>(offset), whence);
+#endif
+}
+
+void SwapSamplesToLE(al::byte *buffer, const size_t len, const ALuint bytesize)
+{
+    if(IS_LITTLE_ENDIAN) return;
+
+    if(bytesize == 2)
+    {
+        ALushort *samples = reinterpret_cast<ALushort*>(buffer);
+        for(size_t i{0};i < len/2;i++)
+        {
+            const ALushort samp{samples[i]};
+            samples[i] = static_cast<ALushort>((samp>>8) | (samp<<8));
+        }
+    }
+    else if(bytesize == 4)
+    {
+        ALuint *samples = reinterpret_cast<ALuint*>(buffer);
+        for(size_t i{0};i < len/4;i++)
+        {
+            const ALuint samp{samples[i]};
+            samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
+                         ((samp<<8)&0x00ff0000) | (samp<<24);
+        }
+    }
+}
+
+/* Size of the 'ds64' chunk data, which is reserved as a 'JUNK' chunk until
+ * the file is finalized and found to need RF64.
+ */
+constexpr ALuint Ds64ChunkSize{28};
+
 
 struct WaveBackend final : public BackendBase {
     WaveBackend(ALCdevice *device) noexcept : BackendBase{device} { }
     ~WaveBackend() override;
 
     int mixerProc();
+    int freeRunProc();
+    int writerProc();
 
     void open(const ALCchar *name) override;
     bool reset() override;
@@ -103,10 +161,23 @@ struct WaveBackend final : public BackendBase {
     void stop() override;
 
     FILE *mFile{nullptr};
-    long mDataStart{-1};
+    int64_t mDataStart{-1};
 
     al::vector<al::byte> mBuffer;
 
+    /* When free-running, the mixer renders as fast as it can into one of two
+     * large chunks while the writer thread writes out the other. A chunk with
+     * no samples tells the writer to quit.
+     */
+    bool mFreeRun{false};
+    ALuint mChunkSamples{0u};
+    std::array<al::vector<al::byte>,2> mChunks;
+    std::array<ALuint,2> mChunkFill{};
+    al::semaphore mChunksFree{2};
+    al::semaphore mChunksReady;
+    std::atomic<bool> mWriteFailed{false};
+    std::thread mWriterThread;
+
     std::atomic<bool> mKillNow{true};
     std::thread mThread;
 
@@ -149,32 +220,7 @@ int WaveBackend::mixerProc()
             aluMixData(mDevice, mBuffer.data(), mDevice->UpdateSize, frameStep);
             done += mDevice->UpdateSize;
 
-            if(!IS_LITTLE_ENDIAN)
-            {
-                const ALuint bytesize{mDevice->bytesFromFmt()};
-
-                if(bytesize == 2)
-                {
-                    ALushort *samples = reinterpret_cast<ALushort*>(mBuffer.data());
-                    const size_t len{mBuffer.size() / 2};
-                    for(size_t i{0};i < len;i++)
-                    {
-                        const ALushort samp{samples[i]};
-                        samples[i] = static_cast<ALushort>((samp>>8) | (samp<<8));
-                    }
-                }
-                else if(bytesize == 4)
-                {
-                    ALuint *samples = reinterpret_cast<ALuint*>(mBuffer.data());
-                    const size_t len{mBuffer.size() / 4};
-                    for(size_t i{0};i < len;i++)
-                    {
-                        const ALuint samp{samples[i]};
-                        samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
-                                     ((samp<<8)&0x00ff0000) | (samp<<24);
-                    }
-                }
-            }
+            SwapSamplesToLE(mBuffer.data(), mBuffer.size(), mDevice->bytesFromFmt());
 
             size_t fs{fwrite(mBuffer.data(), frameSize, mDevice->UpdateSize, mFile)};
             (void)fs;
@@ -202,6 +248,73 @@ int WaveBackend::mixerProc()
     return 0;
 }
 
+int WaveBackend::freeRunProc()
+{
+    althrd_setname(MIXER_THREAD_NAME);
+
+    const size_t frameStep{mDevice->channelsFromFmt()};
+    const ALuint frameSize{mDevice->frameSizeFromFmt()};
+
+    size_t idx{0};
+    while(!mKillNow.load(std::memory_order_acquire) &&
+          mDevice->Connected.load(std::memory_order_acquire))
+    {
+        if UNLIKELY(mWriteFailed.load(std::memory_order_acquire))
+        {
+            aluHandleDisconnect(mDevice, "Failed to write playback samples");
+            break;
+        }
+
+        mChunksFree.wait();
+
+        al::vector<al::byte> &chunk = mChunks[idx];
+        aluMixData(mDevice, chunk.data(), mChunkSamples, frameStep);
+        SwapSamplesToLE(chunk.data(), size_t{mChunkSamples}*frameSize, mDevice->bytesFromFmt());
+        mChunkFill[idx] = mChunkSamples;
+
+        mChunksReady.post();
+        idx ^= 1;
+    }
+
+    /* Send an empty chunk to stop the writer once it's done with the rest. */
+    mChunksFree.wait();
+    mChunkFill[idx] = 0;
+    mChunksReady.post();
+
+    return 0;
+}
+
+int WaveBackend::writerProc()
+{
+    althrd_setname("alsoft-wavewr");
+
+    const ALuint frameSize{mDevice->frameSizeFromFmt()};
+
+    size_t idx{0};
+    while(true)
+    {
+        mChunksReady.wait();
+
+        const ALuint todo{mChunkFill[idx]};
+        if(todo > 0 && !mWriteFailed.load(std::memory_order_relaxed))
+        {
+            size_t fs{fwrite(mChunks[idx].data(), frameSize, todo, mFile)};
+            (void)fs;
+            if(ferror(mFile))
+            {
+                ERR("Error writing to file\n");
+                mWriteFailed.store(true, std::memory_order_release);
+            }
+        }
+
+        mChunksFree.post();
+        if(todo == 0) break;
+        idx ^= 1;
+    }
+
+    return 0;
+}
+
 void WaveBackend::open(const ALCchar *name)
 {
     const char *fname{GetConfigValue(nullptr, "wave", "file", "")};
@@ -287,6 +400,14 @@ bool WaveBackend::reset()
 
     fputs("WAVE", mFile);
 
+    /* Reserve space for a 'ds64' chunk, in case the output ends up too large
+     * for the 32-bit RIFF sizes and needs to be converted to RF64 at close.
+     */
+    fputs("JUNK", mFile);
+    fwrite32le(Ds64ChunkSize, mFile);
+    for(ALuint i{0};i < Ds64ChunkSize;i += 4)
+        fwrite32le(0, mFile);
+
     fputs("fmt ", mFile);
     fwrite32le(40, mFile); // 'fmt ' header len; 40 bytes for EXTENSIBLE
 
@@ -322,12 +443,29 @@ bool WaveBackend::reset()
         ERR("Error writing header: %s\n", strerror(errno));
         return false;
     }
-    mDataStart = ftell(mFile);
+    mDataStart = ftell64(mFile);
 
     setDefaultWFXChannelOrder();
 
-    const ALuint bufsize{mDevice->frameSizeFromFmt() * mDevice->UpdateSize};
-    mBuffer.resize(bufsize);
+    mFreeRun = GetConfigValueBool(nullptr, "wave", "free-run", 0) != 0;
+    if(!mFreeRun)
+    {
+        const ALuint bufsize{mDevice->frameSizeFromFmt() * mDevice->UpdateSize};
+        mBuffer.resize(bufsize);
+        for(auto &chunk : mChunks)
+            decltype(mBuffer){}.swap(chunk);
+    }
+    else
+    {
+        /* Render about a second's worth of samples at a time (rounded up to
+         * whole updates), so file writes are few and large.
+         */
+        const ALuint updates{(mDevice->Frequency+mDevice->UpdateSize-1) / mDevice->UpdateSize};
+        mChunkSamples = mDevice->UpdateSize * updates;
+        for(auto &chunk : mChunks)
+            chunk.resize(size_t{mChunkSamples} * mDevice->frameSizeFromFmt());
+        decltype(mBuffer){}.swap(mBuffer);
+    }
 
     return true;
 }
@@ -336,7 +474,24 @@ void WaveBackend::start()
 {
     try {
         mKillNow.store(false, std::memory_order_release);
-        mThread = std::thread{std::mem_fn(&WaveBackend::mixerProc), this};
+        if(!mFreeRun)
+            mThread = std::thread{std::mem_fn(&WaveBackend::mixerProc), this};
+        else
+        {
+            mWriteFailed.store(false, std::memory_order_relaxed);
+            mWriterThread = std::thread{std::mem_fn(&WaveBackend::writerProc), this};
+            try {
+                mThread = std::thread{std::mem_fn(&WaveBackend::freeRunProc), this};
+            }
+            catch(...) {
+                /* Stop the writer by handing it an empty chunk. */
+                mChunksFree.wait();
+                mChunkFill[0] = 0;
+                mChunksReady.post();
+                mWriterThread.join();
+                throw;
+            }
+        }
     }
     catch(std::exception& e) {
         throw al::backend_exception{ALC_INVALID_DEVICE, "Failed to start mixing thread: %s",
@@ -349,15 +504,39 @@ void WaveBackend::stop()
     if(mKillNow.exchange(true, std::memory_order_acq_rel) || !mThread.joinable())
         return;
     mThread.join();
+    if(mWriterThread.joinable())
+        mWriterThread.join();
 
-    long size{ftell(mFile)};
+    const int64_t size{ftell64(mFile)};
     if(size > 0)
     {
-        long dataLen{size - mDataStart};
-        if(fseek(mFile, mDataStart-4, SEEK_SET) == 0)
-            fwrite32le(static_cast<ALuint>(dataLen), mFile); // 'data' header len
-        if(fseek(mFile, 4, SEEK_SET) == 0)
-            fwrite32le(static_cast<ALuint>(size-8), mFile); // 'WAVE' header len
+        const auto dataLen = static_cast<uint64_t>(size - mDataStart);
+        const auto riffLen = static_cast<uint64_t>(size - 8);
+        if(riffLen <= 0xFFFFFFFF)
+        {
+            if(fseek64(mFile, mDataStart-4, SEEK_SET) == 0)
+                fwrite32le(static_cast<ALuint>(dataLen), mFile); // 'data' header len
+            if(fseek64(mFile, 4, SEEK_SET) == 0)
+                fwrite32le(static_cast<ALuint>(riffLen), mFile); // 'WAVE' header len
+        }
+        else
+        {
+            /* Too big for RIFF. Convert to RF64, with the real sizes stored in
+             * the 'ds64' chunk in place of the reserved 'JUNK' chunk. The
+             * 32-bit sizes are left as 0xFFFFFFFF.
+             */
+            if(fseek64(mFile, 0, SEEK_SET) == 0)
+                fputs("RF64", mFile);
+            if(fseek64(mFile, 12, SEEK_SET) == 0)
+            {
+                fputs("ds64", mFile);
+                fwrite32le(Ds64ChunkSize, mFile);
+                fwrite64le(riffLen, mFile); // 'RF64' len
+                fwrite64le(dataLen, mFile); // 'data' len
+                fwrite64le(dataLen / mDevice->frameSizeFromFmt(), mFile); // sample frames
+                fwrite32le(0, mFile); // table length
+            }
+        }
     }
 }
 
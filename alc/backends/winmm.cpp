@@ -380,6 +380,8 @@ struct WinMMCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(al::byte *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    RingBuffer *getCaptureRing() override;
+    bool callsCaptureReady() override;
 
     std::atomic<ALuint> mReadable{0u};
     al::semaphore mSem;
@@ -445,6 +447,7 @@ int WinMMCapture::captureProc()
             waveInAddBuffer(mInHdl, &waveHdr, sizeof(WAVEHDR));
         } while(--todo);
         mIdx = static_cast<ALuint>(widx);
+        captureReady(mRing->readSpace());
     }
 
     return 0;
@@ -584,6 +587,12 @@ ALCenum WinMMCapture::captureSamples(al::byte *buffer, ALCuint samples)
 ALCuint WinMMCapture::availableSamples()
 { return static_cast<ALCuint>(mRing->readSpace()); }
 
+RingBuffer *WinMMCapture::getCaptureRing()
+{ return mRing.get(); }
+
+bool WinMMCapture::callsCaptureReady()
+{ return true; }
+
 } // namespace
 
 
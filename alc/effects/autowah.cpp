@@ -24,6 +24,7 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <array>
 
 #include "al/auxeffectslot.h"
 #include "alcmain.h"
@@ -38,6 +39,39 @@ namespace {
 #define MAX_FREQ 2500.0f
 #define Q_FACTOR 5.0f
 
+/* Number of steps in the cosine/sine table, covering normalized frequencies
+ * from 0 to nyquist.
+ */
+#define WAH_TABLE_BITS 9
+#define WAH_TABLE_SIZE (1<<WAH_TABLE_BITS)
+
+/* Number of samples filtered for all channels before mixing them out. */
+#define WAH_CHUNK_SIZE 128
+
+struct CosSin {
+    float cos, sin;
+};
+
+/* Define a table of the cosine and sine of w0 for the envelope-controlled
+ * frequency. The remaining fraction between entries is applied with the angle
+ * sum identities, using a short Taylor series for the small angle. Plain
+ * linear interpolation isn't enough since the filter is very sensitive to
+ * error in the cosine at low frequencies.
+ */
+std::array<CosSin,WAH_TABLE_SIZE> InitCosSinTable()
+{
+    std::array<CosSin,WAH_TABLE_SIZE> ret;
+    for(size_t i{0};i < WAH_TABLE_SIZE;i++)
+    {
+        constexpr double scale{al::MathDefs<double>::Pi() / double{WAH_TABLE_SIZE}};
+        const double w0{static_cast<double>(i) * scale};
+        ret[i].cos = static_cast<float>(std::cos(w0));
+        ret[i].sin = static_cast<float>(std::sin(w0));
+    }
+    return ret;
+}
+alignas(16) const std::array<CosSin,WAH_TABLE_SIZE> CosSinTable = InitCosSinTable();
+
 struct AutowahState final : public EffectState {
     /* Effect parameters */
     float mAttackRate;
@@ -48,25 +82,26 @@ struct AutowahState final : public EffectState {
     float mBandwidthNorm;
     float mEnvDelay;
 
-    /* Filter components derived from the envelope. */
+    /* Normalized filter coefficients derived from the envelope. The a1
+     * coefficient is the same as b1 for a peaking filter.
+     */
     struct {
-        float cos_w0;
-        float alpha;
+        float b0, b1, b2;
+        float a2;
     } mEnv[BUFFERSIZE];
 
-    struct {
-        /* Effect filters' history. */
-        struct {
-            float z1, z2;
-        } Filter;
+    /* Effect filters' history. */
+    float mFilterZ1[MAX_AMBI_CHANNELS];
+    float mFilterZ2[MAX_AMBI_CHANNELS];
 
+    struct {
         /* Effect gains for each output channel */
         float CurrentGains[MAX_OUTPUT_CHANNELS];
         float TargetGains[MAX_OUTPUT_CHANNELS];
     } mChans[MAX_AMBI_CHANNELS];
 
     /* Effects buffers */
-    alignas(16) float mBufferOut[BUFFERSIZE];
+    alignas(16) float mBufferOut[MAX_AMBI_CHANNELS][WAH_CHUNK_SIZE];
 
 
     void deviceUpdate(const ALCdevice *device) override;
@@ -90,16 +125,16 @@ void AutowahState::deviceUpdate(const ALCdevice*)
 
     for(auto &e : mEnv)
     {
-        e.cos_w0 = 0.0f;
-        e.alpha = 0.0f;
+        e.b0 = 1.0f;
+        e.b1 = 0.0f;
+        e.b2 = 0.0f;
+        e.a2 = 0.0f;
     }
 
     for(auto &chan : mChans)
-    {
         std::fill(std::begin(chan.CurrentGains), std::end(chan.CurrentGains), 0.0f);
-        chan.Filter.z1 = 0.0f;
-        chan.Filter.z2 = 0.0f;
-    }
+    std::fill(std::begin(mFilterZ1), std::end(mFilterZ1), 0.0f);
+    std::fill(std::begin(mFilterZ2), std::end(mFilterZ2), 0.0f);
 }
 
 void AutowahState::update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target)
@@ -135,7 +170,7 @@ void AutowahState::process(const size_t samplesToDo, const al::span<const FloatB
     float env_delay{mEnvDelay};
     for(size_t i{0u};i < samplesToDo;i++)
     {
-        float w0, sample, a;
+        float sample, a;
 
         /* Envelope follower described on the book: Audio Effects, Theory,
          * Implementation and Application.
@@ -144,52 +179,70 @@ void AutowahState::process(const size_t samplesToDo, const al::span<const FloatB
         a = (sample > env_delay) ? attack_rate : release_rate;
         env_delay = lerp(sample, env_delay, a);
 
-        /* Calculate the cos and alpha components for this sample's filter. */
-        w0 = minf((bandwidth*env_delay + freq_min), 0.46f) * al::MathDefs<float>::Tau();
-        mEnv[i].cos_w0 = std::cos(w0);
-        mEnv[i].alpha = std::sin(w0)/(2.0f * Q_FACTOR);
+        /* Look up the cos and sin components for this sample's filter. The
+         * frequency is clamped below nyquist, so the index stays in range.
+         */
+        const float fpos{minf((bandwidth*env_delay + freq_min), 0.46f) * (WAH_TABLE_SIZE*2.0f)};
+        const auto idx = static_cast<size_t>(fpos);
+        const float d{(fpos - static_cast<float>(idx)) *
+            (al::MathDefs<float>::Pi() / WAH_TABLE_SIZE)};
+        const float d2{d * d};
+        const float cos_d{1.0f - d2*(1.0f/2.0f)};
+        const float sin_d{d * (1.0f - d2*(1.0f/6.0f))};
+        const CosSin &entry = CosSinTable[idx];
+        const float cos_w0{entry.cos*cos_d - entry.sin*sin_d};
+        const float alpha{(entry.sin*cos_d + entry.cos*sin_d) / (2.0f*Q_FACTOR)};
+
+        /* This effectively inlines BiquadFilter_setParams for a peaking
+         * filter, normalized by a0. The coefficients are the same for each
+         * channel, so calculate them once here.
+         */
+        const float a0_inv{1.0f / (1.0f + alpha/res_gain)};
+        mEnv[i].b0 = (1.0f + alpha*res_gain) * a0_inv;
+        mEnv[i].b1 = -2.0f * cos_w0 * a0_inv;
+        mEnv[i].b2 = (1.0f - alpha*res_gain) * a0_inv;
+        mEnv[i].a2 = (1.0f - alpha/res_gain) * a0_inv;
     }
     mEnvDelay = env_delay;
 
-    auto chandata = std::addressof(mChans[0]);
-    for(const auto &insamples : samplesIn)
+    /* This effectively inlines BiquadFilter_processC. The filter
+     * coefficients were previously calculated with the envelope. Because the
+     * filter changes for each sample, the coefficients are transient and don't
+     * need to be held.
+     *
+     * The channels are filtered together, sample by sample, since they share
+     * coefficients and each channel's filter is a serial dependency chain. The
+     * output is mixed in chunks to keep the intermediate buffer small.
+     */
+    const size_t numchans{samplesIn.size()};
+    float *RESTRICT z1{mFilterZ1};
+    float *RESTRICT z2{mFilterZ2};
+    for(size_t base{0u};base < samplesToDo;)
     {
-        /* This effectively inlines BiquadFilter_setParams for a peaking
-         * filter and BiquadFilter_processC. The alpha and cosine components
-         * for the filter coefficients were previously calculated with the
-         * envelope. Because the filter changes for each sample, the
-         * coefficients are transient and don't need to be held.
-         */
-        float z1{chandata->Filter.z1};
-        float z2{chandata->Filter.z2};
+        const size_t todo{minz(samplesToDo-base, WAH_CHUNK_SIZE)};
 
-        for(size_t i{0u};i < samplesToDo;i++)
+        for(size_t i{0u};i < todo;i++)
         {
-            const float alpha{mEnv[i].alpha};
-            const float cos_w0{mEnv[i].cos_w0};
-            float input, output;
-            float a[3], b[3];
-
-            b[0] =  1.0f + alpha*res_gain;
-            b[1] = -2.0f * cos_w0;
-            b[2] =  1.0f - alpha*res_gain;
-            a[0] =  1.0f + alpha/res_gain;
-            a[1] = -2.0f * cos_w0;
-            a[2] =  1.0f - alpha/res_gain;
-
-            input = insamples[i];
-            output = input*(b[0]/a[0]) + z1;
-            z1 = input*(b[1]/a[0]) - output*(a[1]/a[0]) + z2;
-            z2 = input*(b[2]/a[0]) - output*(a[2]/a[0]);
-            mBufferOut[i] = output;
+            const float b0{mEnv[base+i].b0};
+            const float b1{mEnv[base+i].b1};
+            const float b2{mEnv[base+i].b2};
+            const float a2{mEnv[base+i].a2};
+            for(size_t c{0u};c < numchans;c++)
+            {
+                const float input{samplesIn[c][base+i]};
+                const float output{input*b0 + z1[c]};
+                z1[c] = (input-output)*b1 + z2[c];
+                z2[c] = input*b2 - output*a2;
+                mBufferOut[c][i] = output;
+            }
         }
-        chandata->Filter.z1 = z1;
-        chandata->Filter.z2 = z2;
 
         /* Now, mix the processed sound data to the output. */
-        MixSamples({mBufferOut, samplesToDo}, samplesOut, chandata->CurrentGains,
-            chandata->TargetGains, samplesToDo, 0);
-        ++chandata;
+        for(size_t c{0u};c < numchans;c++)
+            MixSamples({mBufferOut[c], todo}, samplesOut, mChans[c].CurrentGains,
+                mChans[c].TargetGains, samplesToDo-base, base);
+
+        base += todo;
     }
 }
 
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <tuple>
 
 #include "al/auxeffectslot.h"
 #include "alcmain.h"
@@ -43,7 +44,7 @@ struct DistortionState final : public EffectState {
     float mAttenuation{};
     float mEdgeCoeff{};
 
-    float mBuffer[2][BUFFERSIZE]{};
+    alignas(16) float mBuffer[BUFFERSIZE]{};
 
 
     void deviceUpdate(const ALCdevice *device) override;
@@ -90,63 +91,59 @@ void DistortionState::update(const ALCcontext *context, const ALeffectslot *slot
 
 void DistortionState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
+    /* The waveshaper applies f(x) = (1+fc)*x / (1+fc*|x|) three times, with
+     * the middle step negated. Since f is odd and a Mobius transform for
+     * either sign of x, the three steps combine into one:
+     * -(1+fc)^3*x / (1 + fc*(1 + (1+fc) + (1+fc)^2)*|x|)
+     */
     const float fc{mEdgeCoeff};
-    for(size_t base{0u};base < samplesToDo;)
+    const float k{1.0f + fc};
+    const float shape_num{-k*k*k};
+    const float shape_den{fc * (1.0f + k + k*k)};
+    auto proc_sample = [shape_num,shape_den](float smp) -> float
+    { return shape_num*smp / (1.0f + shape_den*std::abs(smp)); };
+
+    float lpz1, lpz2, bpz1, bpz2;
+    std::tie(lpz1, lpz2) = mLowpass.getComponents();
+    std::tie(bpz1, bpz2) = mBandpass.getComponents();
+    for(size_t i{0u};i < samplesToDo;i++)
     {
         /* Perform 4x oversampling to avoid aliasing. Oversampling greatly
          * improves distortion quality and allows to implement lowpass and
          * bandpass filters using high frequencies, at which classic IIR
          * filters became unstable.
+         *
+         * The oversampled input is zero-stuffed, multiplying the sample by
+         * the amount of oversampling to maintain the signal's power. The
+         * lowpass filter of the original signal also does the interpolation
+         * and lowpass cutoff for oversampling, and only needs the recursive
+         * part for the stuffed zeros.
+         *
+         * Each oversampled sample is then distorted with the waveshaper to
+         * emulate signal processing during tube overdriving, and bandpass
+         * filtered. Decimation stores only one sample out of four.
          */
-        size_t todo{minz(BUFFERSIZE, (samplesToDo-base) * 4)};
-
-        /* Fill oversample buffer using zero stuffing. Multiply the sample by
-         * the amount of oversampling to maintain the signal's power.
-         */
-        for(size_t i{0u};i < todo;i++)
-            mBuffer[0][i] = !(i&3) ? samplesIn[0][(i>>2)+base] * 4.0f : 0.0f;
-
-        /* First step, do lowpass filtering of original signal. Additionally
-         * perform buffer interpolation and lowpass cutoff for oversampling
-         * (which is fortunately first step of distortion). So combine three
-         * operations into the one.
-         */
-        mLowpass.process({mBuffer[0], todo}, mBuffer[1]);
-
-        /* Second step, do distortion using waveshaper function to emulate
-         * signal processing during tube overdriving. Three steps of
-         * waveshaping are intended to modify waveform without boost/clipping/
-         * attenuation process.
-         */
-        auto proc_sample = [fc](float smp) -> float
-        {
-            smp = (1.0f + fc) * smp/(1.0f + fc*std::abs(smp));
-            smp = (1.0f + fc) * smp/(1.0f + fc*std::abs(smp)) * -1.0f;
-            smp = (1.0f + fc) * smp/(1.0f + fc*std::abs(smp));
-            return smp;
-        };
-        std::transform(std::begin(mBuffer[1]), std::begin(mBuffer[1])+todo, std::begin(mBuffer[0]),
-            proc_sample);
-
-        /* Third step, do bandpass filtering of distorted signal. */
-        mBandpass.process({mBuffer[0], todo}, mBuffer[1]);
-
-        todo >>= 2;
-        const float *outgains{mGain};
-        for(FloatBufferLine &output : samplesOut)
+        float smp{mLowpass.processOne(samplesIn[0][i] * 4.0f, lpz1, lpz2)};
+        mBuffer[i] = mBandpass.processOne(proc_sample(smp), bpz1, bpz2);
+        for(size_t j{1u};j < 4;j++)
         {
-            /* Fourth step, final, do attenuation and perform decimation,
-             * storing only one sample out of four.
-             */
-            const float gain{*(outgains++)};
-            if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
-                continue;
-
-            for(size_t i{0u};i < todo;i++)
-                output[base+i] += gain * mBuffer[1][i*4];
+            smp = mLowpass.processZero(lpz1, lpz2);
+            mBandpass.processOne(proc_sample(smp), bpz1, bpz2);
         }
+    }
+    mLowpass.setComponents(lpz1, lpz2);
+    mBandpass.setComponents(bpz1, bpz2);
+
+    const float *outgains{mGain};
+    for(FloatBufferLine &output : samplesOut)
+    {
+        /* Final step, do attenuation. */
+        const float gain{*(outgains++)};
+        if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
 
-        base += todo;
+        for(size_t i{0u};i < samplesToDo;i++)
+            output[i] += gain * mBuffer[i];
     }
 }
 
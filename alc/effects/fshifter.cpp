@@ -32,6 +32,12 @@
 #include "alu.h"
 
 #include "alcomplex.h"
+#include "filters/hilbert.h"
+
+/* This is a user config option for using the IIR all-pass Hilbert transform
+ * instead of the FFT-based one.
+ */
+bool FshifterIIRHilbert = false;
 
 namespace {
 
@@ -58,9 +64,16 @@ std::array<double,HIL_SIZE> InitHannWindow()
 }
 alignas(16) const std::array<double,HIL_SIZE> HannWindow = InitHannWindow();
 
+/* The FFT path's overlap-added squared Hann windows sum to 1.5, which the
+ * 2/OVERSAMP output scale brings to an overall gain of 0.75. The IIR path is
+ * scaled to match, so switching between them doesn't change the level.
+ */
+constexpr float IirHilbertGain{1.5f * 2.0f / OVERSAMP};
+
 
 struct FshifterState final : public EffectState {
     /* Effect parameters */
+    bool mUseIIR{};
     size_t mCount{};
     ALuint mPhaseStep[2]{};
     ALuint mPhase[2]{};
@@ -73,6 +86,16 @@ struct FshifterState final : public EffectState {
     complex_d mAnalytic[HIL_SIZE]{};
     complex_d mOutdata[BUFFERSIZE]{};
 
+    /* IIR Hilbert filter history, for each network's sections. The "x"
+     * history holds the last two inputs, and the "y" history the last two
+     * outputs. The delay is the one-sample delay on the first network.
+     */
+    float mApX[2][4][2]{};
+    float mApY[2][4][2]{};
+    float mApDelay{};
+    alignas(16) float mReal[BUFFERSIZE]{};
+    alignas(16) float mImag[BUFFERSIZE]{};
+
     alignas(16) float mBufferOut[BUFFERSIZE]{};
 
     /* Effect gains for each output channel */
@@ -82,6 +105,9 @@ struct FshifterState final : public EffectState {
     } mGains[2];
 
 
+    void processFFT(const size_t samplesToDo, const float *RESTRICT src);
+    void processIIR(const size_t samplesToDo, const float *RESTRICT src);
+
     void deviceUpdate(const ALCdevice *device) override;
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut) override;
@@ -92,6 +118,7 @@ struct FshifterState final : public EffectState {
 void FshifterState::deviceUpdate(const ALCdevice*)
 {
     /* (Re-)initializing parameters and clear the buffers. */
+    mUseIIR = FshifterIIRHilbert;
     mCount = FIFO_LATENCY;
 
     std::fill(std::begin(mPhaseStep),   std::end(mPhaseStep),   0u);
@@ -101,6 +128,9 @@ void FshifterState::deviceUpdate(const ALCdevice*)
     std::fill(std::begin(mOutFIFO),     std::end(mOutFIFO),     complex_d{});
     std::fill(std::begin(mOutputAccum), std::end(mOutputAccum), complex_d{});
     std::fill(std::begin(mAnalytic),    std::end(mAnalytic),    complex_d{});
+    std::fill_n(&mApX[0][0][0], 2*4*2, 0.0f);
+    std::fill_n(&mApY[0][0][0], 2*4*2, 0.0f);
+    mApDelay = 0.0f;
 
     for(auto &gain : mGains)
     {
@@ -156,7 +186,7 @@ void FshifterState::update(const ALCcontext *context, const ALeffectslot *slot,
     ComputePanGains(target.Main, rcoeffs.data(), slot->Params.Gain, mGains[1].Target);
 }
 
-void FshifterState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
+void FshifterState::processFFT(const size_t samplesToDo, const float *RESTRICT src)
 {
     for(size_t base{0u};base < samplesToDo;)
     {
@@ -165,7 +195,7 @@ void FshifterState::process(const size_t samplesToDo, const al::span<const Float
         /* Fill FIFO buffer with samples data */
         size_t count{mCount};
         do {
-            mInFIFO[count] = samplesIn[0][base];
+            mInFIFO[count] = src[base];
             mOutdata[base] = mOutFIFO[count-FIFO_LATENCY];
             ++base; ++count;
         } while(--todo);
@@ -194,22 +224,81 @@ void FshifterState::process(const size_t samplesToDo, const al::span<const Float
         std::copy(std::begin(mInFIFO)+HIL_STEP, std::end(mInFIFO), std::begin(mInFIFO));
     }
 
-    /* Process frequency shifter using the analytic signal obtained. */
+    for(size_t k{0};k < samplesToDo;++k)
+    {
+        mReal[k] = static_cast<float>(mOutdata[k].real());
+        mImag[k] = static_cast<float>(mOutdata[k].imag());
+    }
+}
+
+void FshifterState::processIIR(const size_t samplesToDo, const float *RESTRICT src)
+{
+    /* Each 2nd order all-pass section is y[n] = a*(x[n] + y[n-2]) - x[n-2].
+     * The two networks are independent, so run them side by side.
+     */
+    float apx[2][4][2], apy[2][4][2];
+    std::copy_n(&mApX[0][0][0], 2*4*2, &apx[0][0][0]);
+    std::copy_n(&mApY[0][0][0], 2*4*2, &apy[0][0][0]);
+    float delay{mApDelay};
+    for(size_t k{0};k < samplesToDo;++k)
+    {
+        float smp[2]{src[k], src[k]};
+        for(size_t j{0};j < 4;++j)
+        {
+            for(size_t n{0};n < 2;++n)
+            {
+                const float out{HilbertCoeffs[n][j]*(smp[n] + apy[n][j][1]) - apx[n][j][1]};
+                apx[n][j][1] = apx[n][j][0]; apx[n][j][0] = smp[n];
+                apy[n][j][1] = apy[n][j][0]; apy[n][j][0] = out;
+                smp[n] = out;
+            }
+        }
+        /* The second network's output lags the (delayed) first by 90
+         * degrees, making it the Hilbert transform of the first.
+         */
+        mReal[k] = delay * IirHilbertGain;
+        mImag[k] = smp[1] * IirHilbertGain;
+        delay = smp[0];
+    }
+    std::copy_n(&apx[0][0][0], 2*4*2, &mApX[0][0][0]);
+    std::copy_n(&apy[0][0][0], 2*4*2, &mApY[0][0][0]);
+    mApDelay = delay;
+}
+
+void FshifterState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
+{
+    if(mUseIIR)
+        processIIR(samplesToDo, samplesIn[0].data());
+    else
+        processFFT(samplesToDo, samplesIn[0].data());
+
+    /* Process frequency shifter using the analytic signal obtained. The
+     * carrier is generated with a rotating phasor, which is reset from the
+     * phase index each update to avoid accumulating error.
+     */
+    const float *RESTRICT re{mReal};
+    const float *RESTRICT im{mImag};
     float *RESTRICT BufferOut{mBufferOut};
     for(ALsizei c{0};c < 2;++c)
     {
+        constexpr double scale{(1.0 / FRACTIONONE) * al::MathDefs<double>::Tau()};
         const ALuint phase_step{mPhaseStep[c]};
-        ALuint phase_idx{mPhase[c]};
+        const double phase{mPhase[c] * scale};
+        const double step{phase_step * scale};
+
+        float osc_r{static_cast<float>(std::cos(phase))};
+        float osc_i{static_cast<float>(std::sin(phase) * mSign[c])};
+        const float rot_r{static_cast<float>(std::cos(step))};
+        const float rot_i{static_cast<float>(std::sin(step) * mSign[c])};
         for(size_t k{0};k < samplesToDo;++k)
         {
-            const double phase{phase_idx * ((1.0 / FRACTIONONE) * al::MathDefs<double>::Tau())};
-            BufferOut[k] = static_cast<float>(mOutdata[k].real()*std::cos(phase) +
-                mOutdata[k].imag()*std::sin(phase)*mSign[c]);
+            BufferOut[k] = re[k]*osc_r + im[k]*osc_i;
 
-            phase_idx += phase_step;
-            phase_idx &= FRACTIONMASK;
+            const float next_r{osc_r*rot_r - osc_i*rot_i};
+            osc_i = osc_r*rot_i + osc_i*rot_r;
+            osc_r = next_r;
         }
-        mPhase[c] = phase_idx;
+        mPhase[c] = static_cast<ALuint>((mPhase[c] + phase_step*samplesToDo) & FRACTIONMASK);
 
         /* Now, mix the processed sound data to the output. */
         MixSamples({BufferOut, samplesToDo}, samplesOut, mGains[c].Current, mGains[c].Target,
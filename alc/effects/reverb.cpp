@@ -44,6 +44,12 @@
  */
 float ReverbBoost = 1.0f;
 
+/* This is a user config option for the minimum rate to process the late reverb
+ * at. When the device rate is at least double this, the late reverb is
+ * processed at half or a quarter of the device rate. 0 disables it.
+ */
+ALuint ReverbLateRate = 0;
+
 namespace {
 
 #define MOD_FRACBITS 24
@@ -227,8 +233,100 @@ constexpr std::array<float,NUM_LINES> LATE_LINE_LENGTHS{{
 }};
 
 
+/* The maximum number of half-band stages for the late reverb, i.e. processing
+ * it at a quarter of the device rate.
+ */
+constexpr size_t MAX_LATE_STAGES{2};
+
+/* Coefficients for a polyphase IIR half-band filter, consisting of two paths
+ * of first-order all-pass sections (in z^2). These were designed with the
+ * method from Laurent de Soras' HIIR library, with a transition band of 0.05
+ * (normalized to the higher rate), giving about 80dB of stop-band attenuation.
+ */
+constexpr size_t HALFBAND_COEFFS{3};
+constexpr float HalfbandCoeffs[2][HALFBAND_COEFFS]{
+    { 0.060297391f, 0.412590720f, 0.772715654f },
+    { 0.215971445f, 0.604358626f, 0.923886139f }
+};
+
+
 using ReverbUpdateLine = std::array<float,MAX_UPDATE_SAMPLES>;
 
+/* A polyphase IIR half-band filter for the four lines, used to halve or
+ * double the late reverb rate.
+ */
+struct VecHalfband {
+    using LineSamples = std::array<float,NUM_LINES>;
+
+    /* The all-pass state for each path. */
+    LineSamples State[2][HALFBAND_COEFFS]{};
+
+    /* The held samples for decimation, since it takes them in pairs. */
+    LineSamples Even{}, Odd{};
+    bool HasEven{false};
+
+    LineSamples processPath(const size_t path, LineSamples in) noexcept
+    {
+        for(size_t i{0u};i < HALFBAND_COEFFS;i++)
+        {
+            const float coeff{HalfbandCoeffs[path][i]};
+            LineSamples &state = State[path][i];
+            for(size_t j{0u};j < NUM_LINES;j++)
+            {
+                const float out{in[j]*coeff + state[j]};
+                state[j] = in[j] - out*coeff;
+                in[j] = out;
+            }
+        }
+        return in;
+    }
+
+    /* Halves the rate of the given line samples in place, returning the new
+     * sample count.
+     */
+    size_t decimate(const al::span<ReverbUpdateLine,NUM_LINES> samples, const size_t count) noexcept
+    {
+        size_t outcount{0u};
+        for(size_t i{0u};i < count;i++)
+        {
+            LineSamples in;
+            for(size_t j{0u};j < NUM_LINES;j++)
+                in[j] = samples[j][i];
+            if(!HasEven)
+            {
+                Even = in;
+                HasEven = true;
+                continue;
+            }
+
+            const LineSamples out0{processPath(0, Even)};
+            const LineSamples out1{processPath(1, Odd)};
+            for(size_t j{0u};j < NUM_LINES;j++)
+                samples[j][outcount] = 0.5f*(out0[j] + out1[j]);
+            ++outcount;
+
+            Odd = in;
+            HasEven = false;
+        }
+        return outcount;
+    }
+
+    /* Doubles the rate of the given line sample, writing two to dst. */
+    void interpolate(const LineSamples &in, LineSamples *dst) noexcept
+    {
+        dst[0] = processPath(0, in);
+        dst[1] = processPath(1, in);
+    }
+
+    void clear() noexcept
+    {
+        for(auto &path : State)
+            std::fill(std::begin(path), std::end(path), LineSamples{});
+        Even = Odd = LineSamples{};
+        HasEven = false;
+    }
+};
+
 struct DelayLineI {
     /* The delay lines use interleaved samples, with the lengths being powers
      * of 2 to allow the use of bit-masking instead of a modulus for wrapping.
@@ -424,6 +522,20 @@ struct ReverbState final : public EffectState {
     /* The current write offset for all delay lines. */
     size_t mOffset{};
 
+    /* The number of half-band stages to reduce the late reverb rate by, and
+     * the current write offset for the late reverb lines at that rate.
+     */
+    size_t mLateStages{0u};
+    size_t mLateOffset{};
+
+    /* The half-band filters to reduce and restore the late reverb rate, and
+     * the restored samples left over from the last update.
+     */
+    VecHalfband mLateDown[MAX_LATE_STAGES];
+    VecHalfband mLateUp[MAX_LATE_STAGES];
+    std::array<float,NUM_LINES> mLateFifo[(1<<MAX_LATE_STAGES) - 1]{};
+    size_t mLateFifoCount{0u};
+
     /* Temporary storage used when processing. */
     union {
         alignas(16) FloatBufferLine mTempLine{};
@@ -524,6 +636,8 @@ struct ReverbState final : public EffectState {
     void earlyFaded(const size_t offset, const size_t todo, const float fade,
         const float fadeStep);
 
+    size_t lateDecimate(const size_t todo);
+    void lateInterpolate(const size_t lateTodo, const size_t todo);
     void lateUnfaded(const size_t offset, const size_t todo);
     void lateFaded(const size_t offset, const size_t todo, const float fade,
         const float fadeStep);
@@ -575,9 +689,12 @@ void ReverbState::allocLines(const float frequency)
     length = EARLY_LINE_LENGTHS.back() * multiplier;
     totalSamples += mEarly.Delay.calcLineLength(length, totalSamples, frequency, 0);
 
+    /* The late lines run at the late reverb's rate. */
+    const float late_frequency{frequency / static_cast<float>(1u<<mLateStages)};
+
     /* The late vector all-pass line. */
     length = LATE_ALLPASS_LENGTHS.back() * multiplier;
-    totalSamples += mLate.VecAp.Delay.calcLineLength(length, totalSamples, frequency, 0);
+    totalSamples += mLate.VecAp.Delay.calcLineLength(length, totalSamples, late_frequency, 0);
 
     /* The modulator's line length is calculated from the maximum modulation
      * time and depth coefficient, and halfed for the low-to-high frequency
@@ -590,7 +707,7 @@ void ReverbState::allocLines(const float frequency)
      * added to keep it stable when there is no modulation.
      */
     length = LATE_LINE_LENGTHS.back()*multiplier + max_mod_delay;
-    totalSamples += mLate.Delay.calcLineLength(length, totalSamples, frequency, 1);
+    totalSamples += mLate.Delay.calcLineLength(length, totalSamples, late_frequency, 1);
 
     if(totalSamples != mSampleBuffer.size())
         decltype(mSampleBuffer)(totalSamples).swap(mSampleBuffer);
@@ -610,6 +727,15 @@ void ReverbState::deviceUpdate(const ALCdevice *device)
 {
     const auto frequency = static_cast<float>(device->Frequency);
 
+    /* Reduce the late reverb rate as much as allowed, to save processing. */
+    mLateStages = 0;
+    if(ReverbLateRate > 0)
+    {
+        while(mLateStages < MAX_LATE_STAGES
+            && frequency/static_cast<float>(2u<<mLateStages) >= static_cast<float>(ReverbLateRate))
+            ++mLateStages;
+    }
+
     /* Allocate the delay lines. */
     allocLines(frequency);
 
@@ -661,6 +787,15 @@ void ReverbState::deviceUpdate(const ALCdevice *device)
     std::fill(std::begin(mMaxUpdate), std::end(mMaxUpdate), MAX_UPDATE_SAMPLES);
     mOffset = 0;
 
+    /* The restored late reverb starts with enough silence to cover the
+     * samples held for decimation.
+     */
+    mLateOffset = 0;
+    std::for_each(std::begin(mLateDown), std::end(mLateDown), std::mem_fn(&VecHalfband::clear));
+    std::for_each(std::begin(mLateUp), std::end(mLateUp), std::mem_fn(&VecHalfband::clear));
+    std::fill(std::begin(mLateFifo), std::end(mLateFifo), std::array<float,NUM_LINES>{});
+    mLateFifoCount = (1u<<mLateStages) - 1;
+
     if(device->mAmbiOrder > 1)
     {
         mMixOut = &ReverbState::MixOutAmbiUp;
@@ -1027,13 +1162,18 @@ void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
     const float hfDecayTime{clampf(props->Reverb.DecayTime * hfRatio,
         AL_EAXREVERB_MIN_DECAY_TIME, AL_EAXREVERB_MAX_DECAY_TIME)};
 
+    /* The late reverb may be processed at a reduced rate. */
+    const float late_frequency{frequency / static_cast<float>(1u<<mLateStages)};
+
     /* Update the modulator rate and depth. */
     mLate.Mod.updateModulator(props->Reverb.ModulationTime, props->Reverb.ModulationDepth,
-        frequency);
+        late_frequency);
 
     /* Update the late lines. */
     mLate.updateLines(density_mult, props->Reverb.Diffusion, lfDecayTime,
-        props->Reverb.DecayTime, hfDecayTime, lf0norm, hf0norm, frequency);
+        props->Reverb.DecayTime, hfDecayTime,
+        minf(props->Reverb.LFReference/late_frequency, 0.49f),
+        minf(props->Reverb.HFReference/late_frequency, 0.49f), late_frequency);
 
     /* Update early and late 3D panning. */
     const float gain{props->Reverb.Gain * Slot->Params.Gain * ReverbBoost};
@@ -1041,7 +1181,8 @@ void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
         props->Reverb.ReflectionsGain*gain, props->Reverb.LateReverbGain*gain, target);
 
     /* Calculate the max update size from the smallest relevant delay. */
-    mMaxUpdate[1] = minz(MAX_UPDATE_SAMPLES, minz(mEarly.Offset[0][1], mLate.Offset[0][1]));
+    mMaxUpdate[1] = minz(MAX_UPDATE_SAMPLES, minz(mEarly.Offset[0][1],
+        mLate.Offset[0][1] << mLateStages));
 
     /* Determine if delay-line cross-fading is required. Density is essentially
      * a master control for the feedback delays, so changes the offsets of many
@@ -1437,6 +1578,60 @@ void Modulation::calcFadedDelays(size_t todo, float fadeCount, float fadeStep)
 }
 
 
+/* Reduces the rate of the late reverb input in mTempSamples, returning the
+ * number of samples at the late reverb rate.
+ */
+size_t ReverbState::lateDecimate(const size_t todo)
+{
+    size_t late_todo{todo};
+    for(size_t stage{0u};stage < mLateStages;stage++)
+        late_todo = mLateDown[stage].decimate(mTempSamples, late_todo);
+    return late_todo;
+}
+
+/* Restores the rate of the late reverb output in mTempSamples, writing the
+ * todo samples for mixing. The samples going past todo are held until the
+ * next update.
+ */
+void ReverbState::lateInterpolate(const size_t lateTodo, const size_t todo)
+{
+    if(mLateStages == 0)
+    {
+        for(size_t j{0u};j < NUM_LINES;j++)
+            std::copy_n(mTempSamples[j].begin(), todo, mLateSamples[j].begin());
+        return;
+    }
+
+    using LineSamples = std::array<float,NUM_LINES>;
+    alignas(16) LineSamples restored[MAX_UPDATE_SAMPLES + (1<<MAX_LATE_STAGES)];
+
+    const size_t total{mLateFifoCount + (lateTodo<<mLateStages)};
+    LineSamples *dst{std::copy_n(std::begin(mLateFifo), mLateFifoCount, std::begin(restored))};
+    for(size_t i{0u};i < lateTodo;i++)
+    {
+        LineSamples in;
+        for(size_t j{0u};j < NUM_LINES;j++)
+            in[j] = mTempSamples[j][i];
+
+        mLateUp[0].interpolate(in, dst);
+        if(mLateStages > 1)
+        {
+            const LineSamples smp0{dst[0]}, smp1{dst[1]};
+            mLateUp[1].interpolate(smp0, dst);
+            mLateUp[1].interpolate(smp1, dst+2);
+        }
+        dst += size_t{1}<<mLateStages;
+    }
+
+    for(size_t i{0u};i < todo;i++)
+    {
+        for(size_t j{0u};j < NUM_LINES;j++)
+            mLateSamples[j][i] = restored[i][j];
+    }
+    std::copy(std::begin(restored)+todo, std::begin(restored)+total, std::begin(mLateFifo));
+    mLateFifoCount = total - todo;
+}
+
 /* This generates the reverb tail using a modified feed-back delay network
  * (FDN).
  *
@@ -1448,6 +1643,10 @@ void Modulation::calcFadedDelays(size_t todo, float fadeCount, float fadeStep)
  * Finally, the lines are reversed (so they feed their opposite directions)
  * and scattered with the FDN matrix before re-feeding the delay lines.
  *
+ * The late delay lines may run at a reduced rate, with the input from the
+ * main delay line being decimated beforehand, and the output interpolated
+ * back to the device rate afterward.
+ *
  * Two variations are made, one for for transitional (cross-faded) delay line
  * processing and one for non-transitional processing.
  */
@@ -1460,24 +1659,42 @@ void ReverbState::lateUnfaded(const size_t offset, const size_t todo)
 
     ASSUME(todo > 0);
 
-    /* First, calculate the modulated delays for the late feedback. */
-    mLate.Mod.calcDelays(todo);
-
-    /* Next, load decorrelated samples from the main and feedback delay lines.
-     * Filter the signal to apply its frequency-dependent decay.
+    /* First, load decorrelated samples from the main delay line, and reduce
+     * them to the late reverb rate.
      */
     for(size_t j{0u};j < NUM_LINES;j++)
     {
         size_t late_delay_tap{offset - mLateDelayTap[j][0]};
-        size_t late_feedb_tap{offset - mLate.Offset[j][0]};
-        const float midGain{mLate.T60[j].MidGain[0]};
-        const float densityGain{mLate.DensityGain[0] * midGain};
+        const float densityGain{mLate.DensityGain[0] * mLate.T60[j].MidGain[0]};
 
         for(size_t i{0u};i < todo;)
         {
             late_delay_tap &= main_delay.Mask;
             size_t td{minz(todo - i, main_delay.Mask+1 - late_delay_tap)};
             do {
+                mTempSamples[j][i++] = main_delay.Line[late_delay_tap++][j]*densityGain;
+            } while(--td);
+        }
+    }
+    const size_t late_todo{lateDecimate(todo)};
+
+    if(late_todo > 0)
+    {
+        const size_t late_offset{mLateOffset};
+
+        /* Calculate the modulated delays for the late feedback. */
+        mLate.Mod.calcDelays(late_todo);
+
+        /* Mix in the feedback delay lines, and filter the signal to apply its
+         * frequency-dependent decay.
+         */
+        for(size_t j{0u};j < NUM_LINES;j++)
+        {
+            size_t late_feedb_tap{late_offset - mLate.Offset[j][0]};
+            const float midGain{mLate.T60[j].MidGain[0]};
+
+            for(size_t i{0u};i < late_todo;i++)
+            {
                 /* Calculate the read offset and fraction between it and the
                  * next sample.
                  */
@@ -1496,23 +1713,26 @@ void ReverbState::lateUnfaded(const size_t offset, const size_t todo)
                  * samples that were acquired above, and combined with the main
                  * delay tap.
                  */
-                mTempSamples[j][i] = lerp(out0, out1, frac)*midGain +
-                    main_delay.Line[late_delay_tap++][j]*densityGain;
-                ++i;
-            } while(--td);
+                mTempSamples[j][i] += lerp(out0, out1, frac)*midGain;
+            }
+            mLate.T60[j].process({mTempSamples[j].data(), late_todo});
         }
-        mLate.T60[j].process({mTempSamples[j].data(), todo});
+
+        /* Apply a vector all-pass to improve micro-surface diffusion. */
+        mLate.VecAp.processUnfaded(mTempSamples, late_offset, mixX, mixY, late_todo);
     }
 
-    /* Apply a vector all-pass to improve micro-surface diffusion, and write
-     * out the results for mixing.
-     */
-    mLate.VecAp.processUnfaded(mTempSamples, offset, mixX, mixY, todo);
-    for(size_t j{0u};j < NUM_LINES;j++)
-        std::copy_n(mTempSamples[j].begin(), todo, mLateSamples[j].begin());
+    /* Write out the results for mixing. */
+    lateInterpolate(late_todo, todo);
 
-    /* Finally, scatter and bounce the results to refeed the feedback buffer. */
-    VectorScatterRevDelayIn(late_delay, offset, mixX, mixY, mTempSamples, todo);
+    if(late_todo > 0)
+    {
+        /* Finally, scatter and bounce the results to refeed the feedback
+         * buffer.
+         */
+        VectorScatterRevDelayIn(late_delay, mLateOffset, mixX, mixY, mTempSamples, late_todo);
+        mLateOffset += late_todo;
+    }
 }
 void ReverbState::lateFaded(const size_t offset, const size_t todo, const float fade,
     const float fadeStep)
@@ -1524,22 +1744,14 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
 
     ASSUME(todo > 0);
 
-    mLate.Mod.calcFadedDelays(todo, fade, fadeStep);
-
     for(size_t j{0u};j < NUM_LINES;j++)
     {
-        const float oldMidGain{mLate.T60[j].MidGain[0]};
-        const float midGain{mLate.T60[j].MidGain[1]};
-        const float oldMidStep{-oldMidGain * fadeStep};
-        const float midStep{midGain * fadeStep};
-        const float oldDensityGain{mLate.DensityGain[0] * oldMidGain};
-        const float densityGain{mLate.DensityGain[1] * midGain};
+        const float oldDensityGain{mLate.DensityGain[0] * mLate.T60[j].MidGain[0]};
+        const float densityGain{mLate.DensityGain[1] * mLate.T60[j].MidGain[1]};
         const float oldDensityStep{-oldDensityGain * fadeStep};
         const float densityStep{densityGain * fadeStep};
         size_t late_delay_tap0{offset - mLateDelayTap[j][0]};
         size_t late_delay_tap1{offset - mLateDelayTap[j][1]};
-        size_t late_feedb_tap0{offset - mLate.Offset[j][0]};
-        size_t late_feedb_tap1{offset - mLate.Offset[j][1]};
         float fadeCount{fade};
 
         for(size_t i{0u};i < todo;)
@@ -1549,6 +1761,41 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
             size_t td{minz(todo - i, main_delay.Mask+1 - maxz(late_delay_tap0, late_delay_tap1))};
             do {
                 fadeCount += 1.0f;
+                const float fade0{oldDensityGain + oldDensityStep*fadeCount};
+                const float fade1{densityStep*fadeCount};
+                mTempSamples[j][i++] =
+                    main_delay.Line[late_delay_tap0++][j]*fade0 +
+                    main_delay.Line[late_delay_tap1++][j]*fade1;
+            } while(--td);
+        }
+    }
+    const size_t late_todo{lateDecimate(todo)};
+
+    if(late_todo > 0)
+    {
+        const size_t late_offset{mLateOffset};
+
+        /* The fade progresses with the device rate, so scale it for the late
+         * reverb rate.
+         */
+        const float late_fade{fade / static_cast<float>(1u<<mLateStages)};
+        const float late_fade_step{fadeStep * static_cast<float>(1u<<mLateStages)};
+
+        mLate.Mod.calcFadedDelays(late_todo, late_fade, late_fade_step);
+
+        for(size_t j{0u};j < NUM_LINES;j++)
+        {
+            const float oldMidGain{mLate.T60[j].MidGain[0]};
+            const float midGain{mLate.T60[j].MidGain[1]};
+            const float oldMidStep{-oldMidGain * late_fade_step};
+            const float midStep{midGain * late_fade_step};
+            size_t late_feedb_tap0{late_offset - mLate.Offset[j][0]};
+            size_t late_feedb_tap1{late_offset - mLate.Offset[j][1]};
+            float fadeCount{late_fade};
+
+            for(size_t i{0u};i < late_todo;i++)
+            {
+                fadeCount += 1.0f;
 
                 const float fdelay{mLate.Mod.ModDelays[i]};
                 const size_t delay{float2uint(fdelay)};
@@ -1561,25 +1808,25 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
                 const float out11{late_delay.Line[(late_feedb_tap1-delay-1) & late_delay.Mask][j]};
                 ++late_feedb_tap1;
 
-                const float fade0{oldDensityGain + oldDensityStep*fadeCount};
-                const float fade1{densityStep*fadeCount};
                 const float gfade0{oldMidGain + oldMidStep*fadeCount};
                 const float gfade1{midStep*fadeCount};
-                mTempSamples[j][i] = lerp(out00, out01, frac)*gfade0 +
-                    lerp(out10, out11, frac)*gfade1 +
-                    main_delay.Line[late_delay_tap0++][j]*fade0 +
-                    main_delay.Line[late_delay_tap1++][j]*fade1;
-                ++i;
-            } while(--td);
+                mTempSamples[j][i] += lerp(out00, out01, frac)*gfade0 +
+                    lerp(out10, out11, frac)*gfade1;
+            }
+            mLate.T60[j].process({mTempSamples[j].data(), late_todo});
         }
-        mLate.T60[j].process({mTempSamples[j].data(), todo});
+
+        mLate.VecAp.processFaded(mTempSamples, late_offset, mixX, mixY, late_fade,
+            late_fade_step, late_todo);
     }
 
-    mLate.VecAp.processFaded(mTempSamples, offset, mixX, mixY, fade, fadeStep, todo);
-    for(size_t j{0u};j < NUM_LINES;j++)
-        std::copy_n(mTempSamples[j].begin(), todo, mLateSamples[j].begin());
+    lateInterpolate(late_todo, todo);
 
-    VectorScatterRevDelayIn(late_delay, offset, mixX, mixY, mTempSamples, todo);
+    if(late_todo > 0)
+    {
+        VectorScatterRevDelayIn(late_delay, mLateOffset, mixX, mixY, mTempSamples, late_todo);
+        mLateOffset += late_todo;
+    }
 }
 
 void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
@@ -23,7 +23,6 @@
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
-#include <functional>
 
 #include "al/auxeffectslot.h"
 #include "alcmain.h"
@@ -35,6 +34,7 @@ namespace {
 #define MAX_UPDATE_SAMPLES 256
 #define NUM_FORMANTS       4
 #define NUM_FILTERS        2
+#define NUM_BANK_LANES     (NUM_FORMANTS*NUM_FILTERS)
 #define Q_FACTOR           5.0f
 
 #define VOWEL_A_INDEX      0
@@ -73,45 +73,88 @@ struct FormantFilter
 {
     float mCoeff{0.0f};
     float mGain{1.0f};
-    float mS1{0.0f};
-    float mS2{0.0f};
 
     FormantFilter() = default;
     FormantFilter(float f0norm, float gain)
       : mCoeff{std::tan(al::MathDefs<float>::Pi() * f0norm)}, mGain{gain}
     { }
+};
+
+/* A bank of the formant filters for both vowels, with each filter in its own
+ * lane. All the formants are independent, so they're processed together for
+ * each sample, with the vowels being blended by the LFO in the same pass.
+ */
+struct FormantBank
+{
+    alignas(16) float mCoeff[NUM_BANK_LANES]{};
+    alignas(16) float mDamp[NUM_BANK_LANES]{};
+    alignas(16) float mScale[NUM_BANK_LANES]{};
+    alignas(16) float mGain[NUM_BANK_LANES]{};
+    alignas(16) float mS1[NUM_BANK_LANES]{};
+    alignas(16) float mS2[NUM_BANK_LANES]{};
+
+    void setFilters(const al::span<const FormantFilter,NUM_FORMANTS> vowelA,
+        const al::span<const FormantFilter,NUM_FORMANTS> vowelB)
+    {
+        auto set_lane = [this](const size_t lane, const FormantFilter &filter) -> void
+        {
+            const float g{filter.mCoeff};
+            mCoeff[lane] = g;
+            mDamp[lane] = 1.0f/Q_FACTOR + g;
+            mScale[lane] = 1.0f / (1.0f + (g/Q_FACTOR) + (g*g));
+            mGain[lane] = filter.mGain;
+        };
+        for(size_t i{0u};i < NUM_FORMANTS;i++)
+        {
+            set_lane(VOWEL_A_INDEX*NUM_FORMANTS + i, vowelA[i]);
+            set_lane(VOWEL_B_INDEX*NUM_FORMANTS + i, vowelB[i]);
+        }
+    }
 
-    inline void process(const float *samplesIn, float *samplesOut, const size_t numInput)
+    void process(const float *RESTRICT samplesIn, const float *RESTRICT lfo,
+        float *RESTRICT samplesOut, const size_t numInput)
     {
-        /* A state variable filter from a topology-preserving transform.
-         * Based on a talk given by Ivan Cohen: https://www.youtube.com/watch?v=esjHXGPyrhg
+        /* A state variable filter from a topology-preserving transform, for
+         * each lane. Based on a talk given by Ivan Cohen:
+         * https://www.youtube.com/watch?v=esjHXGPyrhg
          */
-        const float g{mCoeff};
-        const float gain{mGain};
-        const float h{1.0f / (1.0f + (g/Q_FACTOR) + (g*g))};
-        float s1{mS1};
-        float s2{mS2};
+        float s1[NUM_BANK_LANES], s2[NUM_BANK_LANES];
+        std::copy(std::begin(mS1), std::end(mS1), std::begin(s1));
+        std::copy(std::begin(mS2), std::end(mS2), std::begin(s2));
 
         for(size_t i{0u};i < numInput;i++)
         {
-            const float H{(samplesIn[i] - (1.0f/Q_FACTOR + g)*s1 - s2)*h};
-            const float B{g*H + s1};
-            const float L{g*B + s2};
-
-            s1 = g*H + B;
-            s2 = g*B + L;
-
-            // Apply peak and accumulate samples.
-            samplesOut[i] += B * gain;
+            const float input{samplesIn[i]};
+            float peak[NUM_BANK_LANES];
+            for(size_t j{0u};j < NUM_BANK_LANES;j++)
+            {
+                const float g{mCoeff[j]};
+                const float H{(input - mDamp[j]*s1[j] - s2[j])*mScale[j]};
+                const float B{g*H + s1[j]};
+                const float L{g*B + s2[j]};
+
+                s1[j] = g*H + B;
+                s2[j] = g*B + L;
+
+                /* Apply peak. */
+                peak[j] = B * mGain[j];
+            }
+
+            const float *vowelA{&peak[VOWEL_A_INDEX*NUM_FORMANTS]};
+            const float *vowelB{&peak[VOWEL_B_INDEX*NUM_FORMANTS]};
+            const float outA{vowelA[0] + vowelA[1] + vowelA[2] + vowelA[3]};
+            const float outB{vowelB[0] + vowelB[1] + vowelB[2] + vowelB[3]};
+            samplesOut[i] = lerp(outA, outB, lfo[i]);
         }
-        mS1 = s1;
-        mS2 = s2;
+
+        std::copy(std::begin(s1), std::end(s1), std::begin(mS1));
+        std::copy(std::begin(s2), std::end(s2), std::begin(mS2));
     }
 
-    inline void clear()
+    void clear()
     {
-        mS1 = 0.0f;
-        mS2 = 0.0f;
+        std::fill(std::begin(mS1), std::end(mS1), 0.0f);
+        std::fill(std::begin(mS2), std::end(mS2), 0.0f);
     }
 };
 
@@ -119,7 +162,7 @@ struct FormantFilter
 struct VmorpherState final : public EffectState {
     struct {
         /* Effect parameters */
-        FormantFilter Formants[NUM_FILTERS][NUM_FORMANTS];
+        FormantBank Formants;
 
         /* Effect gains for each channel */
         float CurrentGains[MAX_OUTPUT_CHANNELS]{};
@@ -132,8 +175,7 @@ struct VmorpherState final : public EffectState {
     ALuint mStep{1};
 
     /* Effects buffers */
-    alignas(16) float mSampleBufferA[MAX_UPDATE_SAMPLES]{};
-    alignas(16) float mSampleBufferB[MAX_UPDATE_SAMPLES]{};
+    alignas(16) float mSampleBuffer[MAX_UPDATE_SAMPLES]{};
     alignas(16) float mLfo[MAX_UPDATE_SAMPLES]{};
 
     void deviceUpdate(const ALCdevice *device) override;
@@ -198,10 +240,7 @@ void VmorpherState::deviceUpdate(const ALCdevice* /*device*/)
 {
     for(auto &e : mChans)
     {
-        std::for_each(std::begin(e.Formants[VOWEL_A_INDEX]), std::end(e.Formants[VOWEL_A_INDEX]),
-            std::mem_fn(&FormantFilter::clear));
-        std::for_each(std::begin(e.Formants[VOWEL_B_INDEX]), std::end(e.Formants[VOWEL_B_INDEX]),
-            std::mem_fn(&FormantFilter::clear));
+        e.Formants.clear();
         std::fill(std::begin(e.CurrentGains), std::end(e.CurrentGains), 0.0f);
     }
 }
@@ -232,10 +271,7 @@ void VmorpherState::update(const ALCcontext *context, const ALeffectslot *slot,
 
     /* Copy the filter coefficients to the input channels. */
     for(size_t i{0u};i < slot->Wet.Buffer.size();++i)
-    {
-        std::copy(vowelA.begin(), vowelA.end(), std::begin(mChans[i].Formants[VOWEL_A_INDEX]));
-        std::copy(vowelB.begin(), vowelB.end(), std::begin(mChans[i].Formants[VOWEL_B_INDEX]));
-    }
+        mChans[i].Formants.setFilters(vowelA, vowelB);
 
     mOutTarget = target.Main->Buffer;
     auto set_gains = [slot,target](auto &chan, al::span<const float,MAX_AMBI_CHANNELS> coeffs)
@@ -259,30 +295,12 @@ void VmorpherState::process(const size_t samplesToDo, const al::span<const Float
         auto chandata = std::addressof(mChans[0]);
         for(const auto &input : samplesIn)
         {
-            auto& vowelA = chandata->Formants[VOWEL_A_INDEX];
-            auto& vowelB = chandata->Formants[VOWEL_B_INDEX];
-
-            /* Process first vowel. */
-            std::fill_n(std::begin(mSampleBufferA), td, 0.0f);
-            vowelA[0].process(&input[base], mSampleBufferA, td);
-            vowelA[1].process(&input[base], mSampleBufferA, td);
-            vowelA[2].process(&input[base], mSampleBufferA, td);
-            vowelA[3].process(&input[base], mSampleBufferA, td);
-
-            /* Process second vowel. */
-            std::fill_n(std::begin(mSampleBufferB), td, 0.0f);
-            vowelB[0].process(&input[base], mSampleBufferB, td);
-            vowelB[1].process(&input[base], mSampleBufferB, td);
-            vowelB[2].process(&input[base], mSampleBufferB, td);
-            vowelB[3].process(&input[base], mSampleBufferB, td);
-
-            alignas(16) float blended[MAX_UPDATE_SAMPLES];
-            for(size_t i{0u};i < td;i++)
-                blended[i] = lerp(mSampleBufferA[i], mSampleBufferB[i], mLfo[i]);
+            /* Process both vowels and blend them. */
+            chandata->Formants.process(&input[base], mLfo, mSampleBuffer, td);
 
             /* Now, mix the processed sound data to the output. */
-            MixSamples({blended, td}, samplesOut, chandata->CurrentGains, chandata->TargetGains,
-                samplesToDo-base, base);
+            MixSamples({mSampleBuffer, td}, samplesOut, chandata->CurrentGains,
+                chandata->TargetGains, samplesToDo-base, base);
             ++chandata;
         }
 
@@ -0,0 +1,94 @@
+#ifndef FASTLOGEXP_H
+#define FASTLOGEXP_H
+
+#ifdef HAVE_SSE_INTRINSICS
+#include <emmintrin.h>
+#endif
+
+#include "alnumeric.h"
+
+
+/* Fast approximations of the natural logarithm and exponential, used on the
+ * compressor's side-chain. The logarithm splits off the exponent and uses a
+ * series on the mantissa centered around 1. Its error is below 2e-7 for
+ * results within +/-1, and below 2e-7 relative to the result beyond that.
+ * The exponential splits off a power of 2 and uses a polynomial on the
+ * remaining fraction (within +/-ln(2)/2), with a relative error below 3e-7.
+ * Neither handles infinities or NaNs. The almixercheck utility checks these
+ * bounds.
+ */
+constexpr float Ln2Hi{0.693145751953125f};
+constexpr float Ln2Lo{1.428606765330187e-06f};
+constexpr float Log2e{1.44269504088896341f};
+
+/* The bit patterns of sqrt(0.5) and 1.0. */
+constexpr int SqrtHalfBits{0x3f3504f3};
+constexpr int OneBits{0x3f800000};
+
+inline float fast_log(const float x) noexcept
+{
+    union { float f; int i; } conv{x};
+    const int ix{conv.i - SqrtHalfBits};
+    const int e{ix >> 23};
+    conv.i = (ix & 0x007fffff) + SqrtHalfBits;
+
+    const float t{(conv.f - 1.0f) / (conv.f + 1.0f)};
+    const float t2{t * t};
+    const float ln_m{t * (2.0f + t2*(2.0f/3.0f + t2*(2.0f/5.0f + t2*(2.0f/7.0f))))};
+    return static_cast<float>(e)*Ln2Hi + (static_cast<float>(e)*Ln2Lo + ln_m);
+}
+
+inline float fast_exp(const float x) noexcept
+{
+    const float xc{clampf(x, -87.0f, 88.0f)};
+    const int n{fastf2i(xc * Log2e)};
+    const float r{(xc - static_cast<float>(n)*Ln2Hi) - static_cast<float>(n)*Ln2Lo};
+
+    const float er{1.0f + r*(1.0f + r*(1.0f/2.0f + r*(1.0f/6.0f + r*(1.0f/24.0f +
+        r*(1.0f/120.0f + r*(1.0f/720.0f))))))};
+    union { int i; float f; } conv{(n << 23) + OneBits};
+    return er * conv.f;
+}
+
+#ifdef HAVE_SSE_INTRINSICS
+
+inline __m128 fast_log4(const __m128 x) noexcept
+{
+    const __m128i ix{_mm_sub_epi32(_mm_castps_si128(x), _mm_set1_epi32(SqrtHalfBits))};
+    const __m128 e{_mm_cvtepi32_ps(_mm_srai_epi32(ix, 23))};
+    const __m128 m{_mm_castsi128_ps(_mm_add_epi32(_mm_and_si128(ix, _mm_set1_epi32(0x007fffff)),
+        _mm_set1_epi32(SqrtHalfBits)))};
+
+    const __m128 one{_mm_set1_ps(1.0f)};
+    const __m128 t{_mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one))};
+    const __m128 t2{_mm_mul_ps(t, t)};
+    __m128 ln_m{_mm_add_ps(_mm_set1_ps(2.0f/5.0f), _mm_mul_ps(t2, _mm_set1_ps(2.0f/7.0f)))};
+    ln_m = _mm_add_ps(_mm_set1_ps(2.0f/3.0f), _mm_mul_ps(t2, ln_m));
+    ln_m = _mm_add_ps(_mm_set1_ps(2.0f), _mm_mul_ps(t2, ln_m));
+    ln_m = _mm_mul_ps(t, ln_m);
+    return _mm_add_ps(_mm_mul_ps(e, _mm_set1_ps(Ln2Hi)),
+        _mm_add_ps(_mm_mul_ps(e, _mm_set1_ps(Ln2Lo)), ln_m));
+}
+
+inline __m128 fast_exp4(const __m128 x) noexcept
+{
+    const __m128 xc{_mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.0f)), _mm_set1_ps(88.0f))};
+    const __m128i ni{_mm_cvtps_epi32(_mm_mul_ps(xc, _mm_set1_ps(Log2e)))};
+    const __m128 n{_mm_cvtepi32_ps(ni)};
+    const __m128 r{_mm_sub_ps(_mm_sub_ps(xc, _mm_mul_ps(n, _mm_set1_ps(Ln2Hi))),
+        _mm_mul_ps(n, _mm_set1_ps(Ln2Lo)))};
+
+    __m128 er{_mm_add_ps(_mm_set1_ps(1.0f/120.0f), _mm_mul_ps(r, _mm_set1_ps(1.0f/720.0f)))};
+    er = _mm_add_ps(_mm_set1_ps(1.0f/24.0f), _mm_mul_ps(r, er));
+    er = _mm_add_ps(_mm_set1_ps(1.0f/6.0f), _mm_mul_ps(r, er));
+    er = _mm_add_ps(_mm_set1_ps(1.0f/2.0f), _mm_mul_ps(r, er));
+    er = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r, er));
+    er = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r, er));
+    const __m128 scale{_mm_castsi128_ps(_mm_add_epi32(_mm_slli_epi32(ni, 23),
+        _mm_set1_epi32(OneBits)))};
+    return _mm_mul_ps(er, scale);
+}
+
+#endif
+
+#endif /* FASTLOGEXP_H */
@@ -128,6 +128,14 @@ public:
         z2 = in*mB2 - out*mA2;
         return out;
     }
+    /* Same as processOne with a 0 input, e.g. for zero-stuffed samples. */
+    Real processZero(Real &z1, Real &z2) const noexcept
+    {
+        const Real out{z1};
+        z1 = z2 - out*mA1;
+        z2 = -out*mA2;
+        return out;
+    }
 };
 
 template<typename Real>
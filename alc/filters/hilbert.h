@@ -0,0 +1,20 @@
+#ifndef FILTER_HILBERT_H
+#define FILTER_HILBERT_H
+
+/* Squared coefficients for a pair of 8th order polyphase all-pass networks
+ * (four 2nd order sections each), designed by Olli Niemitalo. Each section is
+ *
+ *   y[n] = a*(x[n] + y[n-2]) - x[n-2]
+ *
+ * The outputs of the two networks are within a degree or so of 90 degrees
+ * apart from ~20hz to ~21khz at 44.1khz, given the first network is delayed by
+ * one sample, with the second lagging the first. This provides an approximate
+ * wide-band phase shift with effectively no latency, as long as everything is
+ * passed through one network or the other.
+ */
+constexpr float HilbertCoeffs[2][4]{
+    { 0.479400866f, 0.876218494f, 0.976597590f, 0.997499256f },
+    { 0.161758498f, 0.733028932f, 0.945349700f, 0.990599157f }
+};
+
+#endif /* FILTER_HILBERT_H */
@@ -99,6 +99,89 @@ AL_API void AL_APIENTRY alGetBufferPtrvSOFT(ALuint buffer, ALenum param, ALvoid
 #define AL_UNPACK_AMBISONIC_ORDER_SOFT           0x199D
 #endif
 
+#ifndef AL_SOFT_async_buffer_data
+#define AL_SOFT_async_buffer_data
+#define AL_EVENT_TYPE_BUFFER_LOADED_SOFT         0x19A2
+#define AL_BUFFER_LOADING_SOFT                   0x19A3
+typedef void (AL_APIENTRY*LPALBUFFERDATAASYNCSOFT)(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferDataAsyncSOFT(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq);
+#endif
+#endif
+
+#ifndef AL_SOFT_event_polling
+#define AL_SOFT_event_polling
+#define AL_EVENT_POLLING_SOFT                    0x19A4
+#define AL_EVENT_MESSAGES_SOFT                   0x19A5
+typedef struct ALeventSOFT {
+    ALenum type;
+    ALuint object;
+    ALuint param;
+} ALeventSOFT;
+typedef ALsizei (AL_APIENTRY*LPALPOLLEVENTSSOFT)(ALsizei count, ALeventSOFT *events);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALsizei AL_APIENTRY alPollEventsSOFT(ALsizei count, ALeventSOFT *events);
+#endif
+#endif
+
+#ifndef AL_SOFT_hrtf_lod
+#define AL_SOFT_hrtf_lod
+#define AL_SOURCE_HRTF_SOFT                      0x19A6
+#endif
+
+#ifndef AL_SOFT_resampler_lod
+#define AL_SOFT_resampler_lod
+#define AL_RESAMPLER_VOICES_SOFT                 0x19A7
+#endif
+
+#ifndef AL_SOFT_submix_bus
+#define AL_SOFT_submix_bus
+#define AL_DIRECT_BUS_SOFT                       0x19A8
+#define AL_BUS_TARGET_SOFT                       0x19A9
+typedef void (AL_APIENTRY*LPALGENBUSESSOFT)(ALsizei n, ALuint *buses);
+typedef void (AL_APIENTRY*LPALDELETEBUSESSOFT)(ALsizei n, const ALuint *buses);
+typedef ALboolean (AL_APIENTRY*LPALISBUSSOFT)(ALuint bus);
+typedef void (AL_APIENTRY*LPALBUSISOFT)(ALuint bus, ALenum param, ALint value);
+typedef void (AL_APIENTRY*LPALBUSFSOFT)(ALuint bus, ALenum param, ALfloat value);
+typedef void (AL_APIENTRY*LPALGETBUSISOFT)(ALuint bus, ALenum param, ALint *value);
+typedef void (AL_APIENTRY*LPALGETBUSFSOFT)(ALuint bus, ALenum param, ALfloat *value);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alGenBusesSOFT(ALsizei n, ALuint *buses);
+AL_API void AL_APIENTRY alDeleteBusesSOFT(ALsizei n, const ALuint *buses);
+AL_API ALboolean AL_APIENTRY alIsBusSOFT(ALuint bus);
+AL_API void AL_APIENTRY alBusiSOFT(ALuint bus, ALenum param, ALint value);
+AL_API void AL_APIENTRY alBusfSOFT(ALuint bus, ALenum param, ALfloat value);
+AL_API void AL_APIENTRY alGetBusiSOFT(ALuint bus, ALenum param, ALint *value);
+AL_API void AL_APIENTRY alGetBusfSOFT(ALuint bus, ALenum param, ALfloat *value);
+#endif
+#endif
+
+#ifndef ALC_SOFT_loopback_batch
+#define ALC_SOFT_loopback_batch
+typedef void (ALC_APIENTRY*LPALCRENDERSAMPLESBATCHSOFT)(ALCsizei count, ALCdevice *const *devices, ALCvoid *const *buffers, ALCsizei samples, ALCint64SOFT *renderTimes);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API void ALC_APIENTRY alcRenderSamplesBatchSOFT(ALCsizei count, ALCdevice *const *devices, ALCvoid *const *buffers, ALCsizei samples, ALCint64SOFT *renderTimes);
+#endif
+#endif
+
+#ifndef ALC_SOFT_capture_direct
+#define ALC_SOFT_capture_direct
+typedef void (ALC_APIENTRY*LPALCCAPTURECALLBACKTYPESOFT)(ALCdevice *device, ALCsizei samples, ALCvoid *userptr);
+typedef ALCsizei (ALC_APIENTRY*LPALCCAPTUREREADVECTORSOFT)(ALCdevice *device, const ALCvoid **buffers, ALCsizei *samples);
+typedef void (ALC_APIENTRY*LPALCCAPTUREADVANCESOFT)(ALCdevice *device, ALCsizei samples);
+typedef void (ALC_APIENTRY*LPALCCAPTURECALLBACKSOFT)(ALCdevice *device, LPALCCAPTURECALLBACKTYPESOFT callback, ALCvoid *userptr, ALCsizei chunk);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCsizei ALC_APIENTRY alcCaptureReadVectorSOFT(ALCdevice *device, const ALCvoid **buffers, ALCsizei *samples);
+ALC_API void ALC_APIENTRY alcCaptureAdvanceSOFT(ALCdevice *device, ALCsizei samples);
+ALC_API void ALC_APIENTRY alcCaptureCallbackSOFT(ALCdevice *device, LPALCCAPTURECALLBACKTYPESOFT callback, ALCvoid *userptr, ALCsizei chunk);
+#endif
+#endif
+
+#ifndef ALC_SOFT_device_idle
+#define ALC_SOFT_device_idle
+#define ALC_IDLE_SAMPLES_SOFT                    0x19AA
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -3,6 +3,10 @@
 
 #include "mastering.h"
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
@@ -16,6 +20,7 @@
 #include "almalloc.h"
 #include "alnumeric.h"
 #include "alu.h"
+#include "fastlogexp.h"
 #include "opthelpers.h"
 
 
@@ -96,6 +101,36 @@ void ShiftSlidingHold(SlidingHold *Hold, const ALuint n)
 }
 
 
+/* Clamps the minimum amplitude to near-zero and converts to logarithm. */
+void LogPeaks(const al::span<float> values)
+{
+    auto iter = values.begin();
+#ifdef HAVE_SSE_INTRINSICS
+    const __m128 minval{_mm_set1_ps(0.000001f)};
+    for(;values.end()-iter >= 4;iter += 4)
+    {
+        const __m128 s{_mm_loadu_ps(std::addressof(*iter))};
+        _mm_storeu_ps(std::addressof(*iter), fast_log4(_mm_max_ps(minval, s)));
+    }
+#endif
+    std::transform(iter, values.end(), iter,
+        [](const float s) noexcept -> float { return fast_log(maxf(0.000001f, s)); });
+}
+
+void ExpValues(const al::span<float> values)
+{
+    auto iter = values.begin();
+#ifdef HAVE_SSE_INTRINSICS
+    for(;values.end()-iter >= 4;iter += 4)
+    {
+        const __m128 s{_mm_loadu_ps(std::addressof(*iter))};
+        _mm_storeu_ps(std::addressof(*iter), fast_exp4(s));
+    }
+#endif
+    std::transform(iter, values.end(), iter, fast_exp);
+}
+
+
 /* Multichannel compression is linked via the absolute maximum of all
  * channels.
  */
@@ -106,14 +141,23 @@ void LinkChannels(Compressor *Comp, const ALuint SamplesToDo, const FloatBufferL
     ASSUME(SamplesToDo > 0);
     ASSUME(numChans > 0);
 
-    auto side_begin = std::begin(Comp->mSideChain) + Comp->mLookAhead;
+    float *RESTRICT side_begin{Comp->mSideChain + Comp->mLookAhead};
     std::fill(side_begin, side_begin+SamplesToDo, 0.0f);
 
     auto fill_max = [SamplesToDo,side_begin](const FloatBufferLine &input) -> void
     {
         const float *RESTRICT buffer{al::assume_aligned<16>(input.data())};
-        auto max_abs = std::bind(maxf, _1, std::bind(static_cast<float(&)(float)>(std::fabs), _2));
-        std::transform(side_begin, side_begin+SamplesToDo, buffer, side_begin, max_abs);
+        ALuint i{0};
+#ifdef HAVE_SSE_INTRINSICS
+        const __m128 absmask{_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))};
+        for(;SamplesToDo-i >= 4;i += 4)
+        {
+            const __m128 s{_mm_and_ps(_mm_load_ps(&buffer[i]), absmask)};
+            _mm_storeu_ps(&side_begin[i], _mm_max_ps(_mm_loadu_ps(&side_begin[i]), s));
+        }
+#endif
+        for(;i < SamplesToDo;++i)
+            side_begin[i] = maxf(side_begin[i], std::fabs(buffer[i]));
     };
     std::for_each(OutBuffer, OutBuffer+numChans, fill_max);
 }
@@ -154,10 +198,7 @@ void PeakDetector(Compressor *Comp, const ALuint SamplesToDo)
 {
     ASSUME(SamplesToDo > 0);
 
-    /* Clamp the minimum amplitude to near-zero and convert to logarithm. */
-    auto side_begin = std::begin(Comp->mSideChain) + Comp->mLookAhead;
-    std::transform(side_begin, side_begin+SamplesToDo, side_begin,
-        [](const float s) -> float { return std::log(maxf(0.000001f, s)); });
+    LogPeaks({Comp->mSideChain + Comp->mLookAhead, SamplesToDo});
 }
 
 /* An optional hold can be used to extend the peak detector so it can more
@@ -168,14 +209,16 @@ void PeakHoldDetector(Compressor *Comp, const ALuint SamplesToDo)
 {
     ASSUME(SamplesToDo > 0);
 
+    /* The logarithm is monotonic, so it can be taken for the whole block
+     * before going through the hold.
+     */
+    auto side_begin = std::begin(Comp->mSideChain) + Comp->mLookAhead;
+    LogPeaks({side_begin, SamplesToDo});
+
     SlidingHold *hold{Comp->mHold};
     ALuint i{0};
-    auto detect_peak = [&i,hold](const float x_abs) -> float
-    {
-        const float x_G{std::log(maxf(0.000001f, x_abs))};
-        return UpdateSlidingHold(hold, i++, x_G);
-    };
-    auto side_begin = std::begin(Comp->mSideChain) + Comp->mLookAhead;
+    auto detect_peak = [&i,hold](const float x_G) -> float
+    { return UpdateSlidingHold(hold, i++, x_G); };
     std::transform(side_begin, side_begin+SamplesToDo, side_begin, detect_peak);
 
     ShiftSlidingHold(hold, SamplesToDo);
@@ -200,20 +243,41 @@ void GainCompressor(Compressor *Comp, const ALuint SamplesToDo)
     const float release{Comp->mRelease};
     const float c_est{Comp->mGainEstimate};
     const float a_adp{Comp->mAdaptCoeff};
-    const float *crestFactor{Comp->mCrestFactor};
     float postGain{Comp->mPostGain};
     float knee{Comp->mKnee};
-    float t_att{attack};
-    float t_rel{release - attack};
-    float a_att{std::exp(-1.0f / t_att)};
-    float a_rel{std::exp(-1.0f / t_rel)};
     float y_1{Comp->mLastRelease};
     float y_L{Comp->mLastAttack};
     float c_dev{Comp->mLastGainDev};
 
     ASSUME(SamplesToDo > 0);
 
-    for(float &sideChain : al::span<float>{Comp->mSideChain, SamplesToDo})
+    /* The attack and release coefficients only depend on the crest factor,
+     * so they're calculated for the whole block ahead of the gain computer.
+     */
+    alignas(16) float attackCoeffs[BUFFERSIZE];
+    alignas(16) float releaseCoeffs[BUFFERSIZE];
+    if(autoAttack || autoRelease)
+    {
+        const float *crestFactor{Comp->mCrestFactor};
+        for(ALuint i{0};i < SamplesToDo;++i)
+        {
+            const float y2_crest{crestFactor[i]};
+            const float t_att{autoAttack ? 2.0f*attack/y2_crest : attack};
+            const float t_rel{autoRelease ? 2.0f*release/y2_crest - t_att : release - attack};
+            attackCoeffs[i] = -1.0f / t_att;
+            releaseCoeffs[i] = -1.0f / t_rel;
+        }
+        ExpValues({attackCoeffs, SamplesToDo});
+        ExpValues({releaseCoeffs, SamplesToDo});
+    }
+    else
+    {
+        std::fill_n(attackCoeffs, SamplesToDo, std::exp(-1.0f / attack));
+        std::fill_n(releaseCoeffs, SamplesToDo, std::exp(-1.0f / (release - attack)));
+    }
+
+    float *sideChain{Comp->mSideChain};
+    for(ALuint i{0};i < SamplesToDo;++i)
     {
         if(autoKnee)
             knee = maxf(0.0f, 2.5f * (c_dev + c_est));
@@ -222,31 +286,19 @@ void GainCompressor(Compressor *Comp, const ALuint SamplesToDo)
         /* This is the gain computer.  It applies a static compression curve
          * to the control signal.
          */
-        const float x_over{std::addressof(sideChain)[lookAhead] - threshold};
+        const float x_over{sideChain[i+lookAhead] - threshold};
         const float y_G{
             (x_over <= -knee_h) ? 0.0f :
             (std::fabs(x_over) < knee_h) ? (x_over + knee_h) * (x_over + knee_h) / (2.0f * knee) :
             x_over};
 
-        const float y2_crest{*(crestFactor++)};
-        if(autoAttack)
-        {
-            t_att = 2.0f*attack/y2_crest;
-            a_att = std::exp(-1.0f / t_att);
-        }
-        if(autoRelease)
-        {
-            t_rel = 2.0f*release/y2_crest - t_att;
-            a_rel = std::exp(-1.0f / t_rel);
-        }
-
         /* Gain smoothing (ballistics) is done via a smooth decoupled peak
          * detector.  The attack time is subtracted from the release time
          * above to compensate for the chained operating mode.
          */
         const float x_L{-slope * y_G};
-        y_1 = maxf(x_L, lerp(x_L, y_1, a_rel));
-        y_L = lerp(y_1, y_L, a_att);
+        y_1 = maxf(x_L, lerp(x_L, y_1, releaseCoeffs[i]));
+        y_L = lerp(y_1, y_L, attackCoeffs[i]);
 
         /* Knee width and make-up gain automation make use of a smoothed
          * measurement of deviation between the control signal and estimate.
@@ -264,13 +316,15 @@ void GainCompressor(Compressor *Comp, const ALuint SamplesToDo)
              * same output level.
              */
             if(autoDeclip)
-                c_dev = maxf(c_dev, sideChain - y_L - threshold - c_est);
+                c_dev = maxf(c_dev, sideChain[i] - y_L - threshold - c_est);
 
             postGain = -(c_dev + c_est);
         }
 
-        sideChain = std::exp(postGain - y_L);
+        sideChain[i] = postGain - y_L;
     }
+    /* Convert the gains out of the log domain together. */
+    ExpValues({sideChain, SamplesToDo});
 
     Comp->mLastRelease = y_1;
     Comp->mLastAttack = y_L;
@@ -17,6 +17,8 @@ struct LerpTag;
 struct CubicTag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
+struct FastPolyBSincTag;
 
 
 namespace {
@@ -66,6 +68,38 @@ inline float do_fastbsinc(const InterpState &istate, const float *RESTRICT vals,
         r += (fil[j_f] + pf*phd[j_f]) * vals[j_f];
     return r;
 }
+inline float do_polybsinc(const InterpState &istate, const float *RESTRICT vals, const ALuint frac)
+{
+    const size_t m{istate.bsinc.m};
+
+    // The position is always on a phase, so there's no phase interpolation.
+    const ALuint pi{frac >> FRAC_PHASE_BITDIFF};
+
+    const float *fil{istate.bsinc.filter + m*pi*4};
+    const float *scd{fil + m*2};
+
+    // Apply the scale interpolated filter.
+    float r{0.0f};
+    for(size_t j_f{0};j_f < m;j_f++)
+        r += (fil[j_f] + istate.bsinc.sf*scd[j_f]) * vals[j_f];
+    return r;
+}
+inline float do_fastpolybsinc(const InterpState &istate, const float *RESTRICT vals,
+    const ALuint frac)
+{
+    const size_t m{istate.bsinc.m};
+
+    // The position is always on a phase, so there's no phase interpolation.
+    const ALuint pi{frac >> FRAC_PHASE_BITDIFF};
+
+    const float *fil{istate.bsinc.filter + m*pi*4};
+
+    // Apply the filter.
+    float r{0.0f};
+    for(size_t j_f{0};j_f < m;j_f++)
+        r += fil[j_f] * vals[j_f];
+    return r;
+}
 
 using SamplerT = float(&)(const InterpState&, const float*RESTRICT, const ALuint);
 template<SamplerT Sampler>
@@ -135,6 +169,24 @@ const float *Resample_<FastBSincTag,CTag>(const InterpState *state, const float
     ALuint frac, ALuint increment, const al::span<float> dst)
 { return DoResample<do_fastbsinc>(state, src-state->bsinc.l, frac, increment, dst); }
 
+template<>
+const float *Resample_<PolyBSincTag,CTag>(const InterpState *state, const float *RESTRICT src,
+    ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    if UNLIKELY(frac & (FRAC_PHASE_DIFFONE-1))
+        return Resample_<BSincTag,CTag>(state, src, frac, increment, dst);
+    return DoResample<do_polybsinc>(state, src-state->bsinc.l, frac, increment, dst);
+}
+
+template<>
+const float *Resample_<FastPolyBSincTag,CTag>(const InterpState *state,
+    const float *RESTRICT src, ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    if UNLIKELY(frac & (FRAC_PHASE_DIFFONE-1))
+        return Resample_<FastBSincTag,CTag>(state, src, frac, increment, dst);
+    return DoResample<do_fastpolybsinc>(state, src-state->bsinc.l, frac, increment, dst);
+}
+
 
 template<>
 void MixHrtf_<CTag>(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
@@ -17,6 +17,8 @@ struct NEONTag;
 struct LerpTag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
+struct FastPolyBSincTag;
 
 
 namespace {
@@ -191,6 +193,88 @@ const float *Resample_<FastBSincTag,NEONTag>(const InterpState *state,
     return dst.data();
 }
 
+template<>
+const float *Resample_<PolyBSincTag,NEONTag>(const InterpState *state, const float *RESTRICT src,
+    ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    if UNLIKELY(frac & (FRAC_PHASE_DIFFONE-1))
+        return Resample_<BSincTag,NEONTag>(state, src, frac, increment, dst);
+
+    const float *const filter{state->bsinc.filter};
+    const float32x4_t sf4{vdupq_n_f32(state->bsinc.sf)};
+    const size_t m{state->bsinc.m};
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // The position is always on a phase, so there's no phase interpolation.
+        const ALuint pi{frac >> FRAC_PHASE_BITDIFF};
+
+        // Apply the scale interpolated filter.
+        float32x4_t r4{vdupq_n_f32(0.0f)};
+        {
+            const float *fil{filter + m*pi*4};
+            const float *scd{fil + m*2};
+            size_t td{m >> 2};
+            size_t j{0u};
+
+            do {
+                /* f = fil + sf*scd */
+                const float32x4_t f4 = vmlaq_f32(vld1q_f32(&fil[j]), sf4, vld1q_f32(&scd[j]));
+                /* r += f*src */
+                r4 = vmlaq_f32(r4, f4, vld1q_f32(&src[j]));
+                j += 4;
+            } while(--td);
+        }
+        r4 = vaddq_f32(r4, vrev64q_f32(r4));
+        out_sample = vget_lane_f32(vadd_f32(vget_low_f32(r4), vget_high_f32(r4)), 0);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst.data();
+}
+
+template<>
+const float *Resample_<FastPolyBSincTag,NEONTag>(const InterpState *state,
+    const float *RESTRICT src, ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    if UNLIKELY(frac & (FRAC_PHASE_DIFFONE-1))
+        return Resample_<FastBSincTag,NEONTag>(state, src, frac, increment, dst);
+
+    const float *const filter{state->bsinc.filter};
+    const size_t m{state->bsinc.m};
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // The position is always on a phase, so there's no phase interpolation.
+        const ALuint pi{frac >> FRAC_PHASE_BITDIFF};
+
+        // Apply the filter.
+        float32x4_t r4{vdupq_n_f32(0.0f)};
+        {
+            const float *fil{filter + m*pi*4};
+            size_t td{m >> 2};
+            size_t j{0u};
+
+            do {
+                /* r += fil*src */
+                r4 = vmlaq_f32(r4, vld1q_f32(&fil[j]), vld1q_f32(&src[j]));
+                j += 4;
+            } while(--td);
+        }
+        r4 = vaddq_f32(r4, vrev64q_f32(r4));
+        out_sample = vget_lane_f32(vadd_f32(vget_low_f32(r4), vget_high_f32(r4)), 0);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst.data();
+}
+
 
 template<>
 void MixHrtf_<NEONTag>(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
@@ -16,6 +16,8 @@
 struct SSETag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
+struct FastPolyBSincTag;
 
 
 namespace {
@@ -166,6 +168,91 @@ const float *Resample_<FastBSincTag,SSETag>(const InterpState *state, const floa
 }
 
 
+template<>
+const float *Resample_<PolyBSincTag,SSETag>(const InterpState *state, const float *RESTRICT src,
+    ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    if UNLIKELY(frac & (FRAC_PHASE_DIFFONE-1))
+        return Resample_<BSincTag,SSETag>(state, src, frac, increment, dst);
+
+    const float *const filter{state->bsinc.filter};
+    const __m128 sf4{_mm_set1_ps(state->bsinc.sf)};
+    const size_t m{state->bsinc.m};
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // The position is always on a phase, so there's no phase interpolation.
+        const ALuint pi{frac >> FRAC_PHASE_BITDIFF};
+
+        // Apply the scale interpolated filter.
+        __m128 r4{_mm_setzero_ps()};
+        {
+            const float *fil{filter + m*pi*4};
+            const float *scd{fil + m*2};
+            size_t td{m >> 2};
+            size_t j{0u};
+
+            do {
+                /* f = fil + sf*scd */
+                const __m128 f4 = MLA4(_mm_load_ps(&fil[j]), sf4, _mm_load_ps(&scd[j]));
+                /* r += f*src */
+                r4 = MLA4(r4, f4, _mm_loadu_ps(&src[j]));
+                j += 4;
+            } while(--td);
+        }
+        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+        out_sample = _mm_cvtss_f32(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst.data();
+}
+
+template<>
+const float *Resample_<FastPolyBSincTag,SSETag>(const InterpState *state,
+    const float *RESTRICT src, ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    if UNLIKELY(frac & (FRAC_PHASE_DIFFONE-1))
+        return Resample_<FastBSincTag,SSETag>(state, src, frac, increment, dst);
+
+    const float *const filter{state->bsinc.filter};
+    const size_t m{state->bsinc.m};
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // The position is always on a phase, so there's no phase interpolation.
+        const ALuint pi{frac >> FRAC_PHASE_BITDIFF};
+
+        // Apply the filter.
+        __m128 r4{_mm_setzero_ps()};
+        {
+            const float *fil{filter + m*pi*4};
+            size_t td{m >> 2};
+            size_t j{0u};
+
+            do {
+                /* r += fil*src */
+                r4 = MLA4(r4, _mm_load_ps(&fil[j]), _mm_loadu_ps(&src[j]));
+                j += 4;
+            } while(--td);
+        }
+        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+        out_sample = _mm_cvtss_f32(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst.data();
+}
+
+
 template<>
 void MixHrtf_<SSETag>(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
     const MixHrtfFilter *hrtfparams, const size_t BufferSize)
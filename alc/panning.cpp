@@ -799,6 +799,18 @@ void InitHrtfPanning(ALCdevice *device)
         (device->mRenderMode == HrtfRender) ? "+ Full " : "",
         device->HrtfName.c_str());
 
+    if(device->mRenderMode == HrtfRender)
+    {
+        const char *devname{device->DeviceName.c_str()};
+        if(auto gainopt = ConfigValueFloat(devname, nullptr, "hrtf-lod-gain"))
+            device->mHrtfLodGain = std::pow(10.0f, *gainopt / 20.0f);
+        if(auto distopt = ConfigValueFloat(devname, nullptr, "hrtf-lod-distance"))
+            device->mHrtfLodDistance = maxf(*distopt, 0.0f);
+        if(device->mHrtfLodGain > 0.0f || device->mHrtfLodDistance > 0.0f)
+            TRACE("HRTF level of detail: gain limit %f, distance limit %.2f meters\n",
+                device->mHrtfLodGain, device->mHrtfLodDistance);
+    }
+
     al::span<const AngularPoint> AmbiPoints{AmbiPoints1O};
     const float (*AmbiMatrix)[MAX_AMBI_CHANNELS]{AmbiMatrix1O};
     al::span<const float,MAX_AMBI_ORDER+1> AmbiOrderHFGain{AmbiOrderHFGain1O};
@@ -852,6 +864,8 @@ void aluInitRenderer(ALCdevice *device, int hrtf_id, HrtfRequestMode hrtf_appreq
     device->mHrtf = nullptr;
     device->HrtfName.clear();
     device->mRenderMode = NormalRender;
+    device->mHrtfLodGain = 0.0f;
+    device->mHrtfLodDistance = 0.0f;
 
     if(device->FmtChans != DevFmtStereo)
     {
@@ -1021,8 +1035,16 @@ no_hrtf:
     }
     if(device->mRenderMode == NormalRender)
     {
-        device->Uhj_Encoder = std::make_unique<Uhj2Encoder>();
-        TRACE("UHJ enabled\n");
+        bool useIIR{false};
+        if(auto filteropt = ConfigValueStr(device->DeviceName.c_str(), nullptr, "uhj-filter"))
+        {
+            if(al::strcasecmp(filteropt->c_str(), "iir") == 0)
+                useIIR = true;
+            else if(al::strcasecmp(filteropt->c_str(), "fir") != 0)
+                ERR("Unexpected uhj-filter: %s\n", filteropt->c_str());
+        }
+        device->Uhj_Encoder = std::make_unique<Uhj2Encoder>(useIIR);
+        TRACE("UHJ enabled (%s filter)\n", useIIR ? "IIR" : "FIR");
         InitUhjPanning(device);
         device->PostProcess = &ALCdevice::ProcessUhj;
         return;
@@ -14,6 +14,7 @@
 
 #include "alcomplex.h"
 #include "alnumeric.h"
+#include "filters/hilbert.h"
 #include "opthelpers.h"
 
 
@@ -172,6 +173,12 @@ void Uhj2Encoder::encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
     const float *RESTRICT xinput{al::assume_aligned<16>(InSamples[1].data())};
     const float *RESTRICT yinput{al::assume_aligned<16>(InSamples[2].data())};
 
+    if(mUseIIR)
+    {
+        encodeIIR(left, right, winput, xinput, yinput, SamplesToDo);
+        return;
+    }
+
     /* Combine the previously delayed mid/side signal with the input. */
 
     /* S = 0.9396926*W + 0.1855740*X */
@@ -212,3 +219,106 @@ void Uhj2Encoder::encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
     for(size_t i{0};i < SamplesToDo;i++)
         right[i] = (mMid[i] - mSide[i]) * 0.5f;
 }
+
+void Uhj2Encoder::encodeIIR(float *RESTRICT left, float *RESTRICT right,
+    const float *RESTRICT winput, const float *RESTRICT xinput, const float *RESTRICT yinput,
+    const size_t SamplesToDo)
+{
+    float *RESTRICT mid{mMid.data()};
+    float *RESTRICT side{mSide.data()};
+    float *RESTRICT jside{mTemp.data()};
+
+    /* S = 0.9396926*W + 0.1855740*X */
+    for(size_t i{0};i < SamplesToDo;++i)
+        mid[i] = 0.9396926f*winput[i] + 0.1855740f*xinput[i] + left[i] + right[i];
+    /* D = 0.6554516*Y */
+    for(size_t i{0};i < SamplesToDo;++i)
+        side[i] = 0.6554516f*yinput[i] + left[i] - right[i];
+    /* D += j(-0.3420201*W + 0.5098604*X) */
+    for(size_t i{0};i < SamplesToDo;++i)
+        jside[i] = -0.3420201f*winput[i] + 0.5098604f*xinput[i];
+
+    /* The mid and side signals run through the first network, and the j
+     * signal through the second, as lanes of one set of sections (the last
+     * lane is unused). The history holds the two previous inputs of each
+     * section, with the last being the two previous outputs. Since the
+     * sections only use the samples from two steps back, pairs of samples can
+     * be done together.
+     */
+    auto &hist = mApHistory;
+    size_t i{0};
+#ifdef HAVE_SSE_INTRINSICS
+    const __m128 coeffs[4]{
+        _mm_setr_ps(HilbertCoeffs[0][0], HilbertCoeffs[0][0], HilbertCoeffs[1][0], 0.0f),
+        _mm_setr_ps(HilbertCoeffs[0][1], HilbertCoeffs[0][1], HilbertCoeffs[1][1], 0.0f),
+        _mm_setr_ps(HilbertCoeffs[0][2], HilbertCoeffs[0][2], HilbertCoeffs[1][2], 0.0f),
+        _mm_setr_ps(HilbertCoeffs[0][3], HilbertCoeffs[0][3], HilbertCoeffs[1][3], 0.0f)};
+    __m128 h0[5], h1[5];
+    for(size_t j{0};j < 5;++j)
+    {
+        h0[j] = _mm_load_ps(hist[j][0].data());
+        h1[j] = _mm_load_ps(hist[j][1].data());
+    }
+    for(;SamplesToDo-i >= 2;i += 2)
+    {
+        __m128 s0{_mm_setr_ps(mid[i], side[i], jside[i], 0.0f)};
+        __m128 s1{_mm_setr_ps(mid[i+1], side[i+1], jside[i+1], 0.0f)};
+        for(size_t j{0};j < 4;++j)
+        {
+            const __m128 out0{_mm_sub_ps(_mm_mul_ps(coeffs[j], _mm_add_ps(s0, h0[j+1])), h0[j])};
+            const __m128 out1{_mm_sub_ps(_mm_mul_ps(coeffs[j], _mm_add_ps(s1, h1[j+1])), h1[j])};
+            h0[j] = s0; h1[j] = s1;
+            s0 = out0; s1 = out1;
+        }
+        h0[4] = s0; h1[4] = s1;
+
+        alignas(16) float out[2][4];
+        _mm_store_ps(out[0], s0);
+        _mm_store_ps(out[1], s1);
+        mid[i] = out[0][0]; side[i] = out[0][1]; jside[i] = out[0][2];
+        mid[i+1] = out[1][0]; side[i+1] = out[1][1]; jside[i+1] = out[1][2];
+    }
+    for(size_t j{0};j < 5;++j)
+    {
+        _mm_store_ps(hist[j][0].data(), h0[j]);
+        _mm_store_ps(hist[j][1].data(), h1[j]);
+    }
+#endif
+    for(;i < SamplesToDo;++i)
+    {
+        std::array<float,4> smp{{mid[i], side[i], jside[i], 0.0f}};
+        for(size_t j{0};j < 4;++j)
+        {
+            std::array<float,4> out;
+            for(size_t c{0};c < 4;++c)
+            {
+                const float coeff{(c < 2) ? HilbertCoeffs[0][j] : (c < 3) ? HilbertCoeffs[1][j]
+                    : 0.0f};
+                out[c] = coeff*(smp[c] + hist[j+1][0][c]) - hist[j][0][c];
+            }
+            hist[j][0] = hist[j][1];
+            hist[j][1] = smp;
+            smp = out;
+        }
+        hist[4][0] = hist[4][1];
+        hist[4][1] = smp;
+        mid[i] = smp[0]; side[i] = smp[1]; jside[i] = smp[2];
+    }
+
+    /* The first network's outputs are delayed by a sample to be 90 degrees
+     * apart from the second's.
+     */
+    float mid_delay{mApDelay[0]};
+    float side_delay{mApDelay[1]};
+    for(i = 0;i < SamplesToDo;++i)
+    {
+        /* Left = (S + D)/2.0 */
+        left[i] = (mid_delay + side_delay + jside[i]) * 0.5f;
+        /* Right = (S - D)/2.0 */
+        right[i] = (mid_delay - side_delay - jside[i]) * 0.5f;
+        mid_delay = mid[i];
+        side_delay = side[i];
+    }
+    mApDelay[0] = mid_delay;
+    mApDelay[1] = side_delay;
+}
@@ -18,7 +18,10 @@
  * where j is a wide-band +90 degree phase shift.
  *
  * The phase shift is done using a FIR filter derived from an FFT'd impulse
- * with the desired shift.
+ * with the desired shift. Optionally, it can instead be done with a pair of
+ * IIR all-pass networks, which shift everything by a frequency-dependent phase
+ * while keeping the j term 90 degrees apart from the rest. That's much cheaper
+ * and has no latency, but isn't linear-phase.
  */
 
 struct Uhj2Encoder {
@@ -40,6 +43,21 @@ struct Uhj2Encoder {
 
     alignas(16) std::array<float,BUFFERSIZE + sFilterSize*2> mTemp{};
 
+    /* Use the IIR all-pass networks instead of the FIR filter. */
+    bool mUseIIR{false};
+
+    /* History for the all-pass sections, with the mid, side, and j signals as
+     * lanes. The mid and side signals go through the first network and get
+     * its one-sample delay, while the j signal goes through the second.
+     */
+    alignas(16) std::array<std::array<std::array<float,4>,2>,5> mApHistory{};
+    std::array<float,2> mApDelay{};
+
+    Uhj2Encoder(bool useIIR) : mUseIIR{useIIR} { }
+
+    /** Returns the processing delay, in samples. */
+    size_t getDelay() const noexcept { return mUseIIR ? 0 : sFilterSize; }
+
     /**
      * Encodes a 2-channel UHJ (stereo-compatible) signal from a B-Format input
      * signal. The input must use FuMa channel ordering and scaling.
@@ -47,6 +65,11 @@ struct Uhj2Encoder {
     void encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
         const FloatBufferLine *InSamples, const size_t SamplesToDo);
 
+private:
+    void encodeIIR(float *RESTRICT left, float *RESTRICT right, const float *RESTRICT winput,
+        const float *RESTRICT xinput, const float *RESTRICT yinput, const size_t SamplesToDo);
+
+public:
     DEF_NEWDEL(Uhj2Encoder)
 };
 
@@ -308,6 +308,7 @@ void SendSourceStoppedEvent(ALCcontext *context, ALuint id)
     ring->writeAdvance(1);
 }
 
+} // namespace
 
 const float *DoFilters(BiquadFilter &lpfilter, BiquadFilter &hpfilter, float *dst,
     const al::span<const float> src, int type)
@@ -335,6 +336,7 @@ const float *DoFilters(BiquadFilter &lpfilter, BiquadFilter &hpfilter, float *ds
     return src.data();
 }
 
+namespace {
 
 template<FmtType T>
 inline void LoadSampleArray(float *RESTRICT dst, const al::byte *src, const size_t srcstep,
@@ -463,23 +465,23 @@ float *LoadBufferQueue(ALbufferlistitem *BufferListItem, ALbufferlistitem *Buffe
 }
 
 
-void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &parms,
+void DoHrtfMix(const float *samples, const ALuint DstBufferSize, HrtfParams &parms,
     const float TargetGain, const ALuint Counter, ALuint OutPos, const ALuint IrSize,
-    ALCdevice *Device)
+    const MixBuffers &Buffers)
 {
-    auto &HrtfSamples = Device->HrtfSourceData;
+    float *HrtfSamples{Buffers.HrtfSourceData};
     /* Source HRTF mixing needs to include the direct delay so it remains
      * aligned with the direct mix's HRTF filtering.
      */
-    float2 *AccumSamples{Device->HrtfAccumData + HRTF_DIRECT_DELAY};
+    float2 *AccumSamples{Buffers.HrtfAccumData + HRTF_DIRECT_DELAY};
 
     /* Copy the HRTF history and new input samples into a temp buffer. */
-    auto src_iter = std::copy(parms.Hrtf.History.begin(), parms.Hrtf.History.end(),
-        std::begin(HrtfSamples));
+    auto src_iter = std::copy(parms.History.begin(), parms.History.end(),
+        HrtfSamples);
     std::copy_n(samples, DstBufferSize, src_iter);
     /* Copy the last used samples back into the history buffer for later. */
-    std::copy_n(std::begin(HrtfSamples) + DstBufferSize, parms.Hrtf.History.size(),
-        parms.Hrtf.History.begin());
+    std::copy_n(HrtfSamples + DstBufferSize, parms.History.size(),
+        parms.History.begin());
 
     /* If fading and this is the first mixing pass, fade between the IRs. */
     ALuint fademix{0u};
@@ -497,19 +499,19 @@ void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &p
         if(Counter > fademix)
         {
             const float a{static_cast<float>(fademix) / static_cast<float>(Counter)};
-            gain = lerp(parms.Hrtf.Old.Gain, TargetGain, a);
+            gain = lerp(parms.Old.Gain, TargetGain, a);
         }
         MixHrtfFilter hrtfparams;
-        hrtfparams.Coeffs = &parms.Hrtf.Target.Coeffs;
-        hrtfparams.Delay = parms.Hrtf.Target.Delay;
+        hrtfparams.Coeffs = &parms.Target.Coeffs;
+        hrtfparams.Delay = parms.Target.Delay;
         hrtfparams.Gain = 0.0f;
         hrtfparams.GainStep = gain / static_cast<float>(fademix);
 
-        MixHrtfBlendSamples(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Hrtf.Old, &hrtfparams,
+        MixHrtfBlendSamples(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Old, &hrtfparams,
             fademix);
         /* Update the old parameters with the result. */
-        parms.Hrtf.Old = parms.Hrtf.Target;
-        parms.Hrtf.Old.Gain = gain;
+        parms.Old = parms.Target;
+        parms.Old.Gain = gain;
         OutPos += fademix;
     }
 
@@ -524,22 +526,23 @@ void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &p
         if(Counter > DstBufferSize)
         {
             const float a{static_cast<float>(todo) / static_cast<float>(Counter-fademix)};
-            gain = lerp(parms.Hrtf.Old.Gain, TargetGain, a);
+            gain = lerp(parms.Old.Gain, TargetGain, a);
         }
 
         MixHrtfFilter hrtfparams;
-        hrtfparams.Coeffs = &parms.Hrtf.Target.Coeffs;
-        hrtfparams.Delay = parms.Hrtf.Target.Delay;
-        hrtfparams.Gain = parms.Hrtf.Old.Gain;
-        hrtfparams.GainStep = (gain - parms.Hrtf.Old.Gain) / static_cast<float>(todo);
+        hrtfparams.Coeffs = &parms.Target.Coeffs;
+        hrtfparams.Delay = parms.Target.Delay;
+        hrtfparams.Gain = parms.Old.Gain;
+        hrtfparams.GainStep = (gain - parms.Old.Gain) / static_cast<float>(todo);
         MixHrtfSamples(HrtfSamples+fademix, AccumSamples+OutPos, IrSize, &hrtfparams, todo);
         /* Store the now-current gain for next time. */
-        parms.Hrtf.Old.Gain = gain;
+        parms.Old.Gain = gain;
     }
 }
 
 void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, DirectParams &parms,
-    const float *TargetGains, const ALuint Counter, const ALuint OutPos, ALCdevice *Device)
+    NfcFilter &nfcfilter, const float *TargetGains, const ALuint Counter, const ALuint OutPos,
+    ALCdevice *Device, const MixBuffers &Buffers)
 {
     using FilterProc = void (NfcFilter::*)(const al::span<const float>, float*);
     static constexpr FilterProc NfcProcess[MAX_AMBI_ORDER+1]{
@@ -551,11 +554,11 @@ void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, D
     ++CurrentGains;
     ++TargetGains;
 
-    const al::span<float> nfcsamples{Device->NfcSampleData, samples.size()};
+    const al::span<float> nfcsamples{Buffers.NfcSampleData, samples.size()};
     size_t order{1};
     while(const size_t chancount{Device->NumChannelsPerOrder[order]})
     {
-        (parms.NFCtrlFilter.*NfcProcess[order])(samples, nfcsamples.data());
+        (nfcfilter.*NfcProcess[order])(samples, nfcsamples.data());
         MixSamples(nfcsamples, {OutBuffer, chancount}, CurrentGains, TargetGains, Counter, OutPos);
         OutBuffer += chancount;
         CurrentGains += chancount;
@@ -567,7 +570,8 @@ void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, D
 
 } // namespace
 
-void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToDo)
+void Voice::mix(const State vstate, ALCcontext *Context, const MixBuffers &Buffers,
+    const ALuint SamplesToDo)
 {
     static constexpr std::array<float,MAX_OUTPUT_CHANNELS> SilentTarget{};
 
@@ -598,6 +602,8 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
     ALCdevice *Device{Context->mDevice.get()};
     const ALuint NumSends{Device->NumAuxSends};
     const ALuint IrSize{Device->mHrtf ? Device->mHrtf->irSize : 0};
+    const al::span<FloatBufferLine> DirectOut{Buffers.getTarget(mDirect.Buffer)};
+    const al::span<FloatBufferLine> DryOut{Buffers.getTarget(Device->Dry.Buffer)};
 
     ResamplerFunc Resample{(increment == FRACTIONONE && DataPosFrac == 0) ?
                            Resample_<CopyTag,CTag> : mResampler};
@@ -606,14 +612,17 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
     if(!Counter)
     {
         /* No fading, just overwrite the old/current params. */
+        if((mFlags&VOICE_HAS_HRTF))
+        {
+            for(auto &hrtfparams : mHrtfChans)
+                hrtfparams.Old = hrtfparams.Target;
+        }
         for(auto &chandata : mChans)
         {
+            if(!(mFlags&VOICE_HAS_HRTF))
             {
                 DirectParams &parms = chandata.mDryParams;
-                if(!(mFlags&VOICE_HAS_HRTF))
-                    parms.Gains.Current = parms.Gains.Target;
-                else
-                    parms.Hrtf.Old = parms.Hrtf.Target;
+                parms.Gains.Current = parms.Gains.Target;
             }
             for(ALuint send{0};send < NumSends;++send)
             {
@@ -708,7 +717,7 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             const size_t num_chans{mChans.size()};
             const auto chan = static_cast<size_t>(std::distance(mChans.data(),
                 std::addressof(chandata)));
-            const al::span<float> SrcData{Device->SourceData, SrcBufferSize};
+            const al::span<float> SrcData{Buffers.SourceData, SrcBufferSize};
 
             /* Load the previous samples into the source data first, then load
              * what we can from the buffer queue.
@@ -747,7 +756,20 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             /* Resample, then apply ambisonic upsampling as needed. */
             const float *ResampledData{Resample(&mResampleState,
                 &SrcData[MAX_RESAMPLER_PADDING>>1], DataPosFrac, increment,
-                {Device->ResampledData, DstBufferSize})};
+                {Buffers.ResampledData, DstBufferSize})};
+            if UNLIKELY(mPrevResampler && Resample == mResampler)
+            {
+                /* FilteredData isn't needed until after resampling, so the old
+                 * resampler can use it for its output.
+                 */
+                const float *PrevData{mPrevResampler(&mPrevResampleState,
+                    &SrcData[MAX_RESAMPLER_PADDING>>1], DataPosFrac, increment,
+                    {Buffers.FilteredData, DstBufferSize})};
+                float *dst{Buffers.ResampledData};
+                const float scale{1.0f / static_cast<float>(SamplesToDo)};
+                for(ALuint i{0};i < DstBufferSize;++i)
+                    dst[i] = lerp(PrevData[i], dst[i], static_cast<float>(OutPos+i+1)*scale);
+            }
             if((mFlags&VOICE_IS_AMBISONIC))
             {
                 const float hfscale{chandata.mAmbiScale};
@@ -762,31 +784,47 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             }
 
             /* Now filter and mix to the appropriate outputs. */
-            float (&FilterBuf)[BUFFERSIZE] = Device->FilteredData;
+            float *FilterBuf{Buffers.FilteredData};
             {
                 DirectParams &parms = chandata.mDryParams;
                 const float *samples{DoFilters(parms.LowPass, parms.HighPass, FilterBuf,
                     {ResampledData, DstBufferSize}, mDirect.FilterType)};
 
+                /* Fade out the path the voice just switched away from. */
+                if UNLIKELY((mFlags&VOICE_HRTF_SWITCHED))
+                {
+                    if(!(mFlags&VOICE_HAS_HRTF))
+                        DoHrtfMix(samples, DstBufferSize, mHrtfChans[chan], 0.0f, Counter,
+                            OutPos, IrSize, Buffers);
+                    else if(Device->AvgSpeakerDist > 0.0f)
+                        DoNfcMix({samples, DstBufferSize}, DryOut.data(), parms,
+                            mNfcChans[chan], SilentTarget.data(), Counter, OutPos, Device,
+                            Buffers);
+                    else
+                        MixSamples({samples, DstBufferSize}, DryOut,
+                            parms.Gains.Current.data(), SilentTarget.data(), Counter, OutPos);
+                }
+
                 if((mFlags&VOICE_HAS_HRTF))
                 {
+                    HrtfParams &hrtfparams = mHrtfChans[chan];
                     const float TargetGain{UNLIKELY(vstate == Stopping) ? 0.0f :
-                        parms.Hrtf.Target.Gain};
-                    DoHrtfMix(samples, DstBufferSize, parms, TargetGain, Counter, OutPos, IrSize,
-                        Device);
+                        hrtfparams.Target.Gain};
+                    DoHrtfMix(samples, DstBufferSize, hrtfparams, TargetGain, Counter, OutPos,
+                        IrSize, Buffers);
                 }
                 else if((mFlags&VOICE_HAS_NFC))
                 {
                     const float *TargetGains{UNLIKELY(vstate == Stopping) ? SilentTarget.data()
                         : parms.Gains.Target.data()};
-                    DoNfcMix({samples, DstBufferSize}, mDirect.Buffer.data(), parms, TargetGains,
-                        Counter, OutPos, Device);
+                    DoNfcMix({samples, DstBufferSize}, DirectOut.data(), parms, mNfcChans[chan],
+                        TargetGains, Counter, OutPos, Device, Buffers);
                 }
                 else
                 {
                     const float *TargetGains{UNLIKELY(vstate == Stopping) ? SilentTarget.data()
                         : parms.Gains.Target.data()};
-                    MixSamples({samples, DstBufferSize}, mDirect.Buffer,
+                    MixSamples({samples, DstBufferSize}, DirectOut,
                         parms.Gains.Current.data(), TargetGains, Counter, OutPos);
                 }
             }
@@ -877,6 +915,8 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
     } while(OutPos < SamplesToDo);
 
     mFlags |= VOICE_IS_FADING;
+    mFlags &= ~VOICE_HRTF_SWITCHED;
+    mPrevResampler = nullptr;
 
     /* Don't update positions and buffers if we were stopping. */
     if UNLIKELY(vstate == Stopping)
@@ -924,3 +964,28 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             SendSourceStoppedEvent(Context, SourceID);
     }
 }
+
+void Voice::initDirectFilters(const ALCdevice *device)
+{
+    const size_t num_channels{mChans.size()};
+
+    /* Only full HRTF rendering gives voices their own HRTF filters. */
+    if(device->mRenderMode != HrtfRender)
+        al::vector<HrtfParams>{}.swap(mHrtfChans);
+    else
+    {
+        mHrtfChans.clear();
+        mHrtfChans.resize(num_channels);
+    }
+
+    if(!(device->AvgSpeakerDist > 0.0f))
+        al::vector<NfcFilter>{}.swap(mNfcChans);
+    else
+    {
+        const float w1{SPEEDOFSOUNDMETRESPERSEC /
+            (device->AvgSpeakerDist * static_cast<float>(device->Frequency))};
+        mNfcChans.resize(num_channels);
+        for(auto &nfcfilter : mNfcChans)
+            nfcfilter.init(w1);
+    }
+}
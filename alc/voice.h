@@ -16,6 +16,7 @@
 #include "filters/splitter.h"
 #include "hrtf.h"
 
+struct ALbus;
 enum class DistanceModel;
 
 
@@ -25,6 +26,12 @@ enum class SpatializeMode : unsigned char {
     Auto = AL_AUTO_SOFT
 };
 
+enum class HrtfMode : unsigned char {
+    Off = AL_FALSE,
+    On = AL_TRUE,
+    Auto = AL_AUTO_SOFT
+};
+
 enum class DirectMode : unsigned char {
     Off = AL_FALSE,
     DropMismatch = AL_DROP_UNMATCHED_SOFT,
@@ -77,6 +84,13 @@ enum {
     AF_BandPass = AF_LowPass | AF_HighPass
 };
 
+/**
+ * Applies the given filter type (AF_*) to the source samples, using dst for
+ * the output if needed. Returns the filtered samples.
+ */
+const float *DoFilters(BiquadFilter &lpfilter, BiquadFilter &hpfilter, float *dst,
+    const al::span<const float> src, int type);
+
 
 struct MixHrtfFilter {
     const HrirArray *Coeffs;
@@ -90,20 +104,18 @@ struct DirectParams {
     BiquadFilter LowPass;
     BiquadFilter HighPass;
 
-    NfcFilter NFCtrlFilter;
-
-    struct {
-        HrtfFilter Old;
-        HrtfFilter Target;
-        alignas(16) std::array<float,HRTF_HISTORY_LENGTH> History;
-    } Hrtf;
-
     struct {
         std::array<float,MAX_OUTPUT_CHANNELS> Current;
         std::array<float,MAX_OUTPUT_CHANNELS> Target;
     } Gains;
 };
 
+struct HrtfParams {
+    HrtfFilter Old;
+    HrtfFilter Target;
+    alignas(16) std::array<float,HRTF_HISTORY_LENGTH> History;
+};
+
 struct SendParams {
     BiquadFilter LowPass;
     BiquadFilter HighPass;
@@ -136,6 +148,7 @@ struct VoiceProps {
     Resampler mResampler;
     DirectMode DirectChannels;
     SpatializeMode mSpatializeMode;
+    HrtfMode mHrtfMode;
 
     bool DryGainHFAuto;
     bool WetGainAuto;
@@ -157,6 +170,7 @@ struct VoiceProps {
         float HFReference;
         float GainLF;
         float LFReference;
+        ALbus *Bus;
     } Direct;
     struct SendData {
         ALeffectslot *Slot;
@@ -181,6 +195,8 @@ struct VoicePropsItem : public VoiceProps {
 #define VOICE_IS_FADING        (1u<<4) /* Fading sources use gain stepping for smooth transitions. */
 #define VOICE_HAS_HRTF         (1u<<5)
 #define VOICE_HAS_NFC          (1u<<6)
+#define VOICE_HRTF_PANNED      (1u<<7) /* Panned to the dry mix instead of using HRTF. */
+#define VOICE_HRTF_SWITCHED    (1u<<8) /* Switched to/from HRTF, so the old path fades out. */
 
 #define VOICE_TYPE_MASK (VOICE_IS_STATIC | VOICE_IS_CALLBACK)
 
@@ -199,6 +215,10 @@ struct Voice {
     std::atomic<ALuint> mSourceID{0u};
     std::atomic<State> mPlayState{Stopped};
     std::atomic<bool> mPendingChange{false};
+    /* Set when a committed update changes the voice's send slots or direct
+     * bus, which the mixer needs to apply before mixing again.
+     */
+    std::atomic<bool> mTargetsChanged{false};
 
     /**
      * Source offset in samples, relative to the currently playing buffer, NOT
@@ -231,6 +251,18 @@ struct Voice {
 
     InterpState mResampleState;
 
+    /* The resampler in use, which may be lowered from the requested one for
+     * quiet voices, and its level-of-detail step.
+     */
+    Resampler mResamplerType{Resampler::Point};
+    ALuint mResamplerLod{0};
+
+    /* After changing resamplers, the old one's output is crossfaded with the
+     * new one's over the next mix.
+     */
+    ResamplerFunc mPrevResampler{nullptr};
+    InterpState mPrevResampleState;
+
     ALuint mFlags{};
     ALuint mNumCallbackSamples{0};
 
@@ -252,12 +284,27 @@ struct Voice {
     };
     al::vector<ChannelData> mChans{2};
 
+    /* Per-channel HRTF and near-field filter state. These are large and only
+     * used with some outputs, so they're kept out of mChans and are empty
+     * unless the device can use them.
+     */
+    al::vector<HrtfParams> mHrtfChans;
+    al::vector<NfcFilter> mNfcChans;
+
     Voice() = default;
     Voice(const Voice&) = delete;
     ~Voice() { delete mUpdate.exchange(nullptr, std::memory_order_acq_rel); }
     Voice& operator=(const Voice&) = delete;
 
-    void mix(const State vstate, ALCcontext *Context, const ALuint SamplesToDo);
+    void mix(const State vstate, ALCcontext *Context, const MixBuffers &Buffers,
+        const ALuint SamplesToDo);
+
+    /**
+     * Allocates (or frees) and resets the HRTF and near-field filter state for
+     * the voice's channels, as needed by the device. This allocates, so it
+     * must not be called by the mixer.
+     */
+    void initDirectFilters(const ALCdevice *device);
 
     DEF_NEWDEL(Voice)
 };
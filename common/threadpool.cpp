@@ -0,0 +1,93 @@
+#include "config.h"
+
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "threads.h"
+
+
+namespace al {
+
+ThreadPool::ThreadPool(size_t count, const char *name)
+{
+    mThreads.reserve(count);
+    try {
+        for(size_t i{0};i < count;++i)
+            mThreads.emplace_back(std::mem_fn(&ThreadPool::workerProc), this, name);
+    }
+    catch(...) {
+        /* Keep whatever threads could be started. */
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> _{mLock};
+        mQuit = true;
+    }
+    mCond.notify_all();
+    for(auto &thrd : mThreads)
+        thrd.join();
+}
+
+FORCE_ALIGN void ThreadPool::workerProc(const char *name)
+{
+    althrd_setname(name);
+
+    std::unique_lock<std::mutex> lock{mLock};
+    while(true)
+    {
+        mCond.wait(lock, [this]() noexcept { return mQuit || !mTasks.empty(); });
+        if(mTasks.empty())
+            break;
+
+        std::function<void()> task{std::move(mTasks.front())};
+        mTasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> _{mLock};
+        mTasks.emplace_back(std::move(task));
+    }
+    mCond.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &func)
+{
+    if(count == 0) return;
+
+    std::atomic<size_t> next{0};
+    auto run_items = [&next,count,&func]() -> void
+    {
+        size_t idx;
+        while((idx=next.fetch_add(1, std::memory_order_relaxed)) < count)
+            func(idx);
+    };
+
+    /* The calling thread handles items too, so only use as many helpers as
+     * there are remaining items.
+     */
+    const size_t helpers{std::min(count-1, mThreads.size())};
+    semaphore done;
+    for(size_t i{0};i < helpers;++i)
+        push([&run_items,&done]() -> void { run_items(); done.post(); });
+
+    run_items();
+
+    /* Wait for the helpers to leave, since they reference the local state. */
+    for(size_t i{0};i < helpers;++i)
+        done.wait();
+}
+
+} // namespace al
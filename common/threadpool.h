@@ -0,0 +1,49 @@
+#ifndef AL_THREADPOOL_H
+#define AL_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace al {
+
+/* A simple fixed-size pool of worker threads. Tasks are run in the order they
+ * were pushed, by whichever worker is free first. This is not real-time safe;
+ * pushing a task may allocate and lock.
+ */
+class ThreadPool {
+    std::vector<std::thread> mThreads;
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<std::function<void()>> mTasks;
+    bool mQuit{false};
+
+    void workerProc(const char *name);
+
+public:
+    ThreadPool(size_t count, const char *name);
+    ThreadPool(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const noexcept { return mThreads.size(); }
+
+    void push(std::function<void()> task);
+
+    /**
+     * Calls func(i) for each i in [0...count), spread over the worker threads
+     * and the calling thread. Returns once all calls are done.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &func);
+};
+
+} // namespace al
+
+#endif /* AL_THREADPOOL_H */
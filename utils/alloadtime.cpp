@@ -0,0 +1,117 @@
+/*
+ * OpenAL Load Time Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Measures the start-up cost of the library: the time to load it (including
+ * its static initialization), and the time for the first loopback device to
+ * be opened and closed (including reading the config and initializing the
+ * backends). Only the first load in a process is meaningful, so run it
+ * repeatedly to get an average.
+ */
+
+#include "config.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "AL/alc.h"
+#include "AL/alext.h"
+
+#include "dynload.h"
+
+
+int main(int argc, char *argv[])
+{
+#ifndef HAVE_DYNLOAD
+    fprintf(stderr, "Dynamic library loading is not supported\n");
+    return 1;
+#else
+    using std::chrono::steady_clock;
+    using std::chrono::duration;
+
+#if defined(_WIN32)
+    const char *libname{"OpenAL32.dll"};
+#elif defined(__APPLE__)
+    const char *libname{"libopenal.1.dylib"};
+#else
+    const char *libname{"libopenal.so.1"};
+#endif
+
+    for(int i{1};i < argc;++i)
+    {
+        if(std::strcmp(argv[i], "-lib") == 0 && i+1 < argc)
+            libname = argv[++i];
+        else
+        {
+            printf("Usage: %s [-lib <library name>]\n\n"
+                "Reports the time taken to load the OpenAL library, and to open its first\n"
+                "device.\n", argv[0]);
+            return (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0)
+                ? 0 : 1;
+        }
+    }
+
+    const auto load_start = steady_clock::now();
+    void *handle{LoadLib(libname)};
+    const auto load_end = steady_clock::now();
+    if(!handle)
+    {
+        fprintf(stderr, "Failed to load %s\n", libname);
+        return 1;
+    }
+
+    auto getproc = reinterpret_cast<LPALCGETPROCADDRESS>(GetSymbol(handle, "alcGetProcAddress"));
+    auto closedevice = reinterpret_cast<LPALCCLOSEDEVICE>(GetSymbol(handle, "alcCloseDevice"));
+    if(!getproc || !closedevice)
+    {
+        fprintf(stderr, "Failed to get the ALC functions from %s\n", libname);
+        CloseLib(handle);
+        return 1;
+    }
+    auto loopbackopen = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(
+        getproc(nullptr, "alcLoopbackOpenDeviceSOFT"));
+    if(!loopbackopen)
+    {
+        fprintf(stderr, "ALC_SOFT_loopback not supported\n");
+        CloseLib(handle);
+        return 1;
+    }
+
+    const auto open_start = steady_clock::now();
+    ALCdevice *device{loopbackopen(nullptr)};
+    if(device) closedevice(device);
+    const auto open_end = steady_clock::now();
+    CloseLib(handle);
+
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return 1;
+    }
+
+    printf("Library load:      %8.3f ms\n",
+        duration<double,std::milli>{load_end - load_start}.count());
+    printf("First device open: %8.3f ms\n",
+        duration<double,std::milli>{open_end - open_start}.count());
+    return 0;
+#endif
+}
@@ -0,0 +1,740 @@
+/*
+ * OpenAL Mixer Benchmark Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Renders a configurable voice load on a loopback device as fast as possible,
+ * and reports how much CPU time the mixer needed. The load is rendered in
+ * stages (no voices playing, voices without sends, and voices with sends and
+ * effects), so the cost of each can be separated out.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "AL/alc.h"
+#include "AL/al.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+
+
+#ifndef M_PI
+#define M_PI    (3.14159265358979323846)
+#endif
+
+#define MAX_VOICE_SENDS 6
+
+/* ISO C doesn't allow casting the object pointers returned by the GetProcAddress
+ * functions to function pointers, so convert them through a union.
+ */
+#define FUNCTION_CAST(T, ptr) (((union { void *p; T f; }){ (ptr) }).f)
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+static LPALCISRENDERFORMATSUPPORTEDSOFT alcIsRenderFormatSupportedSOFT;
+static LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+static LPALGETSTRINGISOFT alGetStringiSOFT;
+
+static LPALGENEFFECTS alGenEffects;
+static LPALDELETEEFFECTS alDeleteEffects;
+static LPALEFFECTI alEffecti;
+static LPALGENAUXILIARYEFFECTSLOTS alGenAuxiliaryEffectSlots;
+static LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlots;
+static LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSloti;
+
+
+typedef struct BenchOptions {
+    ALCint frequency;
+    ALCenum outchans;
+    ALCint update_size;
+    ALCint hrtf; /* -1 = don't care */
+
+    int voices;
+    double seconds;
+
+    ALenum bufchans;
+    ALenum buftype;
+    ALsizei bufrate;
+
+    float pitch;
+    const char *resampler;
+    ALint spatialize;
+    int moving;
+
+    int sends;
+    ALenum effect;
+    const char *effect_name;
+
+    enum { OutText, OutJson, OutCsv } output;
+} BenchOptions;
+
+typedef struct StageResult {
+    const char *name;
+    int active;
+    double cpu_seconds;
+    double update_seconds;
+} StageResult;
+
+
+static const struct {
+    const char *name;
+    ALenum type;
+} EffectList[] = {
+    { "reverb", AL_EFFECT_REVERB },
+    { "eaxreverb", AL_EFFECT_EAXREVERB },
+    { "chorus", AL_EFFECT_CHORUS },
+    { "distortion", AL_EFFECT_DISTORTION },
+    { "echo", AL_EFFECT_ECHO },
+    { "flanger", AL_EFFECT_FLANGER },
+    { "fshifter", AL_EFFECT_FREQUENCY_SHIFTER },
+    { "vmorpher", AL_EFFECT_VOCAL_MORPHER },
+    { "pshifter", AL_EFFECT_PITCH_SHIFTER },
+    { "modulator", AL_EFFECT_RING_MODULATOR },
+    { "autowah", AL_EFFECT_AUTOWAH },
+    { "compressor", AL_EFFECT_COMPRESSOR },
+    { "equalizer", AL_EFFECT_EQUALIZER },
+};
+
+static const struct {
+    const char *name;
+    ALCenum chans;
+} OutChannelList[] = {
+    { "mono", ALC_MONO_SOFT },
+    { "stereo", ALC_STEREO_SOFT },
+    { "quad", ALC_QUAD_SOFT },
+    { "surround51", ALC_5POINT1_SOFT },
+    { "surround61", ALC_6POINT1_SOFT },
+    { "surround71", ALC_7POINT1_SOFT },
+};
+
+
+static void usage(const char *prog)
+{
+    size_t i;
+
+    printf("Usage: %s [options]\n\n", prog);
+    printf("Options:\n"
+        "  -voices <n>        Number of playing voices (default 64)\n"
+        "  -seconds <s>       Seconds of audio to render per stage (default 10)\n"
+        "  -freq <hz>         Device sample rate (default 48000)\n"
+        "  -outchans <name>   Device channels (default stereo):\n"
+        "                    ");
+    for(i = 0;i < sizeof(OutChannelList)/sizeof(OutChannelList[0]);i++)
+        printf(" %s", OutChannelList[i].name);
+    printf("\n"
+        "  -update <n>        Samples rendered per call (default 1024)\n"
+        "  -hrtf / -nohrtf    Request HRTF on or off (default: device decides)\n"
+        "  -bufchans <n>      Buffer channels, 1 or 2 (default 1)\n"
+        "  -buftype <type>    Buffer sample type: u8, s16, f32 (default s16)\n"
+        "  -bufrate <hz>      Buffer sample rate (default 44100)\n"
+        "  -pitch <p>         Source pitch (default 1.0)\n"
+        "  -resampler <name>  Source resampler, by name (default: device default)\n"
+        "  -nospatialize      Disable source spatialization\n"
+        "  -moving            Move every source before each render call\n"
+        "  -sends <n>         Auxiliary sends used by each voice (default 0)\n"
+        "  -effect <name>     Effect loaded in each send's slot (default reverb):\n"
+        "                    ");
+    for(i = 0;i < sizeof(EffectList)/sizeof(EffectList[0]);i++)
+        printf(" %s", EffectList[i].name);
+    printf("\n"
+        "  -json / -csv       Print machine-readable results\n\n"
+        "CPU time is measured with clock(), which is process CPU time on most systems.\n");
+}
+
+/* Case-insensitive string compare, so resampler names can be given as e.g.
+ * "cubic".
+ */
+static int NameMatches(const char *name, const char *str)
+{
+    while(*name && *str)
+    {
+        if(tolower((unsigned char)*name) != tolower((unsigned char)*str))
+            return 0;
+        ++name;
+        ++str;
+    }
+    return *name == *str;
+}
+
+static double cpu_now(void)
+{ return (double)clock() / CLOCKS_PER_SEC; }
+
+
+/* Creates a one second, full-scale white noise buffer in the requested
+ * format, so all samples are non-silent.
+ */
+static ALuint CreateNoiseBuffer(const BenchOptions *opts)
+{
+    const ALsizei frames = opts->bufrate;
+    const ALsizei chans = (opts->bufchans == 2) ? 2 : 1;
+    ALsizei samplesize, i;
+    ALuint seed = 22222u;
+    ALenum format = 0;
+    ALuint buffer = 0;
+    void *data;
+
+    switch(opts->buftype)
+    {
+    case AL_UNSIGNED_BYTE_SOFT:
+        samplesize = 1;
+        format = (chans == 1) ? AL_FORMAT_MONO8 : AL_FORMAT_STEREO8;
+        break;
+    case AL_SHORT_SOFT:
+        samplesize = 2;
+        format = (chans == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+        break;
+    default:
+        samplesize = 4;
+        format = (chans == 1) ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_STEREO_FLOAT32;
+        break;
+    }
+
+    data = malloc((size_t)(frames*chans*samplesize));
+    if(!data) return 0;
+
+    for(i = 0;i < frames*chans;i++)
+    {
+        float val;
+        seed = (seed*96314165u) + 907633515u;
+        val = (float)((double)seed/4294967296.0*2.0 - 1.0);
+        if(samplesize == 1)
+            ((unsigned char*)data)[i] = (unsigned char)(val*127.0f + 128.0f);
+        else if(samplesize == 2)
+            ((short*)data)[i] = (short)(val*32767.0f);
+        else
+            ((float*)data)[i] = val;
+    }
+
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, format, data, frames*chans*samplesize, opts->bufrate);
+    free(data);
+
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create buffer\n");
+        if(alIsBuffer(buffer))
+            alDeleteBuffers(1, &buffer);
+        return 0;
+    }
+    return buffer;
+}
+
+static void PlaceSource(ALuint source, int idx, double phase)
+{
+    /* Spread the sources around the listener, at varying distances. */
+    const double azi = (double)idx * 2.399963 + phase;
+    const double elev = sin((double)idx * 0.7) * 0.8;
+    const double dist = 1.0 + (double)(idx%10);
+
+    alSource3f(source, AL_POSITION, (ALfloat)(sin(azi)*cos(elev)*dist),
+        (ALfloat)(sin(elev)*dist), (ALfloat)(-cos(azi)*cos(elev)*dist));
+}
+
+/* Renders the given number of seconds, as fast as possible. */
+static void RunStage(ALCdevice *device, const BenchOptions *opts, const ALuint *sources,
+    void *outbuf, StageResult *result)
+{
+    const long total = (long)(opts->seconds * opts->frequency);
+    double update_time = 0.0;
+    double phase = 0.0;
+    double start;
+    long done = 0;
+    int i;
+
+    start = cpu_now();
+    while(done < total)
+    {
+        const ALCsizei todo = (ALCsizei)((total-done < opts->update_size) ? (total-done)
+            : opts->update_size);
+
+        if(opts->moving && sources)
+        {
+            const double ustart = cpu_now();
+            phase += 0.01;
+            for(i = 0;i < opts->voices;i++)
+                PlaceSource(sources[i], i, phase);
+            update_time += cpu_now() - ustart;
+        }
+
+        alcRenderSamplesSOFT(device, outbuf, todo);
+        done += todo;
+    }
+    result->cpu_seconds = cpu_now() - start;
+    result->update_seconds = update_time;
+}
+
+
+static int ParseArgs(int argc, char **argv, BenchOptions *opts)
+{
+    int i;
+    size_t j;
+
+    for(i = 1;i < argc;i++)
+    {
+        const char *arg = argv[i];
+        const char *val = (i+1 < argc) ? argv[i+1] : NULL;
+
+#define NEEDS_VALUE() do {                                                    \
+    if(!val) { fprintf(stderr, "Missing value for %s\n", arg); return 1; }   \
+    ++i;                                                                      \
+} while(0)
+        if(strcmp(arg, "-h") == 0 || strcmp(arg, "-help") == 0 || strcmp(arg, "--help") == 0)
+        {
+            usage(argv[0]);
+            exit(0);
+        }
+        else if(strcmp(arg, "-voices") == 0)
+        { NEEDS_VALUE(); opts->voices = atoi(val); }
+        else if(strcmp(arg, "-seconds") == 0)
+        { NEEDS_VALUE(); opts->seconds = atof(val); }
+        else if(strcmp(arg, "-freq") == 0)
+        { NEEDS_VALUE(); opts->frequency = atoi(val); }
+        else if(strcmp(arg, "-update") == 0)
+        { NEEDS_VALUE(); opts->update_size = atoi(val); }
+        else if(strcmp(arg, "-outchans") == 0)
+        {
+            NEEDS_VALUE();
+            for(j = 0;j < sizeof(OutChannelList)/sizeof(OutChannelList[0]);j++)
+            {
+                if(strcmp(val, OutChannelList[j].name) == 0)
+                    break;
+            }
+            if(j == sizeof(OutChannelList)/sizeof(OutChannelList[0]))
+            {
+                fprintf(stderr, "Unknown output channels: %s\n", val);
+                return 1;
+            }
+            opts->outchans = OutChannelList[j].chans;
+        }
+        else if(strcmp(arg, "-hrtf") == 0)
+            opts->hrtf = ALC_TRUE;
+        else if(strcmp(arg, "-nohrtf") == 0)
+            opts->hrtf = ALC_FALSE;
+        else if(strcmp(arg, "-bufchans") == 0)
+        { NEEDS_VALUE(); opts->bufchans = atoi(val); }
+        else if(strcmp(arg, "-buftype") == 0)
+        {
+            NEEDS_VALUE();
+            if(strcmp(val, "u8") == 0) opts->buftype = AL_UNSIGNED_BYTE_SOFT;
+            else if(strcmp(val, "s16") == 0) opts->buftype = AL_SHORT_SOFT;
+            else if(strcmp(val, "f32") == 0) opts->buftype = AL_FLOAT_SOFT;
+            else
+            {
+                fprintf(stderr, "Unknown buffer type: %s\n", val);
+                return 1;
+            }
+        }
+        else if(strcmp(arg, "-bufrate") == 0)
+        { NEEDS_VALUE(); opts->bufrate = atoi(val); }
+        else if(strcmp(arg, "-pitch") == 0)
+        { NEEDS_VALUE(); opts->pitch = (float)atof(val); }
+        else if(strcmp(arg, "-resampler") == 0)
+        { NEEDS_VALUE(); opts->resampler = val; }
+        else if(strcmp(arg, "-nospatialize") == 0)
+            opts->spatialize = AL_FALSE;
+        else if(strcmp(arg, "-moving") == 0)
+            opts->moving = 1;
+        else if(strcmp(arg, "-sends") == 0)
+        { NEEDS_VALUE(); opts->sends = atoi(val); }
+        else if(strcmp(arg, "-effect") == 0)
+        {
+            NEEDS_VALUE();
+            for(j = 0;j < sizeof(EffectList)/sizeof(EffectList[0]);j++)
+            {
+                if(strcmp(val, EffectList[j].name) == 0)
+                    break;
+            }
+            if(j == sizeof(EffectList)/sizeof(EffectList[0]))
+            {
+                fprintf(stderr, "Unknown effect: %s\n", val);
+                return 1;
+            }
+            opts->effect = EffectList[j].type;
+            opts->effect_name = EffectList[j].name;
+        }
+        else if(strcmp(arg, "-json") == 0)
+            opts->output = OutJson;
+        else if(strcmp(arg, "-csv") == 0)
+            opts->output = OutCsv;
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+#undef NEEDS_VALUE
+    }
+
+    if(opts->voices < 1 || opts->seconds <= 0.0 || opts->frequency < 8000 ||
+        opts->update_size < 1 || (opts->bufchans != 1 && opts->bufchans != 2) ||
+        opts->bufrate < 1 || !(opts->pitch > 0.0f) || opts->sends < 0 ||
+        opts->sends > MAX_VOICE_SENDS)
+    {
+        fprintf(stderr, "Invalid option value\n");
+        return 1;
+    }
+    return 0;
+}
+
+
+/* Prints the string as a quoted JSON string, escaping quotes, backslashes, and
+ * control characters.
+ */
+static void PrintJsonString(const char *str)
+{
+    putchar('"');
+    for(;str && *str;++str)
+    {
+        const unsigned char c = (unsigned char)*str;
+        if(c == '"' || c == '\\')
+            printf("\\%c", c);
+        else if(c == '\n')
+            fputs("\\n", stdout);
+        else if(c == '\r')
+            fputs("\\r", stdout);
+        else if(c == '\t')
+            fputs("\\t", stdout);
+        else if(c < 0x20)
+            printf("\\u%04x", c);
+        else
+            putchar(c);
+    }
+    putchar('"');
+}
+
+static void PrintJsonStringField(const char *name, const char *value)
+{
+    printf("  \"%s\": ", name);
+    PrintJsonString(value);
+    printf(",\n");
+}
+
+static void PrintResults(const BenchOptions *opts, const char *resampler, ALCint hrtf,
+    const StageResult *stages, size_t numstages)
+{
+    /* Costs are given as CPU milliseconds per second of rendered audio. */
+    double cost[3] = { 0.0, 0.0, 0.0 };
+    double voice_cost, send_cost, total_cpu, voice_secs_per_cpu;
+    size_t i;
+
+    for(i = 0;i < numstages;i++)
+    {
+        if(stages[i].active)
+            cost[i] = (stages[i].cpu_seconds - stages[i].update_seconds) / opts->seconds *
+                1000.0;
+    }
+    voice_cost = (cost[1] - cost[0]) / opts->voices;
+    send_cost = stages[2].active ? (cost[2] - cost[1]) : 0.0;
+
+    total_cpu = stages[2].active ? stages[2].cpu_seconds : stages[1].cpu_seconds;
+    total_cpu -= stages[2].active ? stages[2].update_seconds : stages[1].update_seconds;
+    voice_secs_per_cpu = (total_cpu > 0.0) ? (opts->voices * opts->seconds / total_cpu) : 0.0;
+
+    if(opts->output == OutJson)
+    {
+        printf("{\n");
+        PrintJsonStringField("renderer", alGetString(AL_RENDERER));
+        PrintJsonStringField("version", alGetString(AL_VERSION));
+        printf("  \"frequency\": %d,\n", opts->frequency);
+        printf("  \"update_size\": %d,\n", opts->update_size);
+        printf("  \"hrtf\": %s,\n", hrtf ? "true" : "false");
+        printf("  \"voices\": %d,\n", opts->voices);
+        printf("  \"seconds\": %g,\n", opts->seconds);
+        printf("  \"buffer_channels\": %d,\n", opts->bufchans);
+        printf("  \"buffer_rate\": %d,\n", opts->bufrate);
+        printf("  \"pitch\": %g,\n", opts->pitch);
+        PrintJsonStringField("resampler", resampler);
+        printf("  \"spatialize\": %s,\n", opts->spatialize ? "true" : "false");
+        printf("  \"moving\": %s,\n", opts->moving ? "true" : "false");
+        printf("  \"sends\": %d,\n", opts->sends);
+        PrintJsonStringField("effect", opts->sends ? opts->effect_name : "none");
+        printf("  \"stages\": {\n");
+        for(i = 0;i < numstages;i++)
+        {
+            if(!stages[i].active) continue;
+            printf("    \"%s\": { \"cpu_seconds\": %.6f, \"update_seconds\": %.6f, "
+                "\"cpu_ms_per_second\": %.4f }%s\n", stages[i].name, stages[i].cpu_seconds,
+                stages[i].update_seconds, cost[i],
+                (i+1 < numstages && stages[i+1].active) ? "," : "");
+        }
+        printf("  },\n");
+        printf("  \"base_ms_per_second\": %.4f,\n", cost[0]);
+        printf("  \"voice_ms_per_second\": %.6f,\n", voice_cost);
+        printf("  \"sends_effects_ms_per_second\": %.4f,\n", send_cost);
+        printf("  \"voice_seconds_per_cpu_second\": %.2f\n", voice_secs_per_cpu);
+        printf("}\n");
+    }
+    else if(opts->output == OutCsv)
+    {
+        printf("frequency,update_size,hrtf,voices,seconds,buffer_channels,buffer_rate,pitch,"
+            "resampler,spatialize,moving,sends,effect,base_ms_per_second,voice_ms_per_second,"
+            "sends_effects_ms_per_second,voice_seconds_per_cpu_second\n");
+        printf("%d,%d,%d,%d,%g,%d,%d,%g,%s,%d,%d,%d,%s,%.4f,%.6f,%.4f,%.2f\n", opts->frequency,
+            opts->update_size, hrtf ? 1 : 0, opts->voices, opts->seconds, opts->bufchans,
+            opts->bufrate, opts->pitch, resampler, opts->spatialize ? 1 : 0, opts->moving,
+            opts->sends, opts->sends ? opts->effect_name : "none", cost[0], voice_cost,
+            send_cost, voice_secs_per_cpu);
+    }
+    else
+    {
+        printf("Renderer: %s (%s)\n", alGetString(AL_RENDERER), alGetString(AL_VERSION));
+        printf("Device: %dhz, %d sample updates, HRTF %s\n", opts->frequency,
+            opts->update_size, hrtf ? "on" : "off");
+        printf("Voices: %d x %dch %dhz, pitch %g, resampler %s, %sspatialized%s\n",
+            opts->voices, opts->bufchans, opts->bufrate, opts->pitch, resampler,
+            opts->spatialize ? "" : "not ", opts->moving ? ", moving" : "");
+        if(opts->sends)
+            printf("Sends: %d per voice, to %s\n", opts->sends, opts->effect_name);
+        printf("\n");
+        for(i = 0;i < numstages;i++)
+        {
+            if(!stages[i].active) continue;
+            printf("  %-8s %8.3f cpu ms per audio second\n", stages[i].name, cost[i]);
+        }
+        printf("\n");
+        printf("  Per voice:     %10.4f cpu ms per audio second\n", voice_cost);
+        if(opts->sends)
+            printf("  Sends/effects: %10.4f cpu ms per audio second\n", send_cost);
+        printf("  Throughput:    %10.2f voice-seconds per cpu second\n", voice_secs_per_cpu);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts = {
+        48000, ALC_STEREO_SOFT, 1024, -1,
+        64, 10.0,
+        1, AL_SHORT_SOFT, 44100,
+        1.0f, NULL, AL_TRUE, 0,
+        0, AL_EFFECT_REVERB, "reverb",
+        OutText
+    };
+    StageResult stages[3] = {
+        { "base", 1, 0.0, 0.0 },
+        { "dry", 1, 0.0, 0.0 },
+        { "wet", 0, 0.0, 0.0 },
+    };
+    ALuint slots[MAX_VOICE_SENDS] = { 0 };
+    ALuint effects[MAX_VOICE_SENDS] = { 0 };
+    const char *resampler_name = "default";
+    ALCdevice *device = NULL;
+    ALCcontext *context = NULL;
+    ALuint *sources = NULL;
+    ALCint attrs[16], hrtf = 0;
+    void *outbuf = NULL;
+    ALuint buffer = 0;
+    int ret = 1;
+    int i, n;
+
+    if(ParseArgs(argc, argv, &opts) != 0)
+        return 1;
+
+    if(!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "Error: ALC_SOFT_loopback not supported!\n");
+        return 1;
+    }
+
+#define LOAD_PROC(T, x)  ((x) = FUNCTION_CAST(T, alcGetProcAddress(NULL, #x)))
+    LOAD_PROC(LPALCLOOPBACKOPENDEVICESOFT, alcLoopbackOpenDeviceSOFT);
+    LOAD_PROC(LPALCISRENDERFORMATSUPPORTEDSOFT, alcIsRenderFormatSupportedSOFT);
+    LOAD_PROC(LPALCRENDERSAMPLESSOFT, alcRenderSamplesSOFT);
+#undef LOAD_PROC
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return 1;
+    }
+    if(!alcIsRenderFormatSupportedSOFT(device, opts.frequency, opts.outchans, ALC_FLOAT_SOFT))
+    {
+        fprintf(stderr, "Render format not supported\n");
+        goto done;
+    }
+
+    n = 0;
+    attrs[n++] = ALC_FREQUENCY; attrs[n++] = opts.frequency;
+    attrs[n++] = ALC_FORMAT_CHANNELS_SOFT; attrs[n++] = opts.outchans;
+    attrs[n++] = ALC_FORMAT_TYPE_SOFT; attrs[n++] = ALC_FLOAT_SOFT;
+    attrs[n++] = ALC_MONO_SOURCES; attrs[n++] = opts.voices;
+    attrs[n++] = ALC_STEREO_SOURCES; attrs[n++] = opts.voices;
+    attrs[n++] = ALC_MAX_AUXILIARY_SENDS; attrs[n++] = opts.sends;
+    if(opts.hrtf >= 0)
+    {
+        attrs[n++] = ALC_HRTF_SOFT;
+        attrs[n++] = opts.hrtf;
+    }
+    attrs[n] = 0;
+
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to create context\n");
+        goto done;
+    }
+    alcGetIntegerv(device, ALC_HRTF_SOFT, 1, &hrtf);
+
+    if(opts.sends > 0)
+    {
+        ALCint maxsends = 0;
+        alcGetIntegerv(device, ALC_MAX_AUXILIARY_SENDS, 1, &maxsends);
+        if(maxsends < opts.sends)
+        {
+            fprintf(stderr, "Only %d sends available\n", maxsends);
+            goto done;
+        }
+
+#define LOAD_PROC(T, x)  ((x) = FUNCTION_CAST(T, alGetProcAddress(#x)))
+        LOAD_PROC(LPALGENEFFECTS, alGenEffects);
+        LOAD_PROC(LPALDELETEEFFECTS, alDeleteEffects);
+        LOAD_PROC(LPALEFFECTI, alEffecti);
+        LOAD_PROC(LPALGENAUXILIARYEFFECTSLOTS, alGenAuxiliaryEffectSlots);
+        LOAD_PROC(LPALDELETEAUXILIARYEFFECTSLOTS, alDeleteAuxiliaryEffectSlots);
+        LOAD_PROC(LPALAUXILIARYEFFECTSLOTI, alAuxiliaryEffectSloti);
+#undef LOAD_PROC
+
+        alGenEffects(opts.sends, effects);
+        alGenAuxiliaryEffectSlots(opts.sends, slots);
+        for(i = 0;i < opts.sends;i++)
+            alEffecti(effects[i], AL_EFFECT_TYPE, opts.effect);
+        if(alGetError() != AL_NO_ERROR)
+        {
+            fprintf(stderr, "Failed to set up %s effect slots\n", opts.effect_name);
+            goto done;
+        }
+        stages[2].active = 1;
+    }
+
+    buffer = CreateNoiseBuffer(&opts);
+    if(!buffer) goto done;
+
+    sources = calloc((size_t)opts.voices, sizeof(*sources));
+    outbuf = malloc((size_t)opts.update_size * 8 * sizeof(float));
+    if(!sources || !outbuf)
+    {
+        fprintf(stderr, "Out of memory\n");
+        goto done;
+    }
+
+    alGenSources(opts.voices, sources);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create %d sources\n", opts.voices);
+        goto done;
+    }
+
+    if(opts.resampler)
+    {
+        ALint numresamplers = 0, r;
+        if(!alIsExtensionPresent("AL_SOFT_source_resampler"))
+        {
+            fprintf(stderr, "AL_SOFT_source_resampler not supported\n");
+            goto done;
+        }
+        alGetStringiSOFT = FUNCTION_CAST(LPALGETSTRINGISOFT,
+            alGetProcAddress("alGetStringiSOFT"));
+        numresamplers = alGetInteger(AL_NUM_RESAMPLERS_SOFT);
+        for(r = 0;r < numresamplers;r++)
+        {
+            const ALchar *name = alGetStringiSOFT(AL_RESAMPLER_NAME_SOFT, r);
+            if(NameMatches(name, opts.resampler))
+                break;
+        }
+        if(r == numresamplers)
+        {
+            fprintf(stderr, "Resampler \"%s\" not found. Available:\n", opts.resampler);
+            for(r = 0;r < numresamplers;r++)
+                fprintf(stderr, "  %s\n", alGetStringiSOFT(AL_RESAMPLER_NAME_SOFT, r));
+            goto done;
+        }
+        resampler_name = opts.resampler;
+        for(i = 0;i < opts.voices;i++)
+            alSourcei(sources[i], AL_SOURCE_RESAMPLER_SOFT, r);
+    }
+
+    for(i = 0;i < opts.voices;i++)
+    {
+        alSourcei(sources[i], AL_BUFFER, (ALint)buffer);
+        alSourcei(sources[i], AL_LOOPING, AL_TRUE);
+        alSourcef(sources[i], AL_PITCH, opts.pitch);
+        alSourcei(sources[i], AL_SOURCE_SPATIALIZE_SOFT, opts.spatialize);
+        /* Start each voice at a different offset. */
+        alSourcei(sources[i], AL_SAMPLE_OFFSET, (i*7919) % opts.bufrate);
+        PlaceSource(sources[i], i, 0.0);
+    }
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to set up sources\n");
+        goto done;
+    }
+
+    /* Stage 1: Nothing playing, measuring the fixed per-device cost. */
+    RunStage(device, &opts, NULL, outbuf, &stages[0]);
+
+    /* Stage 2: All voices playing without sends. */
+    alSourcePlayv(opts.voices, sources);
+    RunStage(device, &opts, sources, outbuf, &stages[1]);
+
+    /* Stage 3: All voices playing with sends to the effect slots. The effects
+     * are only loaded now, so the earlier stages don't include their cost.
+     */
+    if(stages[2].active)
+    {
+        for(n = 0;n < opts.sends;n++)
+            alAuxiliaryEffectSloti(slots[n], AL_EFFECTSLOT_EFFECT, (ALint)effects[n]);
+        for(i = 0;i < opts.voices;i++)
+        {
+            for(n = 0;n < opts.sends;n++)
+                alSource3i(sources[i], AL_AUXILIARY_SEND_FILTER, (ALint)slots[n], n,
+                    AL_FILTER_NULL);
+        }
+        RunStage(device, &opts, sources, outbuf, &stages[2]);
+    }
+
+    PrintResults(&opts, resampler_name, hrtf, stages, 3);
+    ret = 0;
+
+done:
+    if(sources)
+    {
+        alSourceStopv(opts.voices, sources);
+        alDeleteSources(opts.voices, sources);
+        free(sources);
+    }
+    if(buffer)
+        alDeleteBuffers(1, &buffer);
+    if(slots[0])
+        alDeleteAuxiliaryEffectSlots(opts.sends, slots);
+    if(effects[0])
+        alDeleteEffects(opts.sends, effects);
+    free(outbuf);
+
+    alcMakeContextCurrent(NULL);
+    if(context)
+        alcDestroyContext(context);
+    alcCloseDevice(device);
+
+    return ret;
+}
@@ -0,0 +1,638 @@
+/*
+ * OpenAL Mixer Kernel Check Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Checks a few behaviors of the library's mixer as a whole, by rendering
+ * through loopback devices.
+ */
+
+#include "almixercheck-loopback.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "AL/alc.h"
+#include "AL/al.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+
+#include "inprogext.h"
+
+
+namespace {
+
+/* The most samples the library mixes at once. */
+constexpr size_t MixLen{1024};
+
+/* The library reads its config once, when it's first used, so the options
+ * these checks need are written to a temporary config file before then.
+ */
+constexpr char LoopbackConfig[]{
+    "[general]\n"
+    "source-update-thread = true\n"
+    "context-threads = 1\n"
+    "idle-timeout = 0\n"
+    "output-limiter = false\n"
+    "\n"
+    "[reverb]\n"
+    "late-rate = 40000\n"
+};
+
+bool gFailed{false};
+std::mt19937 gRng;
+
+LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+
+LPALGENEFFECTS alGenEffects;
+LPALDELETEEFFECTS alDeleteEffects;
+LPALEFFECTI alEffecti;
+LPALEFFECTF alEffectf;
+LPALGENFILTERS alGenFilters;
+LPALDELETEFILTERS alDeleteFilters;
+LPALFILTERI alFilteri;
+LPALFILTERF alFilterf;
+LPALGENAUXILIARYEFFECTSLOTS alGenAuxiliaryEffectSlots;
+LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlots;
+LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSloti;
+LPALGENBUSESSOFT alGenBusesSOFT;
+LPALDELETEBUSESSOFT alDeleteBusesSOFT;
+
+
+std::string WriteConfig()
+{
+#ifdef _WIN32
+    const char *tmpdir{std::getenv("TEMP")};
+    std::string path{std::string{tmpdir ? tmpdir : "."} + "\\almixercheck.conf"};
+#else
+    const char *tmpdir{std::getenv("TMPDIR")};
+    std::string path{std::string{tmpdir ? tmpdir : "/tmp"} + "/almixercheck.conf"};
+#endif
+
+    FILE *f{fopen(path.c_str(), "w")};
+    if(!f)
+    {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+        return std::string{};
+    }
+    fputs(LoopbackConfig, f);
+    fclose(f);
+
+#ifdef _WIN32
+    if(_putenv_s("ALSOFT_CONF", path.c_str()) != 0)
+#else
+    if(setenv("ALSOFT_CONF", path.c_str(), 1) != 0)
+#endif
+    {
+        std::remove(path.c_str());
+        return std::string{};
+    }
+    return path;
+}
+
+bool LoadProcs()
+{
+#define LOAD_PROC(T, x)  ((x) = reinterpret_cast<T>(alcGetProcAddress(nullptr, #x)))
+    LOAD_PROC(LPALCLOOPBACKOPENDEVICESOFT, alcLoopbackOpenDeviceSOFT);
+    LOAD_PROC(LPALCRENDERSAMPLESSOFT, alcRenderSamplesSOFT);
+#undef LOAD_PROC
+#define LOAD_PROC(T, x)  ((x) = reinterpret_cast<T>(alGetProcAddress(#x)))
+    LOAD_PROC(LPALGENEFFECTS, alGenEffects);
+    LOAD_PROC(LPALDELETEEFFECTS, alDeleteEffects);
+    LOAD_PROC(LPALEFFECTI, alEffecti);
+    LOAD_PROC(LPALEFFECTF, alEffectf);
+    LOAD_PROC(LPALGENFILTERS, alGenFilters);
+    LOAD_PROC(LPALDELETEFILTERS, alDeleteFilters);
+    LOAD_PROC(LPALFILTERI, alFilteri);
+    LOAD_PROC(LPALFILTERF, alFilterf);
+    LOAD_PROC(LPALGENAUXILIARYEFFECTSLOTS, alGenAuxiliaryEffectSlots);
+    LOAD_PROC(LPALDELETEAUXILIARYEFFECTSLOTS, alDeleteAuxiliaryEffectSlots);
+    LOAD_PROC(LPALAUXILIARYEFFECTSLOTI, alAuxiliaryEffectSloti);
+    LOAD_PROC(LPALGENBUSESSOFT, alGenBusesSOFT);
+    LOAD_PROC(LPALDELETEBUSESSOFT, alDeleteBusesSOFT);
+#undef LOAD_PROC
+
+    return alcLoopbackOpenDeviceSOFT && alcRenderSamplesSOFT && alGenEffects && alDeleteEffects
+        && alEffecti && alEffectf && alGenFilters && alDeleteFilters && alFilteri && alFilterf
+        && alGenAuxiliaryEffectSlots && alDeleteAuxiliaryEffectSlots && alAuxiliaryEffectSloti
+        && alGenBusesSOFT && alDeleteBusesSOFT;
+}
+
+
+/* A stereo float loopback device, with its context made current. */
+class LoopbackDevice {
+    ALCdevice *mDevice{nullptr};
+    ALCcontext *mContext{nullptr};
+
+public:
+    LoopbackDevice(ALCint rate)
+    {
+        mDevice = alcLoopbackOpenDeviceSOFT(nullptr);
+        if(!mDevice) return;
+
+        const ALCint attrs[]{
+            ALC_FREQUENCY, rate,
+            ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+            ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+            ALC_MAX_AUXILIARY_SENDS, 2,
+            0};
+        mContext = alcCreateContext(mDevice, attrs);
+        if(mContext) alcMakeContextCurrent(mContext);
+    }
+    ~LoopbackDevice()
+    {
+        if(mContext)
+        {
+            alcMakeContextCurrent(nullptr);
+            alcDestroyContext(mContext);
+        }
+        if(mDevice)
+            alcCloseDevice(mDevice);
+    }
+
+    explicit operator bool() const noexcept { return mContext != nullptr; }
+
+    /* Renders the given number of stereo frames, one mix at a time. */
+    void render(float *output, size_t frames)
+    {
+        while(frames > 0)
+        {
+            const size_t todo{std::min(frames, MixLen)};
+            alcRenderSamplesSOFT(mDevice, output, static_cast<ALCsizei>(todo));
+            output += todo*2;
+            frames -= todo;
+        }
+    }
+};
+
+
+void FillRandom(float *data, size_t count, float scale)
+{
+    std::uniform_real_distribution<float> dist{-scale, scale};
+    std::generate_n(data, count, [&dist]() -> float { return dist(gRng); });
+}
+
+float RmsLevel(const float *data, size_t count)
+{
+    double sum{0.0};
+    for(size_t i{0};i < count;++i)
+        sum += static_cast<double>(data[i]) * static_cast<double>(data[i]);
+    return static_cast<float>(std::sqrt(sum / static_cast<double>(std::max<size_t>(count, 1))));
+}
+
+void Report(const char *check, const char *config, const char *result, bool ok)
+{
+    printf("  %-14s %-22s %-38s %s\n", check, config, result, ok ? "ok" : "FAILED");
+    if(!ok) gFailed = true;
+}
+
+
+/* Changes a playing source's send slot or direct bus, deletes the old one, and
+ * keeps rendering. The voice has to use the new target starting with the very
+ * next mix, even with the source update thread, since the old one is freed as
+ * soon as the current mix is done. Otherwise that mix's output is lost (being
+ * written to freed memory).
+ */
+void CheckRetarget()
+{
+    constexpr ALCint SampleRate{48000};
+
+    LoopbackDevice loopback{SampleRate};
+    if(!loopback)
+    {
+        Report("Retarget", "loopback", "failed to open device", false);
+        return;
+    }
+
+    std::vector<float> noise(SampleRate/4);
+    FillRandom(noise.data(), noise.size(), 0.5f);
+    ALuint buffer{};
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO_FLOAT32, noise.data(),
+        static_cast<ALsizei>(noise.size()*sizeof(float)), SampleRate);
+
+    /* The send slots use the dedicated dialog effect, which passes its input
+     * through with no delay.
+     */
+    ALuint effect{}, filter{};
+    alGenEffects(1, &effect);
+    alEffecti(effect, AL_EFFECT_TYPE, AL_EFFECT_DEDICATED_DIALOGUE);
+    alGenFilters(1, &filter);
+    alFilteri(filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+    alFilterf(filter, AL_LOWPASS_GAIN, 0.0f);
+
+    enum class Target { Slot, Bus };
+    for(const Target target : {Target::Slot, Target::Bus})
+    {
+        ALuint source{}, slots[2]{}, bus{};
+        alGenSources(1, &source);
+        alSourcei(source, AL_BUFFER, static_cast<ALint>(buffer));
+        alSourcei(source, AL_LOOPING, AL_TRUE);
+        alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+        if(target == Target::Slot)
+        {
+            /* Only feed the source to the send slot. */
+            alGenAuxiliaryEffectSlots(2, slots);
+            for(const ALuint slot : slots)
+                alAuxiliaryEffectSloti(slot, AL_EFFECTSLOT_EFFECT, static_cast<ALint>(effect));
+            alSourcei(source, AL_DIRECT_FILTER, static_cast<ALint>(filter));
+            alSource3i(source, AL_AUXILIARY_SEND_FILTER, static_cast<ALint>(slots[0]), 0,
+                AL_FILTER_NULL);
+        }
+        else
+        {
+            alGenBusesSOFT(1, &bus);
+            alSourcei(source, AL_DIRECT_BUS_SOFT, static_cast<ALint>(bus));
+        }
+        alSourcePlay(source);
+
+        std::vector<float> output(MixLen*2 * 4);
+        loopback.render(output.data(), MixLen*3);
+        const float before{RmsLevel(&output[MixLen*2 * 2], MixLen*2)};
+
+        /* Switch to the other slot, or directly to the output, and delete the
+         * old one right away.
+         */
+        if(target == Target::Slot)
+        {
+            alSource3i(source, AL_AUXILIARY_SEND_FILTER, static_cast<ALint>(slots[1]), 0,
+                AL_FILTER_NULL);
+            alDeleteAuxiliaryEffectSlots(1, &slots[0]);
+        }
+        else
+        {
+            alSourcei(source, AL_DIRECT_BUS_SOFT, 0);
+            alDeleteBusesSOFT(1, &bus);
+        }
+        const ALenum err{alGetError()};
+        loopback.render(&output[MixLen*2 * 3], MixLen);
+        const float after{RmsLevel(&output[MixLen*2 * 3], MixLen*2)};
+
+        /* The level shouldn't drop for the first mix after the switch. */
+        const float level{20.0f * std::log10(std::max(after, 1e-9f) / std::max(before, 1e-9f))};
+        char result[64];
+        snprintf(result, sizeof(result), "next mix level %+.1f dB", static_cast<double>(level));
+        Report("Retarget", (target == Target::Slot) ? "send slot" : "direct bus", result,
+            err == AL_NO_ERROR && before > 0.01f && level > -3.0f);
+
+        alDeleteSources(1, &source);
+        if(target == Target::Slot)
+            alDeleteAuxiliaryEffectSlots(1, &slots[1]);
+    }
+
+    alDeleteFilters(1, &filter);
+    alDeleteEffects(1, &effect);
+    alDeleteBuffers(1, &buffer);
+}
+
+
+/* Renders a band-limited impulse through an EAX reverb at device rates just
+ * below and at the rates where the late reverb is processed at half and a
+ * quarter of the device rate (given the config's late-rate of 40khz). The
+ * reduced-rate responses need to match the ones processed at the rate above
+ * them in overall level and in decay time, measured from the Schroeder
+ * integral.
+ */
+void CheckReverbRate()
+{
+    constexpr ALsizei ImpulseRate{48000};
+    constexpr float DecayTime{2.0f};
+    constexpr float LevelTolerance{0.5f}; /* dB */
+    constexpr float DecayTolerance{0.05f}; /* Relative */
+
+    /* A windowed sinc pulse, cut off at 8khz so it's well within the reduced
+     * rate's bandwidth.
+     */
+    std::vector<float> impulse(ImpulseRate/20, 0.0f);
+    constexpr int Half{32};
+    for(int i{-Half};i <= Half;++i)
+    {
+        constexpr double pi{3.14159265358979323846};
+        constexpr double cutoff{8000.0 / ImpulseRate};
+        const double x{2.0*cutoff*i};
+        const double sinc{(i == 0) ? 1.0 : std::sin(pi*x) / (pi*x)};
+        const double window{0.5 + 0.5*std::cos(pi*i/(Half+1))};
+        impulse[static_cast<size_t>(Half+i)] = static_cast<float>(2.0*cutoff * sinc * window);
+    }
+
+    struct Response {
+        float level; /* dB */
+        float decay; /* T60, in seconds */
+    };
+    auto render = [&impulse](const ALCint rate, Response &response) -> bool
+    {
+        LoopbackDevice loopback{rate};
+        if(!loopback) return false;
+
+        ALuint buffer{}, effect{}, filter{}, slot{}, source{};
+        alGenBuffers(1, &buffer);
+        alBufferData(buffer, AL_FORMAT_MONO_FLOAT32, impulse.data(),
+            static_cast<ALsizei>(impulse.size()*sizeof(float)), ImpulseRate);
+        alGenEffects(1, &effect);
+        alEffecti(effect, AL_EFFECT_TYPE, AL_EFFECT_EAXREVERB);
+        alEffectf(effect, AL_EAXREVERB_DECAY_TIME, DecayTime);
+        alGenAuxiliaryEffectSlots(1, &slot);
+        alAuxiliaryEffectSloti(slot, AL_EFFECTSLOT_EFFECT, static_cast<ALint>(effect));
+        alGenFilters(1, &filter);
+        alFilteri(filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+        alFilterf(filter, AL_LOWPASS_GAIN, 0.0f);
+
+        alGenSources(1, &source);
+        alSourcei(source, AL_BUFFER, static_cast<ALint>(buffer));
+        alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+        alSourcei(source, AL_DIRECT_FILTER, static_cast<ALint>(filter));
+        alSource3i(source, AL_AUXILIARY_SEND_FILTER, static_cast<ALint>(slot), 0,
+            AL_FILTER_NULL);
+        alSourcePlay(source);
+
+        /* Render twice the decay time, and sum the energy of both channels. */
+        const auto frames = static_cast<size_t>(static_cast<float>(rate) * DecayTime * 2.0f);
+        std::vector<float> output(frames*2);
+        loopback.render(output.data(), frames);
+
+        alDeleteSources(1, &source);
+        alDeleteAuxiliaryEffectSlots(1, &slot);
+        alDeleteFilters(1, &filter);
+        alDeleteEffects(1, &effect);
+        alDeleteBuffers(1, &buffer);
+        if(alGetError() != AL_NO_ERROR)
+            return false;
+
+        std::vector<double> edc(frames+1, 0.0);
+        for(size_t i{frames};i > 0;--i)
+        {
+            const double l{output[(i-1)*2]}, r{output[(i-1)*2 + 1]};
+            edc[i-1] = edc[i] + l*l + r*r;
+        }
+        if(!(edc[0] > 0.0))
+            return false;
+        response.level = static_cast<float>(10.0 * std::log10(edc[0] / static_cast<double>(frames)));
+
+        /* Take the decay time from where the integral goes from -5dB to -35dB
+         * (i.e. T30).
+         */
+        auto crossing = [&edc](const double db) -> double
+        {
+            const double target{edc[0] * std::pow(10.0, db/10.0)};
+            auto iter = std::find_if(edc.cbegin(), edc.cend(),
+                [target](const double e) noexcept { return e < target; });
+            return static_cast<double>(iter - edc.cbegin());
+        };
+        response.decay = static_cast<float>((crossing(-35.0) - crossing(-5.0)) * 2.0 / rate);
+        return true;
+    };
+
+    struct RatePair {
+        const char *name;
+        ALCint refrate, rate;
+    };
+    static constexpr RatePair Pairs[]{
+        {"80khz half rate", 79999, 80000},
+        {"160khz quarter rate", 159999, 160000},
+    };
+    for(const RatePair &pair : Pairs)
+    {
+        Response ref{}, test{};
+        if(!render(pair.refrate, ref) || !render(pair.rate, test))
+        {
+            Report("Reverb", pair.name, "failed to render", false);
+            continue;
+        }
+
+        const float leveldiff{test.level - ref.level};
+        const float decayerr{std::fabs(test.decay - ref.decay) / ref.decay};
+        char result[64];
+        snprintf(result, sizeof(result), "level %+.2f dB, T60 %.2fs vs %.2fs",
+            static_cast<double>(leveldiff), static_cast<double>(test.decay),
+            static_cast<double>(ref.decay));
+        Report("Reverb", pair.name, result,
+            std::fabs(leveldiff) <= LevelTolerance && decayerr <= DecayTolerance);
+    }
+}
+
+
+/* The autowah as it was before its per-sample cos/sin calls were replaced by
+ * a table, and its filter coefficients re-derived with divides for each
+ * channel. It processes one channel, which also drives the envelope.
+ */
+class ReferenceAutowah {
+    static constexpr float MinFreq{20.0f};
+    static constexpr float MaxFreq{2500.0f};
+    static constexpr float QFactor{5.0f};
+
+    float mAttackRate;
+    float mReleaseRate;
+    float mResonanceGain;
+    float mPeakGain;
+    float mFreqMinNorm;
+    float mBandwidthNorm;
+
+    float mEnvDelay{0.0f};
+    float mZ1{0.0f}, mZ2{0.0f};
+
+public:
+    ReferenceAutowah(float rate, float attack, float release, float resonance, float peakgain)
+    {
+        const float ReleaseTime{std::min(std::max(release, 0.001f), 1.0f)};
+
+        mAttackRate    = std::exp(-1.0f / (attack*rate));
+        mReleaseRate   = std::exp(-1.0f / (ReleaseTime*rate));
+        mResonanceGain = std::sqrt(std::log10(resonance)*10.0f / 3.0f);
+        mPeakGain      = 1.0f - std::log10(peakgain/AL_AUTOWAH_MAX_PEAK_GAIN);
+        mFreqMinNorm   = MinFreq / rate;
+        mBandwidthNorm = (MaxFreq-MinFreq) / rate;
+    }
+
+    void process(const float *input, float *output, size_t count)
+    {
+        constexpr float tau{6.28318530717958647692f};
+        const float res_gain{mResonanceGain};
+        for(size_t i{0};i < count;++i)
+        {
+            const float sample{mPeakGain * std::fabs(input[i])};
+            const float rate{(sample > mEnvDelay) ? mAttackRate : mReleaseRate};
+            mEnvDelay = sample + (mEnvDelay-sample)*rate;
+
+            const float w0{std::min(mBandwidthNorm*mEnvDelay + mFreqMinNorm, 0.46f) * tau};
+            const float cos_w0{std::cos(w0)};
+            const float alpha{std::sin(w0)/(2.0f * QFactor)};
+
+            float a[3], b[3];
+            b[0] =  1.0f + alpha*res_gain;
+            b[1] = -2.0f * cos_w0;
+            b[2] =  1.0f - alpha*res_gain;
+            a[0] =  1.0f + alpha/res_gain;
+            a[1] = -2.0f * cos_w0;
+            a[2] =  1.0f - alpha/res_gain;
+
+            const float in{input[i]};
+            const float out{in*(b[0]/a[0]) + mZ1};
+            mZ1 = in*(b[1]/a[0]) - out*(a[1]/a[0]) + mZ2;
+            mZ2 = in*(b[2]/a[0]) - out*(a[2]/a[0]);
+            output[i] = out;
+        }
+    }
+};
+
+/* Renders a sine sweep with a varying level through the autowah, and compares
+ * it with the reference. The effect's input is the source's signal scaled for
+ * each ambisonic channel, and the filter is the same for each, so each output
+ * channel is the reference's output times a constant (found by least
+ * squares). The first mix is skipped, since the effect's output gains fade in
+ * over it.
+ */
+void CheckAutowah()
+{
+    constexpr ALCint SampleRate{48000};
+    constexpr size_t NumFrames{SampleRate*2};
+    constexpr float Tolerance{-80.0f}; /* dB, error relative to the signal */
+
+    /* A logarithmic sweep from 40hz to 8khz, with its level going between
+     * -34dB and 0dB a few times a second to move the wah's envelope.
+     */
+    std::vector<float> sweep(NumFrames);
+    for(size_t i{0};i < NumFrames;++i)
+    {
+        constexpr double pi{3.14159265358979323846};
+        constexpr double f0{40.0}, f1{8000.0};
+        constexpr double duration{static_cast<double>(NumFrames) / SampleRate};
+        const double t{static_cast<double>(i) / SampleRate};
+        const double k{std::log(f1/f0)};
+        const double phase{2.0*pi * f0*duration/k * (std::exp(t/duration*k) - 1.0)};
+        const double env{std::sin(pi * 2.5 * t)};
+        sweep[i] = static_cast<float>(std::sin(phase) * (0.02 + 0.98*env*env));
+    }
+
+    struct WahConfig {
+        const char *name;
+        float attack, release, resonance, peakgain;
+    };
+    static constexpr WahConfig Configs[]{
+        {"default", AL_AUTOWAH_DEFAULT_ATTACK_TIME, AL_AUTOWAH_DEFAULT_RELEASE_TIME,
+            AL_AUTOWAH_DEFAULT_RESONANCE, AL_AUTOWAH_DEFAULT_PEAK_GAIN},
+        {"fast, high peak", 0.001f, 0.01f, 100.0f, 1000.0f},
+    };
+    for(const WahConfig &cfg : Configs)
+    {
+        LoopbackDevice loopback{SampleRate};
+        if(!loopback)
+        {
+            Report("Autowah", cfg.name, "failed to open device", false);
+            continue;
+        }
+
+        ALuint buffer{}, effect{}, filter{}, slot{}, source{};
+        alGenBuffers(1, &buffer);
+        alBufferData(buffer, AL_FORMAT_MONO_FLOAT32, sweep.data(),
+            static_cast<ALsizei>(sweep.size()*sizeof(float)), SampleRate);
+        alGenEffects(1, &effect);
+        alEffecti(effect, AL_EFFECT_TYPE, AL_EFFECT_AUTOWAH);
+        alEffectf(effect, AL_AUTOWAH_ATTACK_TIME, cfg.attack);
+        alEffectf(effect, AL_AUTOWAH_RELEASE_TIME, cfg.release);
+        alEffectf(effect, AL_AUTOWAH_RESONANCE, cfg.resonance);
+        alEffectf(effect, AL_AUTOWAH_PEAK_GAIN, cfg.peakgain);
+        alGenAuxiliaryEffectSlots(1, &slot);
+        alAuxiliaryEffectSloti(slot, AL_EFFECTSLOT_EFFECT, static_cast<ALint>(effect));
+        alGenFilters(1, &filter);
+        alFilteri(filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+        alFilterf(filter, AL_LOWPASS_GAIN, 0.0f);
+
+        alGenSources(1, &source);
+        alSourcei(source, AL_BUFFER, static_cast<ALint>(buffer));
+        alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+        alSourcei(source, AL_DIRECT_FILTER, static_cast<ALint>(filter));
+        alSource3i(source, AL_AUXILIARY_SEND_FILTER, static_cast<ALint>(slot), 0,
+            AL_FILTER_NULL);
+        alSourcePlay(source);
+
+        std::vector<float> output(NumFrames*2);
+        loopback.render(output.data(), NumFrames);
+
+        alDeleteSources(1, &source);
+        alDeleteAuxiliaryEffectSlots(1, &slot);
+        alDeleteFilters(1, &filter);
+        alDeleteEffects(1, &effect);
+        alDeleteBuffers(1, &buffer);
+
+        std::vector<float> ref(NumFrames);
+        ReferenceAutowah reference{static_cast<float>(SampleRate), cfg.attack, cfg.release,
+            cfg.resonance, cfg.peakgain};
+        reference.process(sweep.data(), ref.data(), NumFrames);
+
+        double maxerr{-std::numeric_limits<double>::infinity()};
+        for(size_t c{0};c < 2;++c)
+        {
+            double cross{0.0}, refpow{0.0}, outpow{0.0};
+            for(size_t i{MixLen};i < NumFrames;++i)
+            {
+                const double o{output[i*2 + c]}, r{ref[i]};
+                cross += o * r;
+                refpow += r * r;
+                outpow += o * o;
+            }
+            const double scale{(refpow > 0.0) ? cross/refpow : 0.0};
+            double errpow{0.0};
+            for(size_t i{MixLen};i < NumFrames;++i)
+            {
+                const double e{output[i*2 + c] - scale*ref[i]};
+                errpow += e * e;
+            }
+            const double err{(outpow > 0.0 && scale > 0.0) ? 10.0*std::log10(errpow/outpow)
+                : std::numeric_limits<double>::infinity()};
+            maxerr = std::max(maxerr, err);
+        }
+
+        char result[64];
+        snprintf(result, sizeof(result), "err/sig %.1f dB", maxerr);
+        Report("Autowah", cfg.name, result, maxerr <= Tolerance);
+    }
+}
+
+} // namespace
+
+
+bool RunLoopbackChecks(unsigned int seed)
+{
+    gRng.seed(seed);
+
+    const std::string confpath{WriteConfig()};
+    if(confpath.empty())
+        return false;
+    if(!LoadProcs())
+    {
+        fprintf(stderr, "Failed to load the loopback and EFX functions\n");
+        std::remove(confpath.c_str());
+        return false;
+    }
+
+    CheckRetarget();
+    CheckReverbRate();
+    CheckAutowah();
+
+    std::remove(confpath.c_str());
+    return !gFailed;
+}
@@ -0,0 +1,11 @@
+#ifndef UTILS_ALMIXERCHECK_LOOPBACK_H
+#define UTILS_ALMIXERCHECK_LOOPBACK_H
+
+/* Runs the checks that render through the library's loopback devices, using
+ * the given seed for their random input. These are kept separate from the
+ * kernel checks, which build with the library's config.h, since that marks the
+ * AL API functions as the library's own. Returns false if any check failed.
+ */
+bool RunLoopbackChecks(unsigned int seed);
+
+#endif /* UTILS_ALMIXERCHECK_LOOPBACK_H */
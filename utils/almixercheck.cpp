@@ -0,0 +1,1066 @@
+/*
+ * OpenAL Mixer Kernel Check Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Runs every mixer kernel specialization built into the library that the
+ * running CPU supports, on randomized input, and checks that the results
+ * match the plain C reference kernels. The time each kernel takes per output
+ * sample is also reported, to compare the variants on a given CPU.
+ *
+ * The output limiter's fast log/exp approximations are also checked against
+ * libm, and the limiter itself against a libm-based reference. Lastly, a few
+ * behaviors of the library's mixer as a whole are checked by rendering through
+ * loopback devices.
+ *
+ * The process exits with a non-zero status if any check fails.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alcmain.h"
+#include "almalloc.h"
+#include "alu.h"
+#include "bsinc_tables.h"
+#include "cpu_caps.h"
+#include "fastlogexp.h"
+#include "hrtf.h"
+#include "logging.h"
+#include "mastering.h"
+#include "mixer/defs.h"
+#include "vector.h"
+#include "voice.h"
+
+#include "almixercheck-loopback.h"
+
+
+struct CTag;
+struct SSETag;
+struct SSE2Tag;
+struct SSE4Tag;
+struct NEONTag;
+
+struct PointTag;
+struct LerpTag;
+struct CubicTag;
+struct BSincTag;
+struct FastBSincTag;
+struct PolyBSincTag;
+struct FastPolyBSincTag;
+
+
+/* The mixer sources log through these, so provide them here. */
+FILE *gLogFile{stderr};
+LogLevel gLogLevel{LogError};
+
+void al_print(FILE *logfile, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(logfile, fmt, ap);
+    va_end(ap);
+    fflush(logfile);
+}
+
+
+namespace {
+
+using std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+
+/* Number of padding samples kept before the resampler input, which the bsinc
+ * resamplers read behind the current position.
+ */
+constexpr size_t ResamplePrePadding{MAX_RESAMPLER_PADDING/2};
+constexpr size_t MixChannels{8};
+constexpr size_t DirectHrtfChannels{4};
+
+using HrtfMixerFunc = decltype(&MixHrtf_<CTag>);
+using HrtfMixerBlendFunc = decltype(&MixHrtfBlend_<CTag>);
+using HrtfDirectMixerFunc = decltype(&MixDirectHrtf_<CTag>);
+
+size_t gIterations{2000};
+bool gFailed{false};
+std::mt19937 gRng{22222u};
+
+
+template<typename T>
+struct Variant {
+    const char *name;
+    int caps;
+    T func;
+};
+
+bool HasCaps(int caps)
+{ return (CPUCapFlags&caps) == caps; }
+
+void FillRandom(float *data, size_t count, float scale=1.0f)
+{
+    std::uniform_real_distribution<float> dist{-scale, scale};
+    std::generate_n(data, count, [&dist]() -> float { return dist(gRng); });
+}
+
+/* Returns the largest difference between the two sample sets, relative to the
+ * reference's peak (or 1, if the peak is smaller).
+ */
+float RelativeError(const float *ref, const float *test, size_t count)
+{
+    float peak{1.0f}, maxerr{0.0f};
+    for(size_t i{0};i < count;++i)
+    {
+        peak = std::max(peak, std::fabs(ref[i]));
+        maxerr = std::max(maxerr, std::fabs(ref[i] - test[i]));
+    }
+    return maxerr / peak;
+}
+
+void Report(const char *kernel, const std::string &config, const char *variant, double nsps,
+    const float *err, float tolerance)
+{
+    if(!err)
+    {
+        printf("  %-14s %-22s %-6s %9.3f ns/sample   (reference)\n", kernel, config.c_str(),
+            variant, nsps);
+        return;
+    }
+    const bool ok{*err <= tolerance};
+    printf("  %-14s %-22s %-6s %9.3f ns/sample   max err %.3g %s\n", kernel, config.c_str(),
+        variant, nsps, static_cast<double>(*err), ok ? "ok" : "MISMATCH");
+    if(!ok) gFailed = true;
+}
+
+/* Times the given function over the set number of iterations, returning the
+ * nanoseconds per sample for the given number of samples per call.
+ */
+template<typename F>
+double TimeKernel(F&& func, size_t samples)
+{
+    func();
+    const auto start = steady_clock::now();
+    for(size_t i{0};i < gIterations;++i)
+        func();
+    const auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(gIterations*samples);
+}
+
+
+void BsincPrepare(const ALuint increment, BsincState *state, const BSincTable *table)
+{
+    size_t si{BSINC_SCALE_COUNT - 1};
+    float sf{0.0f};
+
+    if(increment > FRACTIONONE)
+    {
+        sf = FRACTIONONE / static_cast<float>(increment);
+        sf = std::max(0.0f, (BSINC_SCALE_COUNT-1) * (sf-table->scaleBase) * table->scaleRange);
+        si = static_cast<size_t>(sf);
+        sf = 1.0f - std::cos(std::asin(sf - static_cast<float>(si)));
+    }
+
+    state->sf = sf;
+    state->m = table->m[si];
+    state->l = (state->m/2) - 1;
+    state->filter = table->Tab + table->filterOffset[si];
+}
+
+void CheckResampler(const char *name, const BSincTable *table,
+    const std::vector<Variant<ResamplerFunc>> &variants, bool fast)
+{
+    static constexpr double Ratios[]{0.5, 44100.0/48000.0, 1.0, 48000.0/44100.0, 2.0, 3.5};
+
+    al::vector<float,16> src((BUFFERSIZE*4) + MAX_RESAMPLER_PADDING);
+    al::vector<float,16> ref(BUFFERSIZE), out(BUFFERSIZE);
+    FillRandom(src.data(), src.size());
+
+    for(const double ratio : Ratios)
+    {
+        const auto increment = static_cast<ALuint>(ratio*FRACTIONONE + 0.5);
+        /* The fast bsinc resamplers are only used when not downsampling. */
+        if(fast && increment > FRACTIONONE)
+            continue;
+
+        InterpState state{};
+        if(table) BsincPrepare(increment, &state.bsinc, table);
+
+        const ALuint frac{static_cast<ALuint>(gRng()) & FRACTIONMASK};
+        const float *in{src.data() + ResamplePrePadding};
+        const std::string config{"x" + std::to_string(ratio).substr(0, 6)};
+
+        auto &refvar = variants.front();
+        const float *res{refvar.func(&state, in, frac, increment, {ref.data(), ref.size()})};
+        if(res != ref.data()) std::copy_n(res, ref.size(), ref.begin());
+        Report(name, config, refvar.name, TimeKernel([&]{
+            refvar.func(&state, in, frac, increment, {ref.data(), ref.size()}); }, BUFFERSIZE),
+            nullptr, 0.0f);
+
+        for(auto iter = variants.begin()+1;iter != variants.end();++iter)
+        {
+            if(!HasCaps(iter->caps)) continue;
+            std::fill(out.begin(), out.end(), 0.0f);
+            res = iter->func(&state, in, frac, increment, {out.data(), out.size()});
+            if(res != out.data()) std::copy_n(res, out.size(), out.begin());
+            const float err{RelativeError(ref.data(), out.data(), out.size())};
+
+            const auto func = iter->func;
+            Report(name, config, iter->name, TimeKernel([&]{
+                func(&state, in, frac, increment, {out.data(), out.size()}); }, BUFFERSIZE),
+                &err, 1e-5f);
+        }
+    }
+}
+
+/* Checks the polyphase bsinc resamplers against the general ones, at ratios
+ * that keep the position on a filter phase, timing both for comparison. The
+ * 44.1kHz<->48kHz ratios are only noted, since they never land on a phase and
+ * get no speedup from the polyphase path.
+ */
+void CheckPolyphase(const char *name, const char *polyname, const BSincTable *table,
+    const std::vector<Variant<ResamplerFunc>> &general,
+    const std::vector<Variant<ResamplerFunc>> &poly, bool fast)
+{
+    static constexpr double Ratios[]{0.5, 0.75, 1.0, 1.5, 2.0};
+    static constexpr ALuint PhaseMask{(1u<<(FRACTIONBITS-BSINC_PHASE_BITS)) - 1};
+
+    al::vector<float,16> src((BUFFERSIZE*4) + MAX_RESAMPLER_PADDING);
+    al::vector<float,16> ref(BUFFERSIZE), out(BUFFERSIZE);
+    FillRandom(src.data(), src.size());
+
+    for(const double ratio : Ratios)
+    {
+        const auto increment = static_cast<ALuint>(ratio*FRACTIONONE + 0.5);
+        if(fast && increment > FRACTIONONE)
+            continue;
+
+        InterpState state{};
+        BsincPrepare(increment, &state.bsinc, table);
+
+        const ALuint frac{static_cast<ALuint>(gRng()) & FRACTIONMASK & ~PhaseMask};
+        const float *in{src.data() + ResamplePrePadding};
+        const std::string config{"x" + std::to_string(ratio).substr(0, 6)};
+
+        auto &refvar = general.front();
+        const float *res{refvar.func(&state, in, frac, increment, {ref.data(), ref.size()})};
+        if(res != ref.data()) std::copy_n(res, ref.size(), ref.begin());
+        Report(name, config, refvar.name, TimeKernel([&]{
+            refvar.func(&state, in, frac, increment, {ref.data(), ref.size()}); }, BUFFERSIZE),
+            nullptr, 0.0f);
+
+        auto check = [&](const char *kernel, const Variant<ResamplerFunc> &var)
+        {
+            if(!HasCaps(var.caps)) return;
+            std::fill(out.begin(), out.end(), 0.0f);
+            res = var.func(&state, in, frac, increment, {out.data(), out.size()});
+            if(res != out.data()) std::copy_n(res, out.size(), out.begin());
+            const float err{RelativeError(ref.data(), out.data(), out.size())};
+
+            const auto func = var.func;
+            Report(kernel, config, var.name, TimeKernel([&]{
+                func(&state, in, frac, increment, {out.data(), out.size()}); }, BUFFERSIZE),
+                &err, 1e-5f);
+        };
+        for(auto iter = general.begin()+1;iter != general.end();++iter)
+            check(name, *iter);
+        for(const auto &var : poly)
+            check(polyname, var);
+    }
+
+    static constexpr double UnalignedRatios[]{44100.0/48000.0, 48000.0/44100.0};
+    for(const double ratio : UnalignedRatios)
+    {
+        const auto increment = static_cast<ALuint>(ratio*FRACTIONONE + 0.5);
+        if(fast && increment > FRACTIONONE)
+            continue;
+        if(!(increment&PhaseMask))
+        {
+            printf("  %-14s x%-21s unexpectedly phase-aligned MISMATCH\n", polyname,
+                std::to_string(ratio).substr(0, 6).c_str());
+            gFailed = true;
+            continue;
+        }
+        printf("  %-14s x%-21s not phase-aligned, uses %s\n", polyname,
+            std::to_string(ratio).substr(0, 6).c_str(), name);
+    }
+}
+
+
+void CheckMix(const std::vector<Variant<MixerFunc>> &variants)
+{
+    struct MixConfig { const char *name; size_t counter; size_t outpos; size_t count; };
+    static constexpr MixConfig Configs[]{
+        {"static", 0, 0, BUFFERSIZE},
+        {"fade full", BUFFERSIZE, 0, BUFFERSIZE},
+        {"fade partial", 300, 0, BUFFERSIZE},
+        {"offset", 64, 256, BUFFERSIZE-256-3},
+    };
+
+    al::vector<float,16> in(BUFFERSIZE);
+    FillRandom(in.data(), in.size());
+
+    for(const MixConfig &cfg : Configs)
+    {
+        std::array<float,MixChannels> startgains, targetgains;
+        FillRandom(startgains.data(), startgains.size());
+        FillRandom(targetgains.data(), targetgains.size());
+        /* Include silent target and already-reached gains. */
+        targetgains[1] = 0.0f;
+        targetgains[2] = startgains[2];
+
+        al::vector<FloatBufferLine,16> init(MixChannels);
+        for(auto &line : init)
+            FillRandom(line.data(), line.size());
+
+        const al::span<const float> input{in.data(), cfg.count};
+        auto run = [&](MixerFunc func, al::vector<FloatBufferLine,16> &outbuf,
+            std::array<float,MixChannels> &gains) -> void
+        {
+            outbuf = init;
+            gains = startgains;
+            func(input, outbuf, gains.data(), targetgains.data(), cfg.counter, cfg.outpos);
+        };
+
+        al::vector<FloatBufferLine,16> refout, testout;
+        std::array<float,MixChannels> refgains, testgains;
+
+        auto &refvar = variants.front();
+        run(refvar.func, refout, refgains);
+        Report("Mix", cfg.name, refvar.name, TimeKernel([&]{
+            testgains = startgains;
+            refvar.func(input, refout, testgains.data(), targetgains.data(), cfg.counter,
+                cfg.outpos);
+        }, cfg.count*MixChannels), nullptr, 0.0f);
+        run(refvar.func, refout, refgains);
+
+        for(auto iter = variants.begin()+1;iter != variants.end();++iter)
+        {
+            if(!HasCaps(iter->caps)) continue;
+            run(iter->func, testout, testgains);
+
+            float err{RelativeError(refgains.data(), testgains.data(), MixChannels)};
+            for(size_t c{0};c < MixChannels;++c)
+                err = std::max(err, RelativeError(refout[c].data(), testout[c].data(),
+                    BUFFERSIZE));
+
+            const auto func = iter->func;
+            Report("Mix", cfg.name, iter->name, TimeKernel([&]{
+                testgains = startgains;
+                func(input, testout, testgains.data(), targetgains.data(), cfg.counter,
+                    cfg.outpos);
+            }, cfg.count*MixChannels), &err, 1e-5f);
+        }
+    }
+}
+
+
+void RandomHrtfFilter(HrirArray &coeffs, std::array<ALuint,2> &delay)
+{
+    FillRandom(&coeffs[0][0], coeffs.size()*2, 0.5f);
+    delay[0] = static_cast<ALuint>(gRng() % (HRTF_HISTORY_LENGTH-1)) + 1;
+    delay[1] = static_cast<ALuint>(gRng() % (HRTF_HISTORY_LENGTH-1)) + 1;
+}
+
+void CheckHrtf(const std::vector<Variant<HrtfMixerFunc>> &variants,
+    const std::vector<Variant<HrtfMixerBlendFunc>> &blendvariants)
+{
+    static constexpr ALuint IrSizes[]{MIN_IR_LENGTH, 32, 64, HRIR_LENGTH};
+
+    al::vector<float,16> in(HRTF_HISTORY_LENGTH + BUFFERSIZE);
+    FillRandom(in.data(), in.size());
+
+    al::vector<float2,16> init(BUFFERSIZE + HRIR_LENGTH);
+    FillRandom(&init[0][0], init.size()*2);
+
+    for(const ALuint irsize : IrSizes)
+    {
+        const std::string config{"ir " + std::to_string(irsize)};
+
+        auto newcoeffs = std::make_unique<HrtfFilter>();
+        MixHrtfFilter newparams{};
+        RandomHrtfFilter(newcoeffs->Coeffs, newcoeffs->Delay);
+        newparams.Coeffs = &newcoeffs->Coeffs;
+        newparams.Delay = newcoeffs->Delay;
+        newparams.Gain = 0.75f;
+        newparams.GainStep = 0.25f / BUFFERSIZE;
+
+        auto oldparams = std::make_unique<HrtfFilter>();
+        RandomHrtfFilter(oldparams->Coeffs, oldparams->Delay);
+        oldparams->Gain = 0.5f;
+
+        al::vector<float2,16> refaccum, testaccum;
+
+        auto &refvar = variants.front();
+        refaccum = init;
+        refvar.func(in.data(), refaccum.data(), irsize, &newparams, BUFFERSIZE);
+        testaccum = init;
+        Report("MixHrtf", config, refvar.name, TimeKernel([&]{
+            refvar.func(in.data(), testaccum.data(), irsize, &newparams, BUFFERSIZE); },
+            BUFFERSIZE), nullptr, 0.0f);
+        for(auto iter = variants.begin()+1;iter != variants.end();++iter)
+        {
+            if(!HasCaps(iter->caps)) continue;
+            testaccum = init;
+            iter->func(in.data(), testaccum.data(), irsize, &newparams, BUFFERSIZE);
+            const float err{RelativeError(&refaccum[0][0], &testaccum[0][0],
+                refaccum.size()*2)};
+
+            const auto func = iter->func;
+            Report("MixHrtf", config, iter->name, TimeKernel([&]{
+                func(in.data(), testaccum.data(), irsize, &newparams, BUFFERSIZE); },
+                BUFFERSIZE), &err, 1e-4f);
+        }
+
+        auto &refblend = blendvariants.front();
+        refaccum = init;
+        refblend.func(in.data(), refaccum.data(), irsize, oldparams.get(), &newparams,
+            BUFFERSIZE);
+        testaccum = init;
+        Report("MixHrtfBlend", config, refblend.name, TimeKernel([&]{
+            refblend.func(in.data(), testaccum.data(), irsize, oldparams.get(), &newparams,
+                BUFFERSIZE);
+        }, BUFFERSIZE), nullptr, 0.0f);
+        for(auto iter = blendvariants.begin()+1;iter != blendvariants.end();++iter)
+        {
+            if(!HasCaps(iter->caps)) continue;
+            testaccum = init;
+            iter->func(in.data(), testaccum.data(), irsize, oldparams.get(), &newparams,
+                BUFFERSIZE);
+            const float err{RelativeError(&refaccum[0][0], &testaccum[0][0],
+                refaccum.size()*2)};
+
+            const auto func = iter->func;
+            Report("MixHrtfBlend", config, iter->name, TimeKernel([&]{
+                func(in.data(), testaccum.data(), irsize, oldparams.get(), &newparams,
+                    BUFFERSIZE);
+            }, BUFFERSIZE), &err, 1e-4f);
+        }
+    }
+}
+
+
+std::unique_ptr<DirectHrtfState> MakeDirectHrtfState(ALuint irsize, std::mt19937::result_type seed)
+{
+    std::unique_ptr<DirectHrtfState> state{
+        new(FamCount(DirectHrtfChannels)) DirectHrtfState{DirectHrtfChannels}};
+
+    /* Use a fixed seed so each variant gets an identical starting state. */
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<float> dist{-0.5f, 0.5f};
+    state->mIrSize = irsize;
+    for(auto &chan : state->mChannels)
+    {
+        std::generate(chan.mDelay.begin(), chan.mDelay.end(), [&]{ return dist(rng); });
+        chan.mSplitter.init(400.0f / 48000.0f);
+        chan.mHfScale = 0.5f + dist(rng);
+        std::generate_n(&chan.mCoeffs[0][0], chan.mCoeffs.size()*2, [&]{ return dist(rng); });
+    }
+    return state;
+}
+
+void CheckDirectHrtf(const std::vector<Variant<HrtfDirectMixerFunc>> &variants)
+{
+    static constexpr ALuint IrSizes[]{32, HRIR_LENGTH};
+    constexpr size_t AccumSize{BUFFERSIZE + HRIR_LENGTH + HRTF_DIRECT_DELAY};
+
+    al::vector<FloatBufferLine,16> in(DirectHrtfChannels);
+    for(auto &line : in)
+        FillRandom(line.data(), line.size());
+
+    FloatBufferLine leftinit, rightinit;
+    FillRandom(leftinit.data(), leftinit.size());
+    FillRandom(rightinit.data(), rightinit.size());
+
+    al::vector<float2,16> accuminit(AccumSize);
+    FillRandom(&accuminit[0][0], accuminit.size()*2);
+
+    for(const ALuint irsize : IrSizes)
+    {
+        const std::string config{"ir " + std::to_string(irsize)};
+        const auto seed = static_cast<std::mt19937::result_type>(gRng());
+
+        struct Output {
+            std::unique_ptr<DirectHrtfState> state;
+            FloatBufferLine left, right;
+            al::vector<float2,16> accum;
+        };
+        auto run = [&](HrtfDirectMixerFunc func, Output &out) -> void
+        {
+            out.state = MakeDirectHrtfState(irsize, seed);
+            out.left = leftinit;
+            out.right = rightinit;
+            out.accum = accuminit;
+            func(out.left, out.right, in, out.accum.data(), out.state.get(), BUFFERSIZE);
+        };
+
+        auto refout = std::make_unique<Output>();
+        auto testout = std::make_unique<Output>();
+
+        auto &refvar = variants.front();
+        run(refvar.func, *refout);
+        run(refvar.func, *testout);
+        Report("MixDirectHrtf", config, refvar.name, TimeKernel([&]{
+            refvar.func(testout->left, testout->right, in, testout->accum.data(),
+                testout->state.get(), BUFFERSIZE);
+        }, BUFFERSIZE*DirectHrtfChannels), nullptr, 0.0f);
+
+        for(auto iter = variants.begin()+1;iter != variants.end();++iter)
+        {
+            if(!HasCaps(iter->caps)) continue;
+            run(iter->func, *testout);
+            float err{RelativeError(refout->left.data(), testout->left.data(), BUFFERSIZE)};
+            err = std::max(err, RelativeError(refout->right.data(), testout->right.data(),
+                BUFFERSIZE));
+            err = std::max(err, RelativeError(&refout->accum[0][0], &testout->accum[0][0],
+                AccumSize*2));
+
+            const auto func = iter->func;
+            Report("MixDirectHrtf", config, iter->name, TimeKernel([&]{
+                func(testout->left, testout->right, in, testout->accum.data(),
+                    testout->state.get(), BUFFERSIZE);
+            }, BUFFERSIZE*DirectHrtfChannels), &err, 1e-4f);
+        }
+    }
+}
+
+
+/* Checks the limiter's log/exp approximations against libm in double
+ * precision, over the range of values the limiter gives them. The log's error
+ * is absolute for results within +/-1 and relative beyond, and the exp's is
+ * relative.
+ */
+void CheckLogExp()
+{
+    constexpr size_t NumValues{BUFFERSIZE*4};
+
+    struct Approx {
+        const char *name;
+        float lower, upper;
+        bool relative;
+        float (*scalar)(float);
+#ifdef HAVE_SSE_INTRINSICS
+        __m128 (*sse)(__m128);
+#endif
+        float tolerance;
+    };
+    static const Approx Funcs[]{
+        /* Peaks are clamped to -120dB, and the mix can go well above 0dB. */
+        {"fast_log", 0.000001f, 10000.0f, false, fast_log,
+#ifdef HAVE_SSE_INTRINSICS
+            fast_log4,
+#endif
+            2e-7f},
+        /* Attack and release coefficients are exp(-1/t) for t >= 1, and gains
+         * are converted from far below -120dB up to the make-up gain.
+         */
+        {"fast_exp", -40.0f, 10.0f, true, fast_exp,
+#ifdef HAVE_SSE_INTRINSICS
+            fast_exp4,
+#endif
+            3e-7f},
+    };
+
+    for(const Approx &func : Funcs)
+    {
+        /* Sweep the range evenly (logarithmically for the log), with every
+         * other value randomized.
+         */
+        std::uniform_real_distribution<float> dist{0.0f, 1.0f};
+        al::vector<float,16> in(NumValues), ref(NumValues), out(NumValues);
+        for(size_t i{0};i < NumValues;++i)
+        {
+            const float t{(i&1) ? static_cast<float>(i) / static_cast<float>(NumValues-1)
+                : dist(gRng)};
+            in[i] = func.relative ? func.lower + (func.upper-func.lower)*t
+                : func.lower * std::pow(func.upper/func.lower, t);
+        }
+
+        auto measure = [&in,&func](const float *test) -> float
+        {
+            double maxerr{0.0};
+            for(size_t i{0};i < NumValues;++i)
+            {
+                const double x{in[i]};
+                const double r{func.relative ? std::exp(x) : std::log(x)};
+                const double err{std::fabs(r - static_cast<double>(test[i]))};
+                maxerr = std::max(maxerr, func.relative ? err/r : err/std::max(1.0, std::fabs(r)));
+            }
+            return static_cast<float>(maxerr);
+        };
+
+        char config[32];
+        snprintf(config, sizeof(config), "%g to %g", static_cast<double>(func.lower),
+            static_cast<double>(func.upper));
+
+        auto run_libm = [&func,&in,&ref]() -> void
+        {
+            if(func.relative)
+                std::transform(in.begin(), in.end(), ref.begin(),
+                    [](const float x) -> float { return std::exp(x); });
+            else
+                std::transform(in.begin(), in.end(), ref.begin(),
+                    [](const float x) -> float { return std::log(x); });
+        };
+        Report(func.name, config, "libm", TimeKernel(run_libm, NumValues), nullptr, 0.0f);
+
+        auto run_scalar = [&func,&in,&out]() -> void
+        { std::transform(in.begin(), in.end(), out.begin(), func.scalar); };
+        run_scalar();
+        const float err{measure(out.data())};
+        Report(func.name, config, "C", TimeKernel(run_scalar, NumValues), &err,
+            func.tolerance);
+
+#ifdef HAVE_SSE_INTRINSICS
+        if(HasCaps(CPU_CAP_SSE2))
+        {
+            auto run_sse = [&func,&in,&out]() -> void
+            {
+                for(size_t i{0};i < NumValues;i += 4)
+                    _mm_store_ps(&out[i], func.sse(_mm_load_ps(&in[i])));
+            };
+            std::fill(out.begin(), out.end(), 0.0f);
+            run_sse();
+            const float sseerr{measure(out.data())};
+            Report(func.name, config, "SSE2", TimeKernel(run_sse, NumValues), &sseerr,
+                func.tolerance);
+        }
+#endif
+    }
+}
+
+
+/* The limiter as it was before its log/exp passes were approximated and taken
+ * out of the per-sample loop, using libm for each sample. It takes its
+ * settings from a Compressor created with the same parameters.
+ */
+class ReferenceLimiter {
+    const Compressor &mComp;
+    const size_t mHoldLength;
+
+    al::vector<float> mHold;
+    size_t mHoldPos{0};
+    al::vector<FloatBufferLine,16> mDelay;
+
+    float mSideChain[2*BUFFERSIZE]{};
+    float mCrestFactor[BUFFERSIZE]{};
+    float mLastPeakSq{0.0f};
+    float mLastRmsSq{0.0f};
+    float mLastRelease{0.0f};
+    float mLastAttack{0.0f};
+    float mLastGainDev{0.0f};
+
+public:
+    ReferenceLimiter(const Compressor &comp, size_t holdlength)
+      : mComp{comp}, mHoldLength{(comp.mLookAhead > 0 && holdlength > 1) ? holdlength : 0}
+      , mHold(mHoldLength, -std::numeric_limits<float>::infinity())
+      , mDelay(comp.mLookAhead > 0 ? comp.mNumChans : 0)
+    {
+        for(auto &line : mDelay)
+            line.fill(0.0f);
+    }
+
+    void process(const ALuint SamplesToDo, FloatBufferLine *OutBuffer)
+    {
+        const size_t numChans{mComp.mNumChans};
+        const ALuint lookAhead{mComp.mLookAhead};
+        float *side{mSideChain + lookAhead};
+
+        for(size_t c{0};c < numChans;++c)
+            std::transform(OutBuffer[c].begin(), OutBuffer[c].begin()+SamplesToDo,
+                OutBuffer[c].begin(), [this](float s) { return s * mComp.mPreGain; });
+
+        std::fill_n(side, SamplesToDo, 0.0f);
+        for(size_t c{0};c < numChans;++c)
+        {
+            for(ALuint i{0};i < SamplesToDo;++i)
+                side[i] = std::max(side[i], std::fabs(OutBuffer[c][i]));
+        }
+
+        if(mComp.mAuto.Attack || mComp.mAuto.Release)
+        {
+            const float a_crest{mComp.mCrestCoeff};
+            for(ALuint i{0};i < SamplesToDo;++i)
+            {
+                const float x2{clampf(side[i] * side[i], 0.000001f, 1000000.0f)};
+                mLastPeakSq = std::max(x2, lerp(x2, mLastPeakSq, a_crest));
+                mLastRmsSq = lerp(x2, mLastRmsSq, a_crest);
+                mCrestFactor[i] = mLastPeakSq / mLastRmsSq;
+            }
+        }
+
+        for(ALuint i{0};i < SamplesToDo;++i)
+        {
+            const float x_G{std::log(std::max(0.000001f, side[i]))};
+            if(mHoldLength == 0)
+                side[i] = x_G;
+            else
+            {
+                mHold[mHoldPos] = x_G;
+                mHoldPos = (mHoldPos+1) % mHoldLength;
+                side[i] = *std::max_element(mHold.begin(), mHold.end());
+            }
+        }
+
+        const float threshold{mComp.mThreshold};
+        const float slope{mComp.mSlope};
+        const float attack{mComp.mAttack};
+        const float release{mComp.mRelease};
+        const float c_est{mComp.mGainEstimate};
+        const float a_adp{mComp.mAdaptCoeff};
+        float postGain{mComp.mPostGain};
+        float knee{mComp.mKnee};
+        float t_att{attack};
+        float t_rel{release - attack};
+        float a_att{std::exp(-1.0f / t_att)};
+        float a_rel{std::exp(-1.0f / t_rel)};
+        float y_1{mLastRelease};
+        float y_L{mLastAttack};
+        float c_dev{mLastGainDev};
+        for(ALuint i{0};i < SamplesToDo;++i)
+        {
+            if(mComp.mAuto.Knee)
+                knee = std::max(0.0f, 2.5f * (c_dev + c_est));
+            const float knee_h{0.5f * knee};
+
+            const float x_over{mSideChain[i+lookAhead] - threshold};
+            const float y_G{
+                (x_over <= -knee_h) ? 0.0f :
+                (std::fabs(x_over) < knee_h) ? (x_over + knee_h) * (x_over + knee_h) / (2.0f * knee) :
+                x_over};
+
+            const float y2_crest{mCrestFactor[i]};
+            if(mComp.mAuto.Attack)
+            {
+                t_att = 2.0f*attack/y2_crest;
+                a_att = std::exp(-1.0f / t_att);
+            }
+            if(mComp.mAuto.Release)
+            {
+                t_rel = 2.0f*release/y2_crest - t_att;
+                a_rel = std::exp(-1.0f / t_rel);
+            }
+
+            const float x_L{-slope * y_G};
+            y_1 = std::max(x_L, lerp(x_L, y_1, a_rel));
+            y_L = lerp(y_1, y_L, a_att);
+
+            c_dev = lerp(-(y_L+c_est), c_dev, a_adp);
+            if(mComp.mAuto.PostGain)
+            {
+                if(mComp.mAuto.Declip)
+                    c_dev = std::max(c_dev, mSideChain[i] - y_L - threshold - c_est);
+                postGain = -(c_dev + c_est);
+            }
+
+            mSideChain[i] = std::exp(postGain - y_L);
+        }
+        mLastRelease = y_1;
+        mLastAttack = y_L;
+        mLastGainDev = c_dev;
+
+        for(size_t c{0};c < mDelay.size();++c)
+        {
+            /* Swap the last lookAhead samples out with the delayed ones. */
+            float *inout{OutBuffer[c].data()};
+            float *delaybuf{mDelay[c].data()};
+            al::vector<float> temp(inout, inout+SamplesToDo);
+            for(ALuint i{0};i < SamplesToDo;++i)
+                inout[i] = (i < lookAhead) ? delaybuf[i] : temp[i-lookAhead];
+            if(SamplesToDo >= lookAhead)
+                std::copy_n(temp.end()-lookAhead, lookAhead, delaybuf);
+            else
+            {
+                std::copy(delaybuf+SamplesToDo, delaybuf+lookAhead, delaybuf);
+                std::copy(temp.begin(), temp.end(), delaybuf+lookAhead-SamplesToDo);
+            }
+        }
+
+        for(size_t c{0};c < numChans;++c)
+        {
+            for(ALuint i{0};i < SamplesToDo;++i)
+                OutBuffer[c][i] *= mSideChain[i];
+        }
+
+        std::copy_n(mSideChain+SamplesToDo, lookAhead, mSideChain);
+    }
+};
+
+/* Runs the limiter over a signal that goes well over its threshold in bursts,
+ * with varying update sizes, and compares it to the libm-based reference.
+ */
+void CheckLimiter()
+{
+    struct LimiterConfig {
+        const char *name;
+        bool autoKnee, autoAttack, autoRelease, autoPostGain, autoDeclip;
+        float lookAhead, hold;
+        float preGainDb, postGainDb, thresholdDb, ratio, kneeDb;
+        float attack, release;
+    };
+    static constexpr LimiterConfig Configs[]{
+        /* The device's output limiter. */
+        {"device limiter", true, true, true, true, true, 0.001f, 0.002f, 0.0f, 0.0f, -0.1f,
+            std::numeric_limits<float>::infinity(), 0.0f, 0.02f, 0.2f},
+        {"fixed compressor", false, false, false, false, false, 0.0f, 0.0f, 6.0f, 3.0f,
+            -12.0f, 4.0f, 6.0f, 0.005f, 0.1f},
+    };
+    static const std::array<ALuint,5> UpdateSizes{{BUFFERSIZE, 333, 64, 1, 511}};
+    constexpr float SampleRate{48000.0f};
+    constexpr size_t NumChans{MixChannels};
+    constexpr size_t NumSamples{48000};
+
+    /* Noise with a slow envelope peaking at about +12dB. */
+    al::vector<al::vector<float>> input(NumChans);
+    for(auto &chan : input)
+    {
+        chan.resize(NumSamples);
+        FillRandom(chan.data(), chan.size());
+        for(size_t i{0};i < NumSamples;++i)
+        {
+            const double env{std::sin(static_cast<double>(i) * 3.0 / SampleRate * 6.283185307)};
+            chan[i] *= static_cast<float>(0.05 + 4.0*env*env);
+        }
+    }
+
+    for(const LimiterConfig &cfg : Configs)
+    {
+        auto create = [&cfg]()
+        {
+            return Compressor::Create(NumChans, SampleRate, cfg.autoKnee, cfg.autoAttack,
+                cfg.autoRelease, cfg.autoPostGain, cfg.autoDeclip, cfg.lookAhead, cfg.hold,
+                cfg.preGainDb, cfg.postGainDb, cfg.thresholdDb, cfg.ratio, cfg.kneeDb,
+                cfg.attack, cfg.release);
+        };
+        /* Mirror how the compressor turns the hold time into samples. */
+        const auto holdlength = static_cast<size_t>(clampf(std::round(cfg.hold*SampleRate),
+            0.0f, BUFFERSIZE-1));
+
+        auto render = [&input](auto &limiter, al::vector<float> &output) -> void
+        {
+            al::vector<FloatBufferLine,16> buffer(NumChans);
+            output.resize(NumSamples*NumChans);
+            size_t pos{0}, sizeidx{0};
+            while(pos < NumSamples)
+            {
+                const ALuint todo{static_cast<ALuint>(std::min<size_t>(NumSamples-pos,
+                    UpdateSizes[sizeidx++ % UpdateSizes.size()]))};
+                for(size_t c{0};c < NumChans;++c)
+                    std::copy_n(input[c].begin()+static_cast<ptrdiff_t>(pos), todo,
+                        buffer[c].begin());
+                limiter.process(todo, buffer.data());
+                for(size_t c{0};c < NumChans;++c)
+                    std::copy_n(buffer[c].begin(), todo, output.begin() +
+                        static_cast<ptrdiff_t>(c*NumSamples + pos));
+                pos += todo;
+            }
+        };
+
+        al::vector<float> refout, testout;
+        auto reflimiter = create();
+        ReferenceLimiter reference{*reflimiter, holdlength};
+        render(reference, refout);
+
+        auto limiter = create();
+        render(*limiter, testout);
+        const float err{RelativeError(refout.data(), testout.data(), refout.size())};
+
+        /* Time single full updates. */
+        al::vector<FloatBufferLine,16> buffer(NumChans);
+        auto load_block = [&input,&buffer]() -> void
+        {
+            for(size_t c{0};c < NumChans;++c)
+                std::copy_n(input[c].begin(), BUFFERSIZE, buffer[c].begin());
+        };
+        Report("Limiter", cfg.name, "libm", TimeKernel([&]{
+            load_block(); reference.process(BUFFERSIZE, buffer.data()); }, BUFFERSIZE),
+            nullptr, 0.0f);
+        Report("Limiter", cfg.name, "fast", TimeKernel([&]{
+            load_block(); limiter->process(BUFFERSIZE, buffer.data()); }, BUFFERSIZE),
+            &err, 1e-5f);
+    }
+}
+
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+    int capfilter{~0};
+
+    for(int i{1};i < argc;++i)
+    {
+        if(std::strcmp(argv[i], "-iterations") == 0 && i+1 < argc)
+        {
+            const long val{std::strtol(argv[++i], nullptr, 0)};
+            gIterations = static_cast<size_t>(std::max(val, 1l));
+        }
+        else if(std::strcmp(argv[i], "-seed") == 0 && i+1 < argc)
+            gRng.seed(static_cast<std::mt19937::result_type>(std::strtoul(argv[++i], nullptr, 0)));
+        else if(std::strcmp(argv[i], "-nosimd") == 0)
+            capfilter = 0;
+        else
+        {
+            printf("Usage: %s [-iterations <n>] [-seed <n>] [-nosimd]\n\n"
+                "Checks each CPU-specific mixer kernel against the C reference on random\n"
+                "input, and the output limiter against libm, and reports the time taken\n"
+                "per sample. Then checks the library's mixer as a whole, by rendering\n"
+                "through loopback devices.\n", argv[0]);
+            return (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0)
+                ? 0 : 1;
+        }
+    }
+
+    FillCPUCaps(capfilter);
+    printf("CPU extensions:%s%s%s%s%s%s\n\n",
+        (CPUCapFlags&CPU_CAP_SSE) ? " SSE" : "",
+        (CPUCapFlags&CPU_CAP_SSE2) ? " SSE2" : "",
+        (CPUCapFlags&CPU_CAP_SSE3) ? " SSE3" : "",
+        (CPUCapFlags&CPU_CAP_SSE4_1) ? " SSE4.1" : "",
+        (CPUCapFlags&CPU_CAP_NEON) ? " Neon" : "",
+        CPUCapFlags ? "" : " -none-");
+
+    CheckResampler("Point", nullptr, {{"C", 0, Resample_<PointTag,CTag>}}, false);
+    CheckResampler("Cubic", nullptr, {{"C", 0, Resample_<CubicTag,CTag>}}, false);
+    CheckResampler("Linear", nullptr, {
+        {"C", 0, Resample_<LerpTag,CTag>},
+#ifdef HAVE_SSE2
+        {"SSE2", CPU_CAP_SSE2, Resample_<LerpTag,SSE2Tag>},
+#endif
+#ifdef HAVE_SSE4_1
+        {"SSE4.1", CPU_CAP_SSE4_1, Resample_<LerpTag,SSE4Tag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, Resample_<LerpTag,NEONTag>},
+#endif
+    }, false);
+
+    const std::vector<Variant<ResamplerFunc>> bsinc{
+        {"C", 0, Resample_<BSincTag,CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, Resample_<BSincTag,SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, Resample_<BSincTag,NEONTag>},
+#endif
+    };
+    const std::vector<Variant<ResamplerFunc>> fastbsinc{
+        {"C", 0, Resample_<FastBSincTag,CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, Resample_<FastBSincTag,SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, Resample_<FastBSincTag,NEONTag>},
+#endif
+    };
+    CheckResampler("BSinc12", &bsinc12, bsinc, false);
+    CheckResampler("FastBSinc12", &bsinc12, fastbsinc, true);
+    CheckResampler("BSinc24", &bsinc24, bsinc, false);
+    CheckResampler("FastBSinc24", &bsinc24, fastbsinc, true);
+
+    const std::vector<Variant<ResamplerFunc>> polybsinc{
+        {"C", 0, Resample_<PolyBSincTag,CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, Resample_<PolyBSincTag,SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, Resample_<PolyBSincTag,NEONTag>},
+#endif
+    };
+    const std::vector<Variant<ResamplerFunc>> fastpolybsinc{
+        {"C", 0, Resample_<FastPolyBSincTag,CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, Resample_<FastPolyBSincTag,SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, Resample_<FastPolyBSincTag,NEONTag>},
+#endif
+    };
+    CheckPolyphase("BSinc12", "PolyBSinc12", &bsinc12, bsinc, polybsinc, false);
+    CheckPolyphase("FastBSinc12", "FastPolyBSinc12", &bsinc12, fastbsinc, fastpolybsinc, true);
+    CheckPolyphase("BSinc24", "PolyBSinc24", &bsinc24, bsinc, polybsinc, false);
+    CheckPolyphase("FastBSinc24", "FastPolyBSinc24", &bsinc24, fastbsinc, fastpolybsinc, true);
+
+    CheckMix({
+        {"C", 0, Mix_<CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, Mix_<SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, Mix_<NEONTag>},
+#endif
+    });
+
+    CheckHrtf({
+        {"C", 0, MixHrtf_<CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, MixHrtf_<SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, MixHrtf_<NEONTag>},
+#endif
+    }, {
+        {"C", 0, MixHrtfBlend_<CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, MixHrtfBlend_<SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, MixHrtfBlend_<NEONTag>},
+#endif
+    });
+
+    CheckDirectHrtf({
+        {"C", 0, MixDirectHrtf_<CTag>},
+#ifdef HAVE_SSE
+        {"SSE", CPU_CAP_SSE, MixDirectHrtf_<SSETag>},
+#endif
+#ifdef HAVE_NEON
+        {"Neon", CPU_CAP_NEON, MixDirectHrtf_<NEONTag>},
+#endif
+    });
+
+    CheckLogExp();
+    CheckLimiter();
+
+    printf("\n");
+    fflush(stdout);
+    if(!RunLoopbackChecks(static_cast<unsigned int>(gRng())))
+        gFailed = true;
+
+    if(gFailed)
+    {
+        printf("\nSome checks failed!\n");
+        return 1;
+    }
+    printf("\nAll checks passed.\n");
+    return 0;
+}
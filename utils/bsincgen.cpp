@@ -0,0 +1,91 @@
+/*
+ * OpenAL bsinc Table Generator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Calculates the bsinc resampler coefficient tables and writes them out as
+ * C++ source, so the library doesn't need to calculate them when it's loaded.
+ * This is run on the build host as part of the build.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "bsinc_gen.h"
+
+
+namespace {
+
+template<size_t N>
+bool WriteTable(FILE *f, const char *name, const std::array<float,N> &table)
+{
+    fprintf(f, "alignas(16) constexpr float %s[%zu]{\n", name, N);
+    for(size_t i{0};i < N;++i)
+    {
+        /* Enough digits for each value to convert back to the same float.
+         * Make sure it's written as a floating-point literal, too, so -0
+         * keeps its sign.
+         */
+        char str[32];
+        snprintf(str, sizeof(str), "%.*g", std::numeric_limits<float>::max_digits10,
+            static_cast<double>(table[i]));
+        fprintf(f, "%s%s%sf,", (i%6) ? " " : "    ", str, strpbrk(str, ".e") ? "" : ".0");
+        if((i%6) == 5 || i == N-1)
+            fputc('\n', f);
+    }
+    fprintf(f, "};\n");
+    return !ferror(f);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace bsincgen;
+
+    if(argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <output file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f{fopen(argv[1], "w")};
+    if(!f)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(f, "/* Generated by bsincgen, do not edit! */\n\n");
+    bool ok{WriteTable(f, "bsinc12_table",
+        GenerateBSincCoeffs<bsinc12_hdr.total_size>(bsinc12_hdr))};
+    fprintf(f, "\n");
+    ok = ok && WriteTable(f, "bsinc24_table",
+        GenerateBSincCoeffs<bsinc24_hdr.total_size>(bsinc24_hdr));
+
+    if(fclose(f) != 0 || !ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[1]);
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}